@@ -0,0 +1,8 @@
+enum class AggregateFunction
+{
+	COUNT,
+	SUM,
+	MIN,
+	MAX,
+	AVG
+};
\ No newline at end of file
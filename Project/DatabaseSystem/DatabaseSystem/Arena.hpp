@@ -0,0 +1,58 @@
+#pragma once
+#include<memory_resource>
+
+/**
+ * @brief Descriptor of the memory arena of one statement. Everything allocated while executing the
+ * statement (the values of the records read from the pages and their copies) comes from a buffer that
+ * grows monotonically and is released at once when the arena is destroyed. A pool on top of the buffer
+ * hands freed blocks back out, so a scan over many pages does not keep growing the buffer.
+*/
+class Arena
+{
+public:
+	Arena(size_t initialSize = 64 * 1024) : fBuffer(initialSize), fPool(&fBuffer) {}
+
+	Arena(const Arena& other) = delete;
+	Arena& operator=(const Arena& other) = delete;
+
+	std::pmr::memory_resource* getResource() { return &fPool; }
+
+	/**
+	 * @return the resource of the arena active on this thread, or the global heap if there is none
+	*/
+	static std::pmr::memory_resource* current()
+	{
+		return fActive ? fActive->getResource() : std::pmr::new_delete_resource();
+	}
+
+private:
+	friend class ArenaScope;
+
+	std::pmr::monotonic_buffer_resource fBuffer;
+	std::pmr::unsynchronized_pool_resource fPool;
+
+	static inline thread_local Arena* fActive = nullptr;
+};
+
+/**
+ * @brief Makes an arena the active one on this thread for the duration of a statement
+*/
+class ArenaScope
+{
+public:
+	ArenaScope(Arena& arena) : fPrevious(Arena::fActive)
+	{
+		Arena::fActive = &arena;
+	}
+
+	~ArenaScope()
+	{
+		Arena::fActive = fPrevious;
+	}
+
+	ArenaScope(const ArenaScope& other) = delete;
+	ArenaScope& operator=(const ArenaScope& other) = delete;
+
+private:
+	Arena* fPrevious;
+};
@@ -60,6 +60,9 @@ public:
 			clear(root);
 			if (other.fSize != 0)
 				root = copy(other.root);
+
+			fOrder = other.fOrder;
+			fSize = other.fSize;
 		}
 
 		return *this;
@@ -84,11 +87,11 @@ public:
 		return *this;
 	}
 
-	BPTree(ifstream& in)
+	BPTree(BinaryReader& in)
 	{
 		root = nullptr;
-		in.read((char*)&fOrder, sizeof(fOrder));
-		in.read((char*)&fSize, sizeof(fSize));
+		in.read(fOrder);
+		in.read(fSize);
 		size_t tmpSize = fSize;
 		for (size_t i = 0; i < tmpSize; i++)
 			this->insert({ TypeWrapper(in), RecordPtr(in) });
@@ -104,12 +107,22 @@ public:
 		return target->fKeys[target->keyIndex(key)].second;
 	}
 
+	/**
+	 * @brief Probe the index for a key, without touching the pages of the table
+	 * @param key - key to be searched for
+	 * @return True if a record with this key is in the tree
+	*/
+	bool contains(const TypeWrapper& key) const
+	{
+		return search(key) != nullptr;
+	}
+
 	/**
 	 * @brief Searches the tree for given key
 	 * @param key - key to be searched for
 	 * @return the node containing the key, nullptr otherwise
 	*/
-	Node* search(const TypeWrapper& key)
+	Node* search(const TypeWrapper& key) const
 	{
 		if (root == nullptr)
 			return nullptr;
@@ -510,15 +523,100 @@ public:
 	size_t size() const { return this->fSize; }
 
 	/**
-	 * @brief Write the tree to file, just the elements in root-left-right way
-	 * @param out - output stream
+	 * @return the elements of the leaves from left to right, i.e. in ascending order of their keys, following the links between the leaves
+	*/
+	vector<const data*> getSortedElements() const
+	{
+		vector<const data*> elements;
+		elements.reserve(fSize);
+		for (Node* cursor = leftmostLeaf(); cursor; cursor = cursor->ptr[cursor->fKeys.size()])
+			for (const data& element : cursor->fKeys)
+				elements.push_back(&element);
+
+		return elements;
+	}
+
+	/**
+	 * @brief Count the keys in a range and find the smallest and the largest of them from the leaves alone.
+	 * Without bounds the count is the size of the tree and only the leftmost and the rightmost leaves are visited,
+	 * otherwise the leaves are walked from the lower bound to the upper one.
+	 * @param low - the lower bound, nullptr for none
+	 * @param lowInclusive - whether a key equal to the lower bound is in the range
+	 * @param high - the upper bound, nullptr for none
+	 * @param highInclusive - whether a key equal to the upper bound is in the range
+	 * @param first - set to the smallest element in the range, nullptr if the range is empty
+	 * @param last - set to the largest element in the range, nullptr if the range is empty
+	 * @return the number of keys in the range
+	*/
+	size_t summarizeRange(const TypeWrapper* low, bool lowInclusive, const TypeWrapper* high, bool highInclusive,
+		const data*& first, const data*& last) const
+	{
+		first = last = nullptr;
+		if (!root)
+			return 0;
+
+		if (!low && !high)
+		{
+			Node* leftmost = nextNonEmptyLeaf(leftmostLeaf());
+			Node* rightmost = root;
+			while (!rightmost->fIsLeaf)
+				rightmost = rightmost->ptr[rightmost->fKeys.size()];
+
+			if (!leftmost)
+				return 0;
+
+			first = &leftmost->fKeys.front();
+			last = rightmost->fKeys.empty() ? nullptr : &rightmost->fKeys.back();
+			if (!last)
+			{
+				// The rightmost leaf was emptied by a removal, the largest key is in one of the leaves before it
+				for (Node* cursor = leftmost; cursor; cursor = nextNonEmptyLeaf(cursor->ptr[cursor->fKeys.size()]))
+					last = &cursor->fKeys.back();
+			}
+
+			return fSize;
+		}
+
+		Node* cursor = low ? leafOf(*low) : leftmostLeaf();
+		size_t count = 0;
+		for (; cursor; cursor = cursor->ptr[cursor->fKeys.size()])
+		{
+			for (const data& element : cursor->fKeys)
+			{
+				if (low && (element.first < *low || (!lowInclusive && element.first == *low)))
+					continue;
+				if (high && (*high < element.first || (!highInclusive && element.first == *high)))
+					return count;
+
+				if (!first)
+					first = &element;
+				last = &element;
+				count++;
+			}
+		}
+
+		return count;
+	}
+
+	/**
+	 * @brief Write the tree to file, just the elements of the leaves from left to right. The inner nodes may still hold
+	 * keys that were removed from the leaves, so they are not written - the count of the written elements must match
+	 * exactly, since the table metadata continues after the tree
+	 * @param out - the buffer of the file
 	*/
-	void write(ofstream& out)
+	void write(BinaryWriter& out)
 	{
-		set<TypeWrapper> visited;
-		out.write((char*)&fOrder, sizeof(fOrder));
-		out.write((char*)&fSize, sizeof(fSize));
-		writeRec(root, out, visited);
+		vector<const data*> elements;
+		collectLeaves(root, elements);
+
+		size_t count = elements.size();
+		out.write(fOrder);
+		out.write(count);
+		for (const data* element : elements)
+		{
+			element->first.write(out);
+			element->second.write(out);
+		}
 	}
 
 private:
@@ -567,14 +665,12 @@ private:
 			virtualKvp.insert(virtualKvp.begin() + i, kvp); // insert new key
 			virtualPtr.insert(virtualPtr.begin() + i + 1, child); // insert the element from the previous iteration
 
-			// We are halving the keys and pointers of cursor, because we are splitting it
-			int k = cursor->ptr.size() - 1;
-			while (cursor->fKeys.size() != (fOrder + 1) / 2)
-			{
-				cursor->fKeys.pop_back();
-				cursor->ptr[k] = nullptr;
-				k--;
-			}
+			// We are halving the keys and pointers of cursor, because we are splitting it.
+			// The new key may belong to the left half, so both halves are taken from the virtual node
+			size_t cursorKeysSize = (fOrder + 1) / 2;
+			cursor->fKeys.assign(virtualKvp.begin(), virtualKvp.begin() + cursorKeysSize);
+			for (size_t j = 0; j < cursor->ptr.size(); j++)
+				cursor->ptr[j] = j <= cursorKeysSize ? virtualPtr[j] : nullptr;
 
 			// Since we dont need repeating elements in the internal nodes, we skip the first key here by saying fOrder + 1 - (fOrder+1)/2 - 1
 			size_t newInternalKeysSize = fOrder - (fOrder + 1) / 2;
@@ -893,29 +989,66 @@ private:
 		}
 	}
 
+	/**
+	 * @return the leftmost leaf of the tree, nullptr if the tree is empty
+	*/
+	Node* leftmostLeaf() const
+	{
+		Node* cursor = root;
+		while (cursor && !cursor->fIsLeaf)
+			cursor = cursor->ptr[0];
+
+		return cursor;
+	}
+
+	/**
+	 * @return the leaf in which a key is or would be inserted
+	*/
+	Node* leafOf(const TypeWrapper& key) const
+	{
+		Node* cursor = root;
+		while (cursor && !cursor->fIsLeaf)
+		{
+			size_t i = 0;
+			while (i < cursor->fKeys.size() && !(key < cursor->fKeys[i].first))
+				i++;
+
+			cursor = cursor->ptr[i];
+		}
+
+		return cursor;
+	}
+
+	/**
+	 * @return the first leaf with keys, starting from the given one and following the links between the leaves
+	*/
+	Node* nextNonEmptyLeaf(Node* cursor) const
+	{
+		while (cursor && cursor->fKeys.empty())
+			cursor = cursor->ptr[cursor->fKeys.size()];
+
+		return cursor;
+	}
+
 	/**
 	 * @brief Used in writing the tree to file
 	 * @param cursor - begining of the subTree
-	 * @param out - output stream
-	 * @param visitedKeys - set of all the keys that have been written already
+	 * @param elements - the elements of the leaves of the subtree are appended here, from left to right
 	*/
-	void writeRec(Node* cursor, ofstream& out, set<TypeWrapper>& visitedKeys)
+	void collectLeaves(Node* cursor, vector<const data*>& elements) const
 	{
-		if (cursor) {
-			for (int i = 0; i < cursor->fKeys.size(); i++)
-			{
-				if (visitedKeys.find(cursor->fKeys[i].first) != visitedKeys.end())
-					continue;
-
-				cursor->fKeys[i].first.write(out);
-				cursor->fKeys[i].second.write(out);
-				visitedKeys.insert(cursor->fKeys[i].first);
-			}
+		if (!cursor)
+			return;
 
-			if (!cursor->fIsLeaf)
-				for (int i = 0; i < cursor->fKeys.size() + 1; i++)
-					writeRec(cursor->ptr[i], out, visitedKeys);
+		if (cursor->fIsLeaf)
+		{
+			for (const data& element : cursor->fKeys)
+				elements.push_back(&element);
+			return;
 		}
+
+		for (int i = 0; i < cursor->fKeys.size() + 1; i++)
+			collectLeaves(cursor->ptr[i], elements);
 	}
 
 };
\ No newline at end of file
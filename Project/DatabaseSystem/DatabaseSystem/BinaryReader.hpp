@@ -0,0 +1,176 @@
+#pragma once
+#include<vector>
+#include<memory>
+#include<string>
+#include<fstream>
+#include<cstring>
+#include<cstdint>
+#include<stdexcept>
+#include<type_traits>
+#include "Crc32c.hpp"
+
+using std::vector;
+using std::string;
+using std::ifstream;
+using std::shared_ptr;
+
+/**
+ * @brief Reads a binary file with a single read call and decodes the fields from the memory buffer.
+ * The files of the database (pages, table metadata, the database itself) are small enough to be kept whole in memory.
+ * The buffer can also be a page image shared with the BufferPool.
+*/
+class BinaryReader
+{
+public:
+	/**
+	 * @brief Read the whole file at path. If it can't be opened the reader is empty and isOpen() returns false.
+	 * A file saved by BinaryWriter is checked against its checksum, logic_error is thrown if it doesn't match.
+	 * The files saved before the checksums are read as they are
+	 * @param path - path to the file
+	*/
+	BinaryReader(const string& path) : fPosition(0), fIsOpen(false)
+	{
+		vector<char> content;
+		fIsOpen = readFile(path, content);
+		if (content.size() >= Crc32c::FILE_HEADER_SIZE && std::memcmp(content.data(), Crc32c::FILE_MAGIC, sizeof(Crc32c::FILE_MAGIC)) == 0)
+		{
+			uint32_t checksum = 0;
+			std::memcpy(&checksum, content.data() + sizeof(Crc32c::FILE_MAGIC), sizeof(checksum));
+			if (checksum != Crc32c::compute(content.data() + Crc32c::FILE_HEADER_SIZE, content.size() - Crc32c::FILE_HEADER_SIZE))
+				throw std::logic_error("The file " + path + " is damaged, its checksum doesn't match.");
+
+			fPosition = Crc32c::FILE_HEADER_SIZE;
+		}
+
+		fBuffer = std::make_shared<const vector<char>>(std::move(content));
+	}
+
+	/**
+	 * @brief Read from bytes that are already in memory
+	 * @param image - the bytes, nullptr makes an empty reader for which isOpen() returns false
+	*/
+	BinaryReader(shared_ptr<const vector<char>> image) : fBuffer(std::move(image)), fPosition(0), fIsOpen(fBuffer != nullptr)
+	{
+		if (!fBuffer)
+			fBuffer = std::make_shared<const vector<char>>();
+	}
+
+	/**
+	 * @brief Read the whole file with a single call
+	 * @param path - path to the file
+	 * @param dest - the content of the file
+	 * @return False if the file couldn't be opened
+	*/
+	static bool readFile(const string& path, vector<char>& dest)
+	{
+		ifstream in(path, std::ios::binary | std::ios::ate);
+		if (!in.is_open())
+			return false;
+
+		std::streamsize size = in.tellg();
+		dest.clear();
+		if (size <= 0)
+			return true;
+
+		dest.resize((size_t)size);
+		in.seekg(0);
+		in.read(dest.data(), size);
+		return true;
+	}
+
+	BinaryReader(const BinaryReader& other) = delete;
+	BinaryReader& operator=(const BinaryReader& other) = delete;
+
+	bool isOpen() const { return fIsOpen; }
+
+	/**
+	 * @return True if everything in the file has been read
+	*/
+	bool eof() const { return fPosition >= fBuffer->size(); }
+
+	/**
+	 * @brief Read a value of trivially copyable type. The value is left unchanged if the file ends before it
+	 * @param value - where the value is read to
+	 * @return whether the value was read
+	*/
+	template<typename T>
+	bool read(T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "BinaryReader can read only trivially copyable types");
+		if (fBuffer->size() - fPosition < sizeof(T))
+			return false;
+
+		std::memcpy(&value, fBuffer->data() + fPosition, sizeof(T));
+		fPosition += sizeof(T);
+		return true;
+	}
+
+	/**
+	 * @brief Skip the next bytes of the file
+	 * @param count - number of bytes
+	 * @return pointer to the skipped bytes, valid as long as the reader is
+	*/
+	const char* readBytes(size_t count)
+	{
+		if (fBuffer->size() - fPosition < count)
+			throw std::out_of_range("BinaryReader readBytes(count) - the file is shorter than expected");
+
+		const char* bytes = fBuffer->data() + fPosition;
+		fPosition += count;
+		return bytes;
+	}
+
+	/**
+	 * @brief Read a string written as its length followed by its characters
+	 * @param dest - the characters are copied straight into it
+	*/
+	void readString(string& dest)
+	{
+		size_t size = 0;
+		read(size);
+		dest.assign(readBytes(size), size);
+	}
+
+	/**
+	 * @brief Read an unsigned integer written by BinaryWriter::writeVarint
+	*/
+	uint64_t readVarint()
+	{
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (fPosition >= fBuffer->size())
+				throw std::out_of_range("BinaryReader readVarint() - the file is shorter than expected");
+
+			unsigned char byte = (unsigned char)(*fBuffer)[fPosition++];
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+
+		throw std::out_of_range("BinaryReader readVarint() - malformed varint");
+	}
+
+	/**
+	 * @brief Read a signed integer written by BinaryWriter::writeSignedVarint
+	*/
+	int64_t readSignedVarint()
+	{
+		uint64_t value = readVarint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	/**
+	 * @brief Read a string written by BinaryWriter::writeCompactString
+	*/
+	void readCompactString(string& dest)
+	{
+		size_t size = readVarint();
+		dest.assign(readBytes(size), size);
+	}
+
+private:
+	shared_ptr<const vector<char>> fBuffer;
+	size_t fPosition;
+	bool fIsOpen;
+};
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<string_view>
+#include<fstream>
+#include<cstring>
+#include<cstdint>
+#include<type_traits>
+#include "Crc32c.hpp"
+
+using std::vector;
+using std::string;
+using std::string_view;
+using std::ofstream;
+
+/**
+ * @brief Encodes the fields of a file in a memory buffer, which is then written with a single write call
+*/
+class BinaryWriter
+{
+public:
+	BinaryWriter() {}
+
+	BinaryWriter(const BinaryWriter& other) = delete;
+	BinaryWriter& operator=(const BinaryWriter& other) = delete;
+
+	/**
+	 * @brief Append a value of trivially copyable type
+	*/
+	template<typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "BinaryWriter can write only trivially copyable types");
+		writeBytes((const char*)&value, sizeof(T));
+	}
+
+	void writeBytes(const char* bytes, size_t count)
+	{
+		fBuffer.insert(fBuffer.end(), bytes, bytes + count);
+	}
+
+	/**
+	 * @brief Append a string as its length followed by its characters
+	*/
+	void writeString(string_view value)
+	{
+		write(value.size());
+		writeBytes(value.data(), value.size());
+	}
+
+	/**
+	 * @brief Append an unsigned integer in 7-bit groups, small values take a single byte
+	*/
+	void writeVarint(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			fBuffer.push_back((char)(value | 0x80));
+			value >>= 7;
+		}
+
+		fBuffer.push_back((char)value);
+	}
+
+	/**
+	 * @brief Append a signed integer as a varint. Zigzag mapping keeps small negative values short too
+	*/
+	void writeSignedVarint(int64_t value)
+	{
+		writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+	}
+
+	/**
+	 * @brief Append a string as its varint length followed by its characters
+	*/
+	void writeCompactString(string_view value)
+	{
+		writeVarint(value.size());
+		writeBytes(value.data(), value.size());
+	}
+
+	size_t size() const { return fBuffer.size(); }
+
+	/**
+	 * @brief Hand the encoded bytes over, leaving the writer empty
+	*/
+	vector<char> release() { return std::move(fBuffer); }
+
+	/**
+	 * @brief Write the buffer to a file, replacing its content. The file starts with Crc32c::FILE_MAGIC and the checksum
+	 * of the buffer, which BinaryReader checks when it reads the file
+	 * @param path - path to the file
+	 * @return False if the file couldn't be opened
+	*/
+	bool save(const string& path) const
+	{
+		ofstream out(path, std::ios::binary);
+		if (!out.is_open())
+			return false;
+
+		uint32_t checksum = Crc32c::compute(fBuffer.data(), fBuffer.size());
+		out.write(Crc32c::FILE_MAGIC, sizeof(Crc32c::FILE_MAGIC));
+		out.write((const char*)&checksum, sizeof(checksum));
+		out.write(fBuffer.data(), fBuffer.size());
+		return true;
+	}
+
+private:
+	vector<char> fBuffer;
+};
\ No newline at end of file
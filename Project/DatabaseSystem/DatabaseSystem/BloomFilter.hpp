@@ -0,0 +1,91 @@
+#pragma once
+#include<vector>
+#include<cstdint>
+#include<stdexcept>
+#include<algorithm>
+#include "TypeWrapper.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::vector;
+
+/**
+ * @brief Descriptor of a Bloom filter over the values of one column in one page. It answers whether the page may hold
+ * a value: "no" is always right, "yes" is wrong for about 1% of the values that are not there.
+ * Values are only added - a deleted record leaves its bits set, which costs a false "yes" and nothing more.
+ * The hash of a value comes from its bytes, so it is only used for Integer and String columns:
+ * doubles are compared with an epsilon and two equal doubles may have different bytes.
+*/
+class BloomFilter
+{
+public:
+	BloomFilter() : fHashes(HASHES) {}
+
+	/**
+	 * @param expectedValues - how many values the filter is made for
+	*/
+	BloomFilter(size_t expectedValues) : fHashes(HASHES), fBits((std::max<size_t>(expectedValues, 1) * BITS_PER_VALUE + 63) / 64) {}
+
+	BloomFilter(BinaryReader& in)
+	{
+		fHashes = in.readVarint();
+		size_t words = in.readVarint();
+		if (fHashes == 0 || words == 0)
+			throw std::logic_error("Bloom filter without bits or hash functions");
+
+		fBits.resize(words);
+		for (uint64_t& word : fBits)
+			in.read(word);
+	}
+
+	void write(BinaryWriter& out) const
+	{
+		out.writeVarint(fHashes);
+		out.writeVarint(fBits.size());
+		for (uint64_t word : fBits)
+			out.write(word);
+	}
+
+	void add(const TypeWrapper& value)
+	{
+		uint64_t hash = value.hash();
+		for (size_t i = 0; i < fHashes; i++)
+		{
+			size_t bit = bitAt(hash, i);
+			fBits[bit / 64] |= (uint64_t)1 << (bit % 64);
+		}
+	}
+
+	/**
+	 * @return False if the value was certainly never added, True if it may have been
+	*/
+	bool mayContain(const TypeWrapper& value) const
+	{
+		uint64_t hash = value.hash();
+		for (size_t i = 0; i < fHashes; i++)
+		{
+			size_t bit = bitAt(hash, i);
+			if (!(fBits[bit / 64] & ((uint64_t)1 << (bit % 64))))
+				return false;
+		}
+
+		return true;
+	}
+
+private:
+	/// 10 bits per value and 7 hash functions give about 1% false positives
+	static const size_t BITS_PER_VALUE = 10;
+	static const size_t HASHES = 7;
+
+	size_t fHashes;
+	vector<uint64_t> fBits;
+
+	/**
+	 * @brief The i-th hash function, derived from the two halves of one 64-bit hash
+	*/
+	size_t bitAt(uint64_t hash, size_t i) const
+	{
+		uint32_t h1 = (uint32_t)hash, h2 = (uint32_t)(hash >> 32) | 1;
+		return (size_t)((h1 + i * (uint64_t)h2) % (fBits.size() * 64));
+	}
+};
\ No newline at end of file
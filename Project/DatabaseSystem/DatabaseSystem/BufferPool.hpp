@@ -0,0 +1,575 @@
+#pragma once
+#include<condition_variable>
+#include<cstdio>
+#include<deque>
+#include<fstream>
+#include<list>
+#include<memory>
+#include<mutex>
+#include<stdexcept>
+#include<string>
+#include<thread>
+#include<unordered_map>
+#include<vector>
+#include "BinaryReader.hpp"
+#include "Crc32c.hpp"
+#include "LZCodec.hpp"
+#include "PageFile.h"
+
+using std::ofstream;
+using std::list;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+/**
+ * @brief Descriptor of buffer pool singleton class. It keeps the decoded images of the most recently used page files
+ * in memory, so a page that is read again costs no I/O and no decompression. Writes go through to the disk at once,
+ * the pool only keeps a copy of what was written - except in write-back mode, used by batches of statements, where the
+ * written images stay in the pool until they are flushed or evicted, so a page changed by many statements is written once.
+ * A page file may be stored compressed: a COMPRESSED_FORMAT header, the decoded size and an LZCodec block.
+ * The compression stays inside the pool - the readers always get the decoded image.
+ * Every written file starts with CHECKSUMMED_FORMAT and the Crc32c of the rest, which is checked when the file is read -
+ * a damaged file is thrown as logic_error instead of being decoded. The files written before the checksums have neither.
+ * The files are read without holding the pool, so the threads reading other pages don't wait for the disk. A read-ahead
+ * thread reads the files that sequential scans will need next, while they filter the pages they have.
+ * The files of a directory with a mounted PageFile are stored in it instead of on their own, under their file names.
+*/
+class BufferPool
+{
+public:
+	static BufferPool& getInstance()
+	{
+		static BufferPool inst;
+		return inst;
+	}
+
+	BufferPool(const BufferPool& other) = delete;
+	BufferPool& operator=(const BufferPool& other) = delete;
+	BufferPool(BufferPool&& other) = delete;
+	BufferPool& operator=(BufferPool&& other) = delete;
+
+	/**
+	 * @param path - path to the page file
+	 * @return the decoded image of the file, nullptr if the file couldn't be opened
+	*/
+	shared_ptr<const vector<char>> read(const string& path)
+	{
+		unique_lock<mutex> lock(fMutex);
+		while (true)
+		{
+			auto it = fPages.find(path);
+			if (it != fPages.end())
+			{
+				fHits++;
+				fRecentlyUsed.splice(fRecentlyUsed.begin(), fRecentlyUsed, it->second.position);
+				return it->second.image;
+			}
+
+			// Another thread is reading the file, the image is in the pool when it is done
+			if (fLoading.find(path) == fLoading.end())
+				break;
+
+			fLoaded.wait(lock);
+		}
+
+		fMisses++;
+		return load(path, lock);
+	}
+
+	/**
+	 * @brief Read a file into the pool on the read-ahead thread, unless it is there already
+	 * @param path - path to the page file
+	*/
+	void prefetch(const string& path)
+	{
+		{
+			lock_guard<mutex> lock(fMutex);
+			if (fPages.find(path) != fPages.end() || fLoading.find(path) != fLoading.end())
+				return;
+
+			fReadAhead.push_back(path);
+			if (!fReadAheadThread.joinable())
+				fReadAheadThread = std::thread(&BufferPool::readAhead, this);
+		}
+		fReadAheadReady.notify_one();
+	}
+
+	/**
+	 * @brief Write a page file and keep its image
+	 * @param path - path to the page file
+	 * @param image - the content of the page
+	 * @param compress - whether to store the file compressed. It is stored as it is when compression doesn't make it smaller.
+	 * @return False if the file couldn't be opened
+	*/
+	bool write(const string& path, vector<char> image, bool compress)
+	{
+		lock_guard<mutex> lock(fMutex);
+		invalidateLoading(path);
+		if (fWriteBack)
+		{
+			cache(path, std::make_shared<const vector<char>>(std::move(image)), true, compress);
+			return true;
+		}
+
+		if (!writeFile(path, image, compress))
+			return false;
+
+		cache(path, std::make_shared<const vector<char>>(std::move(image)), false, false);
+		return true;
+	}
+
+	/**
+	 * @brief Turn write-back mode on or off. Turning it off doesn't write the held images, flush does
+	*/
+	void setWriteBack(bool enabled)
+	{
+		lock_guard<mutex> lock(fMutex);
+		fWriteBack = enabled;
+	}
+
+	/**
+	 * @brief Write all the images held back by write-back mode to their files. An image that couldn't be written stays
+	 * held back, so a later flush or its eviction tries again
+	 * @return False if some file couldn't be opened
+	*/
+	bool flush()
+	{
+		lock_guard<mutex> lock(fMutex);
+		bool written = true;
+		for (pair<const string, Entry>& entry : fPages)
+		{
+			if (!entry.second.dirty)
+				continue;
+
+			if (writeFile(entry.first, *entry.second.image, entry.second.compress))
+				entry.second.dirty = false;
+			else
+				written = false;
+		}
+
+		return written;
+	}
+
+	/**
+	 * @brief Drop the image of a file that was removed from the disk
+	*/
+	void forget(const string& path)
+	{
+		lock_guard<mutex> lock(fMutex);
+		invalidateLoading(path);
+		auto it = fPages.find(path);
+		if (it != fPages.end())
+			drop(it);
+	}
+
+	/**
+	 * @brief Drop the images of all the files in a directory that was removed from the disk
+	*/
+	void forgetDirectory(const string& directory)
+	{
+		lock_guard<mutex> lock(fMutex);
+		for (pair<const string, bool>& loading : fLoading)
+			if (loading.first.compare(0, directory.size(), directory) == 0)
+				loading.second = true;
+
+		for (auto it = fPages.begin(); it != fPages.end();)
+		{
+			if (it->first.compare(0, directory.size(), directory) == 0)
+				it = drop(it);
+			else
+				++it;
+		}
+	}
+
+	/**
+	 * @brief Remove a file from the disk, or from the page file that holds it, and drop its image
+	*/
+	void remove(const string& path)
+	{
+		lock_guard<mutex> lock(fMutex);
+		invalidateLoading(path);
+		auto it = fPages.find(path);
+		if (it != fPages.end())
+			drop(it);
+
+		string name;
+		shared_ptr<PageFile> pageFile = findPageFile(path, name);
+		if (pageFile)
+			pageFile->remove(name);
+		else
+			std::remove(path.c_str());
+	}
+
+	/**
+	 * @brief Store the files of a directory in a page file from now on
+	 * @param directory - path to the directory, ending with a slash
+	*/
+	void mount(const string& directory, shared_ptr<PageFile> pageFile)
+	{
+		lock_guard<mutex> lock(fMutex);
+		fMounts[directory] = std::move(pageFile);
+	}
+
+	/**
+	 * @brief Store the files of a directory on their own again. The images held back by write-back mode should be
+	 * flushed first, or they are written as files
+	 * @return the page file that held them, nullptr if there was none
+	*/
+	shared_ptr<PageFile> unmount(const string& directory)
+	{
+		lock_guard<mutex> lock(fMutex);
+		auto it = fMounts.find(directory);
+		if (it == fMounts.end())
+			return nullptr;
+
+		shared_ptr<PageFile> pageFile = std::move(it->second);
+		fMounts.erase(it);
+		return pageFile;
+	}
+
+	/**
+	 * @brief Set how many bytes of page images are kept at most
+	*/
+	void setCapacity(size_t bytes)
+	{
+		lock_guard<mutex> lock(fMutex);
+		fCapacity = bytes;
+		evict();
+	}
+
+	size_t getHits() const { lock_guard<mutex> lock(fMutex); return fHits; }
+
+	size_t getMisses() const { lock_guard<mutex> lock(fMutex); return fMisses; }
+
+	size_t getBytesRead() const { lock_guard<mutex> lock(fMutex); return fBytesRead; }
+
+	size_t getBytesWritten() const { lock_guard<mutex> lock(fMutex); return fBytesWritten; }
+
+	/**
+	 * @return the number of files read by the read-ahead thread
+	*/
+	size_t getPrefetched() const { lock_guard<mutex> lock(fMutex); return fPrefetched; }
+
+	/**
+	 * Marks a compressed page file. The formats of the pages themselves start with -1 or with a positive capacity
+	 */
+	static constexpr int COMPRESSED_FORMAT = -2;
+
+	/// Marks a page file that starts with its checksum
+	static constexpr int CHECKSUMMED_FORMAT = -3;
+
+	/// What verify found in a file
+	enum class FileState
+	{
+		INTACT,
+		/// Written before the checksums, it could only be decoded
+		UNCHECKED,
+		DAMAGED
+	};
+
+	/**
+	 * @brief Read a file and check it against its checksum, without keeping its image. Safe to call from many threads
+	 * @param path - path to the page file
+	 * @return DAMAGED if the file is missing, doesn't match its checksum or can't be decoded
+	*/
+	FileState verify(const string& path) const
+	{
+		string name;
+		shared_ptr<PageFile> pageFile;
+		{
+			lock_guard<mutex> lock(fMutex);
+			pageFile = findPageFile(path, name);
+		}
+
+		vector<char> content;
+		if (!(pageFile ? pageFile->read(name, content) : BinaryReader::readFile(path, content)))
+			return FileState::DAMAGED;
+
+		bool checksummed = hasChecksum(content);
+		try
+		{
+			decode(std::move(content), path);
+		}
+		catch (const std::exception&)
+		{
+			return FileState::DAMAGED;
+		}
+
+		return checksummed ? FileState::INTACT : FileState::UNCHECKED;
+	}
+
+private:
+	BufferPool() : fCapacity(DEFAULT_CAPACITY), fSize(0), fHits(0), fMisses(0), fBytesRead(0), fBytesWritten(0), fPrefetched(0),
+		fWriteBack(false), fStopping(false) {}
+
+	~BufferPool()
+	{
+		{
+			lock_guard<mutex> lock(fMutex);
+			fStopping = true;
+		}
+		fReadAheadReady.notify_all();
+		if (fReadAheadThread.joinable())
+			fReadAheadThread.join();
+	}
+
+	struct Entry
+	{
+		shared_ptr<const vector<char>> image;
+		list<string>::iterator position;
+		/// The image was written in write-back mode and isn't on the disk yet
+		bool dirty;
+		bool compress;
+	};
+
+	static const size_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+	static const size_t HEADER_SIZE = sizeof(int) + sizeof(uint64_t);
+	static const size_t CHECKSUM_HEADER_SIZE = sizeof(int) + sizeof(uint32_t);
+
+	mutable mutex fMutex;
+	list<string> fRecentlyUsed;
+	unordered_map<string, Entry> fPages;
+	size_t fCapacity, fSize;
+	size_t fHits, fMisses, fBytesRead, fBytesWritten, fPrefetched;
+	bool fWriteBack;
+	/// The files being read without the pool held. Set to true when the file is written or forgotten meanwhile
+	unordered_map<string, bool> fLoading;
+	/// Notified when a file is read
+	std::condition_variable fLoaded;
+	std::deque<string> fReadAhead;
+	std::condition_variable fReadAheadReady;
+	std::thread fReadAheadThread;
+	bool fStopping;
+	/// The page files by the directories whose files they hold
+	unordered_map<string, shared_ptr<PageFile>> fMounts;
+
+	/**
+	 * @param path - path to a page file
+	 * @param name - set to the name of the file in the page file
+	 * @return the page file that holds the file, nullptr if it is on its own
+	*/
+	shared_ptr<PageFile> findPageFile(const string& path, string& name) const
+	{
+		if (fMounts.empty())
+			return nullptr;
+
+		size_t slash = path.find_last_of('/');
+		auto it = fMounts.find(path.substr(0, slash + 1));
+		if (it == fMounts.end())
+			return nullptr;
+
+		name = path.substr(slash + 1);
+		return it->second;
+	}
+
+	/**
+	 * @brief Read a file and keep its image. Called with the pool held, which is let go while the file is read
+	 * @return the decoded image of the file, nullptr if the file couldn't be opened
+	*/
+	shared_ptr<const vector<char>> load(const string& path, unique_lock<mutex>& lock)
+	{
+		fLoading[path] = false;
+		string name;
+		shared_ptr<PageFile> pageFile = findPageFile(path, name);
+		lock.unlock();
+
+		vector<char> content;
+		shared_ptr<const vector<char>> image;
+		size_t bytes = 0;
+		try
+		{
+			if (pageFile ? pageFile->read(name, content) : BinaryReader::readFile(path, content))
+			{
+				bytes = content.size();
+				image = std::make_shared<const vector<char>>(decode(std::move(content), path));
+			}
+		}
+		catch (...)
+		{
+			lock.lock();
+			fLoading.erase(path);
+			fLoaded.notify_all();
+			throw;
+		}
+
+		lock.lock();
+		bool changed = fLoading[path];
+		fLoading.erase(path);
+		fLoaded.notify_all();
+		if (!image)
+			return nullptr;
+
+		fBytesRead += bytes;
+		// The file was written or removed while it was read, the pool keeps the newer state
+		if (!changed)
+			cache(path, image);
+
+		return image;
+	}
+
+	void invalidateLoading(const string& path)
+	{
+		auto it = fLoading.find(path);
+		if (it != fLoading.end())
+			it->second = true;
+	}
+
+	/**
+	 * @brief The loop of the read-ahead thread
+	*/
+	void readAhead()
+	{
+		unique_lock<mutex> lock(fMutex);
+		while (true)
+		{
+			fReadAheadReady.wait(lock, [this]() { return fStopping || !fReadAhead.empty(); });
+			if (fStopping)
+				return;
+
+			string path = std::move(fReadAhead.front());
+			fReadAhead.pop_front();
+			if (fPages.find(path) != fPages.end() || fLoading.find(path) != fLoading.end())
+				continue;
+
+			fPrefetched++;
+			try
+			{
+				load(path, lock);
+			}
+			catch (const std::exception&)
+			{
+				// The scan that needs the page reads it again and gets the error
+			}
+		}
+	}
+
+	/**
+	 * @brief Write the image of a page to its file, compressed if asked and if that makes it smaller
+	*/
+	bool writeFile(const string& path, const vector<char>& image, bool compress)
+	{
+		vector<char> compressed;
+		if (compress)
+			compressed = LZCodec::compress(image.data(), image.size());
+
+		// The checksum header, then the compressed block with its header or the image as it is
+		vector<char> content(CHECKSUM_HEADER_SIZE);
+		if (compress && HEADER_SIZE + compressed.size() < image.size())
+		{
+			int format = COMPRESSED_FORMAT;
+			uint64_t decodedSize = image.size();
+			content.reserve(CHECKSUM_HEADER_SIZE + HEADER_SIZE + compressed.size());
+			content.insert(content.end(), (const char*)&format, (const char*)&format + sizeof(format));
+			content.insert(content.end(), (const char*)&decodedSize, (const char*)&decodedSize + sizeof(decodedSize));
+			content.insert(content.end(), compressed.begin(), compressed.end());
+		}
+		else
+			content.insert(content.end(), image.begin(), image.end());
+
+		int format = CHECKSUMMED_FORMAT;
+		uint32_t checksum = Crc32c::compute(content.data() + CHECKSUM_HEADER_SIZE, content.size() - CHECKSUM_HEADER_SIZE);
+		std::memcpy(content.data(), &format, sizeof(format));
+		std::memcpy(content.data() + sizeof(format), &checksum, sizeof(checksum));
+
+		string name;
+		shared_ptr<PageFile> pageFile = findPageFile(path, name);
+		if (pageFile)
+		{
+			if (!pageFile->write(name, content))
+				return false;
+		}
+		else
+		{
+			ofstream out(path, std::ios::binary);
+			if (!out.is_open())
+				return false;
+
+			out.write(content.data(), content.size());
+		}
+
+		fBytesWritten += content.size();
+		return true;
+	}
+
+	static bool hasChecksum(const vector<char>& content)
+	{
+		int format = 0;
+		if (content.size() >= CHECKSUM_HEADER_SIZE)
+			std::memcpy(&format, content.data(), sizeof(format));
+
+		return format == CHECKSUMMED_FORMAT;
+	}
+
+	/**
+	 * @brief Turn the content of a file into the page image: check its checksum and decompress it if needed.
+	 * Throws logic_error if the checksum doesn't match
+	*/
+	static vector<char> decode(vector<char> content, const string& path)
+	{
+		size_t start = 0;
+		if (hasChecksum(content))
+		{
+			uint32_t checksum = 0;
+			std::memcpy(&checksum, content.data() + sizeof(int), sizeof(checksum));
+			if (checksum != Crc32c::compute(content.data() + CHECKSUM_HEADER_SIZE, content.size() - CHECKSUM_HEADER_SIZE))
+				throw std::logic_error("The page file " + path + " is damaged, its checksum doesn't match.");
+
+			start = CHECKSUM_HEADER_SIZE;
+		}
+
+		int format = 0;
+		if (content.size() - start >= HEADER_SIZE)
+			std::memcpy(&format, content.data() + start, sizeof(format));
+
+		if (format == COMPRESSED_FORMAT)
+		{
+			uint64_t decodedSize = 0;
+			std::memcpy(&decodedSize, content.data() + start + sizeof(format), sizeof(decodedSize));
+			return LZCodec::decompress(content.data() + start + HEADER_SIZE, content.size() - start - HEADER_SIZE, decodedSize);
+		}
+
+		content.erase(content.begin(), content.begin() + start);
+		return content;
+	}
+
+	void cache(const string& path, shared_ptr<const vector<char>> image, bool dirty = false, bool compress = false)
+	{
+		auto it = fPages.find(path);
+		if (it != fPages.end())
+			drop(it);
+
+		fRecentlyUsed.push_front(path);
+		fSize += image->size();
+		fPages.insert({ path, Entry{ std::move(image), fRecentlyUsed.begin(), dirty, compress } });
+		evict();
+	}
+
+	/**
+	 * @brief Drop the least recently used images until the pool fits in its capacity. An image held back by write-back mode
+	 * is written to its file before it is dropped.
+	*/
+	void evict()
+	{
+		while (fSize > fCapacity && !fRecentlyUsed.empty())
+		{
+			auto it = fPages.find(fRecentlyUsed.back());
+			if (it->second.dirty && !writeFile(it->first, *it->second.image, it->second.compress))
+				throw std::runtime_error("Couldn't write the page " + it->first);
+
+			drop(it);
+		}
+	}
+
+	unordered_map<string, Entry>::iterator drop(unordered_map<string, Entry>::iterator it)
+	{
+		fSize -= it->second.image->size();
+		fRecentlyUsed.erase(it->second.position);
+		return fPages.erase(it);
+	}
+};
\ No newline at end of file
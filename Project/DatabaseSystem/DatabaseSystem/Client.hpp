@@ -0,0 +1,107 @@
+#pragma once
+#ifdef __linux__
+#include<cerrno>
+#include<cstring>
+#include<memory>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include<sys/socket.h>
+#include<sys/un.h>
+#include<unistd.h>
+#include "Protocol.hpp"
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Descriptor of a session with a server started with --server. The statements are sent over the Unix socket
+ * of the server and run there one at a time, their results come back as from a Connection. The errors of the statements
+ * are thrown as invalid_argument, a lost server as runtime_error.
+*/
+class Client
+{
+public:
+	/**
+	 * @param socketPath - path to the socket of the server
+	*/
+	Client(const string& socketPath) : fSocket(-1)
+	{
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		if (socketPath.size() >= sizeof(address.sun_path))
+			throw invalid_argument("The socket path " + socketPath + " is too long.");
+
+		std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+		fSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fSocket < 0 || connect(fSocket, (sockaddr*)&address, sizeof(address)) < 0)
+		{
+			string reason = std::strerror(errno);
+			if (fSocket >= 0)
+				close(fSocket);
+
+			throw runtime_error("Couldn't connect to the server at " + socketPath + ": " + reason);
+		}
+	}
+
+	Client(const Client& other) = delete;
+	Client& operator=(const Client& other) = delete;
+
+	~Client()
+	{
+		close(fSocket);
+	}
+
+	/**
+	 * @brief Run one statement on the server and wait for its result
+	*/
+	ResultSet execute(const string& statement)
+	{
+		vector<char> request = Protocol::encodeRequest(statement);
+		sendAll(request.data(), request.size());
+
+		char header[Protocol::HEADER_SIZE];
+		receiveAll(header, sizeof(header));
+
+		uint32_t size = 0;
+		Protocol::hasFrame(header, sizeof(header), size);
+		std::shared_ptr<vector<char>> payload = std::make_shared<vector<char>>(size);
+		receiveAll(payload->data(), size);
+		return Protocol::decodeResponse(std::move(payload));
+	}
+
+private:
+	int fSocket;
+
+	void sendAll(const char* bytes, size_t count)
+	{
+		while (count > 0)
+		{
+			ssize_t sent = send(fSocket, bytes, count, MSG_NOSIGNAL);
+			if (sent < 0 && errno == EINTR)
+				continue;
+			if (sent <= 0)
+				throw runtime_error("The connection to the server is lost.");
+
+			bytes += sent;
+			count -= sent;
+		}
+	}
+
+	void receiveAll(char* bytes, size_t count)
+	{
+		while (count > 0)
+		{
+			ssize_t received = recv(fSocket, bytes, count, 0);
+			if (received < 0 && errno == EINTR)
+				continue;
+			if (received <= 0)
+				throw runtime_error("The connection to the server is lost.");
+
+			bytes += received;
+			count -= received;
+		}
+	}
+};
+#endif
\ No newline at end of file
@@ -18,6 +18,7 @@ class CommandParser
 private:
 	bool fIsDistinct = false;
 	string fOrderBy;
+	string fGroupBy;
 	string fRaw;
 	vector<string> fTokens;
 
@@ -30,6 +31,8 @@ public:
 	{
 		clearCmd();
 		fIsDistinct = false;
+		fOrderBy.clear();
+		fGroupBy.clear();
 
 		if (getNumberOfSymbol(fRaw, '\"') % 2 != 0)
 			throw invalid_argument("Invalid command, check the number of quotes");
@@ -52,7 +55,7 @@ public:
 				if (fTokens[i] == "WHERE")
 				{
 					i++;
-					while (i < fTokens.size() && (fTokens[i] != "ORDER" && fTokens[i] != "BY" && fTokens[i] != "DISTINCT"))
+					while (i < fTokens.size() && (fTokens[i] != "ORDER" && fTokens[i] != "GROUP" && fTokens[i] != "BY" && fTokens[i] != "DISTINCT"))
 					{
 						fTokens[currInd] += " " + fTokens[i];
 						i++;
@@ -70,11 +73,20 @@ public:
 					if (fTokens[i + 1] == "BY")
 					{
 						fOrderBy = fTokens[i + 2];
+						// An aggregate like COUNT(*) is split into its name and its braces
+						if (i + 3 < fTokens.size() && fTokens[i + 3][0] == '(')
+							fOrderBy += fTokens[i + 3];
 					}
 				}
 			}
 		}
 
+		// The grouping columns run until ORDER BY or DISTINCT, with or without spaces after the commas
+		for (size_t i = 0; i + 2 < fTokens.size(); i++)
+			if (fTokens[i] == "GROUP" && fTokens[i + 1] == "BY")
+				for (size_t j = i + 2; j < fTokens.size() && fTokens[j] != "ORDER" && fTokens[j] != "DISTINCT"; j++)
+					fGroupBy += fTokens[j];
+
 		if (std::find(fTokens.begin(), fTokens.end(), "DISTINCT") != fTokens.end())
 			fIsDistinct = true;
 
@@ -142,7 +154,7 @@ public:
 			{
 				tokensWordInd = i;
 				while (isalpha(fRaw[i]) || isdigit(fRaw[i]) || fRaw[i] == '*' || fRaw[i] == '>' || fRaw[i] == '<' || fRaw[i] == '='
-					|| fRaw[i] == '!' || fRaw[i] == ',' || fRaw[i] == '.')
+					|| fRaw[i] == '!' || fRaw[i] == ',' || fRaw[i] == '.' || fRaw[i] == '?')
 					i++;
 
 				fTokens.push_back(fRaw.substr(tokensWordInd, i - tokensWordInd));
@@ -188,6 +200,9 @@ public:
 
 	string getOrderBy() const { return fOrderBy; }
 
+	/// @return the columns after GROUP BY, separated by commas
+	string getGroupBy() const { return fGroupBy; }
+
 	bool isDistinct() const { return fIsDistinct; }
 
 	/// @brief Getter
@@ -210,6 +225,14 @@ public:
 		{
 			return CommandType::DROP_TABLE;
 		}
+		else if (cmd == "CREATEVIEW")
+		{
+			return CommandType::CREATE_VIEW;
+		}
+		else if (cmd == "DROPVIEW")
+		{
+			return CommandType::DROP_VIEW;
+		}
 		else if (cmd == "LISTTABLES")
 		{
 			return CommandType::LIST_TABLES;
@@ -230,6 +253,34 @@ public:
 		{
 			return CommandType::SELECT;
 		}
+		else if (cmd == "PREPARE")
+		{
+			return CommandType::PREPARE;
+		}
+		else if (cmd == "EXECUTE")
+		{
+			return CommandType::EXECUTE;
+		}
+		else if (cmd == "BEGIN")
+		{
+			return CommandType::BEGIN;
+		}
+		else if (cmd == "COMMIT")
+		{
+			return CommandType::COMMIT;
+		}
+		else if (cmd == "VACUUM")
+		{
+			return CommandType::VACUUM;
+		}
+		else if (cmd == "BLOOMFILTER")
+		{
+			return CommandType::BLOOM_FILTER;
+		}
+		else if (cmd == "SINGLEFILE")
+		{
+			return CommandType::SINGLE_FILE;
+		}
 		else if (cmd == "EXIT")
 			return CommandType::EXIT;
 
@@ -2,11 +2,20 @@
 enum class CommandType {
 	CREATE_TABLE,
 	DROP_TABLE,
+	CREATE_VIEW,
+	DROP_VIEW,
 	LIST_TABLES,
 	TABLE_INFO,
 	INSERT,
 	REMOVE,
 	SELECT,
+	PREPARE,
+	EXECUTE,
+	BEGIN,
+	COMMIT,
+	VACUUM,
+	BLOOM_FILTER,
+	SINGLE_FILE,
 	EXIT,
 	NONE
 };
\ No newline at end of file
@@ -0,0 +1,642 @@
+#include "Connection.h"
+#include <sstream>
+#include <algorithm>
+
+using std::ostringstream;
+
+ResultSet PreparedStatement::execute()
+{
+	for (size_t i = 0; i < fValues.size(); i++)
+		if (fValues[i].empty())
+			throw invalid_argument("Parameter " + std::to_string(i) + " of the statement is not bound.");
+
+	if (fConnection->fClosed)
+		throw logic_error("The connection is closed.");
+
+	fConnection->fDataBase->vacuum();
+	Arena arena;
+	ArenaScope arenaScope(arena);
+	fPlan.query->bind(fValues);
+	return fConnection->execute(fPlan);
+}
+
+Connection::Connection(const string& directory, const string& name) : fSession(0), fBatchSession(0), fClosed(false), fScriptMode(false)
+{
+	if (!fs::exists(directory + name + ".bin"))
+	{
+		DataBase created(name, directory);
+	}
+
+	BinaryReader in(directory + name + ".bin");
+	fDataBase = std::make_unique<DataBase>(in);
+}
+
+unique_ptr<Connection> Connection::open(const string& directory, const string& name)
+{
+	return std::make_unique<Connection>(directory, name);
+}
+
+Connection::~Connection()
+{
+	// A destructor must not throw, a failed save is lost like a crash would lose it
+	try
+	{
+		close();
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+void Connection::close()
+{
+	if (fClosed)
+		return;
+
+	if (fDataBase->isInBatch())
+		fDataBase->commit();
+
+	fDataBase->save();
+	fClosed = true;
+}
+
+void Connection::endSession(uint64_t session)
+{
+	fPrepared.erase(session);
+	if (!fDataBase->isInBatch() || fBatchSession != session)
+		return;
+
+	try
+	{
+		fDataBase->commit();
+	}
+	catch (const std::exception&)
+	{
+		fBatchSession = ORPHANED_BATCH;
+	}
+}
+
+void Connection::setScriptMode(bool enabled)
+{
+	fScriptMode = enabled;
+	if (enabled && !fDataBase->isInBatch())
+	{
+		fDataBase->begin();
+		fBatchSession = fSession;
+	}
+}
+
+ResultSet Connection::execute(const string& statement)
+{
+	if (fClosed)
+		throw logic_error("The connection is closed.");
+
+	// No statement is running, so this is when the dead versions get reclaimed
+	fDataBase->vacuum();
+
+	// All the values that the statement reads or copies are allocated from its own arena, the result keeps copies of them
+	Arena arena;
+	ArenaScope arenaScope(arena);
+	return run(statement);
+}
+
+PreparedStatement Connection::prepare(const string& statement)
+{
+	CommandParser cp;
+	cp.setData(statement);
+	return PreparedStatement(*this, compile(cp));
+}
+
+ResultSet Connection::run(const string& statement)
+{
+	DataBase& db = *fDataBase;
+
+	// A statement run before skips the parsing
+	string normalized = PlanCache::normalize(statement);
+	if (PlanCache::Plan* plan = fPlans.find(normalized))
+		return execute(*plan);
+
+	CommandParser cp;
+	cp.setData(statement);
+
+	switch (cp.getCommandType())
+	{
+	case CommandType::CREATE_TABLE:
+	{
+		fPlans.clear();
+		string tblName = cp.atToken(1);
+		vector<string> colNames;
+		unordered_map<string, string> scheme = getColNameType(cp.atToken(2), colNames);
+		// Index ON {columnName} or Index HASH ON {columnName}
+		bool hashIndex = cp.size() >= 7 && sh::toUpper(cp.atToken(4)) == "HASH";
+		string primaryKey = hashIndex ? cp.atToken(6) : (cp.size() >= 6 ? cp.atToken(5) : "");
+		db.createTable(db.getPath(), tblName, scheme, colNames, primaryKey, hashIndex ? IndexType::HASH : IndexType::BPTREE);
+		return ResultSet(CommandType::CREATE_TABLE, "Table " + tblName + " created!");
+	}
+	case CommandType::DROP_TABLE:
+	{
+		fPlans.clear();
+		string tblName = cp.atToken(1);
+		db.dropTable(tblName);
+		for (pair<const uint64_t, unordered_map<string, PlanCache::Plan>>& session : fPrepared)
+			for (auto it = session.second.begin(); it != session.second.end();)
+				it = it->second.table == tblName ? session.second.erase(it) : std::next(it);
+
+		return ResultSet(CommandType::DROP_TABLE, "Table " + tblName + " dropped!");
+	}
+	case CommandType::CREATE_VIEW:
+	{
+		fPlans.clear();
+		if (cp.size() < 6 || sh::toUpper(cp.atToken(2)) != "AS" || sh::toUpper(cp.atToken(3)) != "SELECT")
+			throw invalid_argument("Expected CreateView {viewName} AS Select ...");
+
+		string tblName, where;
+		vector<string> selectList, groupBy;
+		parseSelect(cp, 4, tblName, selectList, groupBy, where);
+		db.createView(cp.atToken(1), tblName, selectList, groupBy, where);
+		return ResultSet(CommandType::CREATE_VIEW, "View " + cp.atToken(1) + " created with " + std::to_string(db.getView(cp.atToken(1)).getGroupsCount()) + " groups!");
+	}
+	case CommandType::DROP_VIEW:
+		fPlans.clear();
+		db.dropView(cp.atToken(1));
+		return ResultSet(CommandType::DROP_VIEW, "View " + cp.atToken(1) + " dropped!");
+	case CommandType::LIST_TABLES:
+		return listTables();
+	case CommandType::TABLE_INFO:
+		return ResultSet(CommandType::TABLE_INFO, describeTable(cp.atToken(1)));
+	case CommandType::INSERT:
+	{
+		string tblName = cp.atToken(2);
+		if (cp.size() > 4)
+			throw invalid_argument("Too many arguments for this command.");
+
+		Table& target = db.getTable(tblName);
+		unordered_map<size_t, string> indexColumn;
+		unordered_map<string, string> tableScheme = target.getTableScheme();
+
+		size_t ind = 0;
+		vector<string> header = sh::splitBy(target.getTableHeader(), ",");
+		sh::removeEmptyStringsInVector(header);
+		for (const string& entry : header)
+			indexColumn.insert({ ind++, entry });
+
+		vector<unordered_map<string, TypeWrapper>> values = getColNameValues(cp.atToken(3), tableScheme, indexColumn);
+
+		db.insert(tblName, values);
+		return ResultSet(CommandType::INSERT, "Total " + std::to_string(values.size()) + " rows inserted.", values.size());
+	}
+	case CommandType::SELECT:
+	{
+		size_t from = 1;
+		while (from < cp.size() && sh::toUpper(cp.atToken(from)) != "FROM")
+			from++;
+
+		if (from + 1 < cp.size() && db.hasView(cp.atToken(from + 1)))
+			return selectView(cp);
+
+		if (cp.size() > 4 && sh::toUpper(cp.atToken(4)) == "JOIN")
+			return selectJoin(cp);
+
+		bool isAggregate = !cp.getGroupBy().empty();
+		for (size_t i = 1; i < cp.size() && sh::toUpper(cp.atToken(i)) != "FROM"; i++)
+			isAggregate = isAggregate || cp.atToken(i)[0] == '(';
+
+		if (isAggregate)
+			return selectAggregate(cp);
+
+		// A plain Select is run through a plan, like a Remove
+		[[fallthrough]];
+	}
+	case CommandType::REMOVE:
+	{
+		PlanCache::Plan plan = compile(cp);
+		if (plan.query->getParametersCount() > 0)
+			throw invalid_argument("A statement with ? values has to be prepared with Prepare {name} AS ..");
+
+		return execute(fPlans.insert(normalized, std::move(plan)));
+	}
+	case CommandType::PREPARE:
+	{
+		if (cp.size() < 4 || sh::toUpper(cp.atToken(2)) != "AS")
+			throw invalid_argument("Expected Prepare {name} AS {statement}");
+
+		// The statement is everything after AS
+		size_t as = normalized.find(' ', normalized.find(' ') + 1);
+		CommandParser body;
+		body.setData(normalized.substr(normalized.find(' ', as + 1) + 1));
+		PlanCache::Plan& plan = fPrepared[fSession].insert_or_assign(cp.atToken(1), compile(body)).first->second;
+		return ResultSet(CommandType::PREPARE, "Statement " + cp.atToken(1) + " prepared with " + std::to_string(plan.query->getParametersCount()) + " parameters!");
+	}
+	case CommandType::EXECUTE:
+	{
+		unordered_map<string, PlanCache::Plan>& prepared = fPrepared[fSession];
+		auto it = prepared.find(cp.atToken(1));
+		if (it == prepared.end())
+			throw invalid_argument("There is no prepared statement with name {" + cp.atToken(1) + "}");
+
+		PlanCache::Plan& plan = it->second;
+		plan.query->bind(cp.size() > 2 ? splitArguments(cp.atToken(2)) : vector<string>());
+		return execute(plan);
+	}
+	case CommandType::BEGIN:
+		// A script is already a batch
+		if (fScriptMode && db.isInBatch())
+			return ResultSet(CommandType::BEGIN, "Batch started, the changes are saved at COMMIT.");
+
+		// The batch is of the whole database, the sessions of a server can't have one each
+		if (db.isInBatch() && fBatchSession != fSession)
+			throw invalid_argument("Another session has started a batch, BEGIN after it commits");
+
+		db.begin();
+		fBatchSession = fSession;
+		return ResultSet(CommandType::BEGIN, "Batch started, the changes are saved at COMMIT.");
+	case CommandType::COMMIT:
+		if (db.isInBatch() && fBatchSession != fSession && fBatchSession != ORPHANED_BATCH)
+			throw invalid_argument("The batch was started by another session, only it can COMMIT");
+
+		db.commit();
+		if (fScriptMode)
+			db.begin();
+
+		return ResultSet(CommandType::COMMIT, "Batch committed.");
+	case CommandType::VACUUM:
+	{
+		string tblName = cp.atToken(1);
+		ostringstream message;
+		if (cp.size() > 2)
+		{
+			if (sh::toUpper(cp.atToken(2)) != "AUTO" || !sh::isCorrectColumnType("Double", cp.atToken(3)))
+				throw invalid_argument("Expected Vacuum {tableName} AUTO {deadRatio}");
+
+			db.setAutoVacuum(tblName, stod(cp.atToken(3)));
+			message << "Table " << tblName << " will be vacuumed when more than " << stod(cp.atToken(3)) * 100 << "% of its records are dead.";
+			return ResultSet(CommandType::VACUUM, message.str());
+		}
+
+		size_t pagesBefore = db.getTable(tblName).getPagesCount();
+		size_t freed = db.compactTable(tblName);
+		message << "Table " << tblName << " vacuumed: " << freed << " dead records reclaimed, "
+			<< pagesBefore << " -> " << db.getTable(tblName).getPagesCount() << " pages.";
+		return ResultSet(CommandType::VACUUM, message.str(), freed);
+	}
+	case CommandType::BLOOM_FILTER:
+	{
+		if (cp.size() != 4 || (sh::toUpper(cp.atToken(2)) != "ON" && sh::toUpper(cp.atToken(2)) != "OFF"))
+			throw invalid_argument("Expected BloomFilter {tableName} {ON|OFF} {columnName}");
+
+		string tblName = cp.atToken(1);
+		bool enabled = sh::toUpper(cp.atToken(2)) == "ON";
+		db.setBloomFilter(tblName, cp.atToken(3), enabled);
+		return ResultSet(CommandType::BLOOM_FILTER, "Bloom filters on column " + cp.atToken(3) + " of table " + tblName + " are turned " + (enabled ? "on." : "off."));
+	}
+	case CommandType::SINGLE_FILE:
+	{
+		if (cp.size() != 3 || (sh::toUpper(cp.atToken(2)) != "ON" && sh::toUpper(cp.atToken(2)) != "OFF"))
+			throw invalid_argument("Expected SingleFile {tableName} {ON|OFF}");
+
+		string tblName = cp.atToken(1);
+		bool enabled = sh::toUpper(cp.atToken(2)) == "ON";
+		db.setSingleFile(tblName, enabled);
+		return ResultSet(CommandType::SINGLE_FILE, "The pages of table " + tblName + (enabled ? " are kept in one file." : " are kept in a file each."));
+	}
+	case CommandType::EXIT:
+		close();
+		return ResultSet(CommandType::EXIT, "Goodbye");
+	default:
+		throw invalid_argument("Unrecognized command.");
+	}
+}
+
+unordered_map<string, string> Connection::getColNameType(string scheme, vector<string>& colNames)
+{
+	unordered_map<string, string> colNameType;
+	scheme.erase(scheme.begin());
+	scheme.pop_back();
+
+	vector<string> parts = sh::splitBy(scheme, ",");
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		vector<string> tuple = sh::splitBy(parts[i], ":");
+		colNames.push_back(tuple[0]);
+		colNameType.insert({ tuple[0], tuple[1] });
+	}
+	return colNameType;
+}
+
+vector<unordered_map<string, TypeWrapper>> Connection::getColNameValues(string values, unordered_map<string, string>& scheme, unordered_map<size_t, string>& indexColumn)
+{
+	vector<unordered_map<string, TypeWrapper>> result;
+	values.erase(values.begin());
+	values.pop_back();
+
+	vector<string> parts = sh::splitBy(values, ", ");
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		sh::trim(parts[i]);
+		parts[i].erase(parts[i].begin());
+		parts[i].pop_back();
+
+		vector<string> splitRecord = sh::splitBy(parts[i], ",");
+		if (splitRecord.size() != scheme.size())
+			throw invalid_argument("Passed number of columns and table's number of columns are mismatching. Please check the record you are about to insert.");
+
+		unordered_map<string, TypeWrapper> colVal;
+		for (size_t j = 0; j < splitRecord.size(); j++)
+		{
+			string colName = indexColumn[j];
+			string colType = scheme[colName];
+
+			if (sh::isCorrectColumnType(colType, splitRecord[j]))
+			{
+				if (colType == "Integer")
+					colVal.insert({ colName, TypeWrapper(stoi(splitRecord[j])) });
+				else if (colType == "Double")
+					colVal.insert({ colName, TypeWrapper(stod(splitRecord[j])) });
+				else if (colType == "String")
+					colVal.insert({ colName, TypeWrapper(splitRecord[j]) });
+			}
+			else
+			{
+				throw invalid_argument("Invalid type for column {" + colName + "} with value {" + splitRecord[j] + "}");
+			}
+		}
+		result.push_back(colVal);
+	}
+	return result;
+}
+
+ResultSet Connection::selectJoin(const CommandParser& cp)
+{
+	Table& left = fDataBase->getTable(cp.atToken(3));
+	Table& right = fDataBase->getTable(cp.atToken(5));
+	if (cp.size() <= 7 || sh::toUpper(cp.atToken(6)) != "ON")
+		throw invalid_argument("JOIN needs a condition ON {column1} = {column2}");
+
+	// The ON condition runs until the WHERE clause, with or without spaces around '='
+	string on, where;
+	for (size_t i = 7; i < cp.size(); i++)
+	{
+		const string& token = cp.atToken(i);
+		if (token.rfind("WHERE", 0) == 0)
+		{
+			where = token;
+			break;
+		}
+		if (token == "ORDER" || token == "DISTINCT")
+			break;
+
+		on += token;
+	}
+
+	size_t equalSign = on.find('=');
+	if (equalSign == string::npos)
+		throw invalid_argument("JOIN needs a condition ON {column1} = {column2}");
+
+	Join join(left, right, on.substr(0, equalSign), on.substr(equalSign + 1));
+	Query query(where, join.getScheme(), "");
+	vector<Record> answer = join.execute(query);
+
+	vector<string> selectedColumns = sh::splitBy(cp.atToken(1), ",");
+	sh::removeEmptyStringsInVector(selectedColumns);
+	if (selectedColumns.size() == 1 && selectedColumns[0] == "*")
+		selectedColumns = join.getColumnNames();
+
+	for (const string& col : selectedColumns)
+		if (join.getColIndex().find(col) == join.getColIndex().end())
+			throw invalid_argument("There is no column with name {" + col + "} in the joined tables.");
+
+	if (cp.isDistinct())
+		answer = Table::distinct(answer, selectedColumns, join.getColIndex());
+	if (!cp.getOrderBy().empty())
+		join.orderBy(answer, cp.getOrderBy());
+
+	return ResultSet(selectedColumns, answer, join.getColIndex());
+}
+
+void Connection::parseSelect(const CommandParser& cp, size_t first, string& source, vector<string>& selectList, vector<string>& groupBy, string& where) const
+{
+	// The aggregates are split into their names and braces, so the selected items are all the tokens up to FROM
+	string items;
+	size_t from = first;
+	for (; from < cp.size() && sh::toUpper(cp.atToken(from)) != "FROM"; from++)
+		items += cp.atToken(from);
+
+	if (from + 1 >= cp.size())
+		throw invalid_argument("Select needs a table FROM which to select");
+
+	source = cp.atToken(from + 1);
+	for (size_t i = from + 2; i < cp.size(); i++)
+	{
+		if (cp.atToken(i).rfind("WHERE", 0) == 0)
+		{
+			where = cp.atToken(i);
+			break;
+		}
+	}
+
+	selectList = sh::splitBy(items, ",");
+	sh::removeEmptyStringsInVector(selectList);
+	groupBy = sh::splitBy(cp.getGroupBy(), ",");
+	sh::removeEmptyStringsInVector(groupBy);
+}
+
+ResultSet Connection::selectAggregate(const CommandParser& cp)
+{
+	string tableName, where;
+	vector<string> selectList, groupBy;
+	parseSelect(cp, 1, tableName, selectList, groupBy, where);
+
+	Table& target = fDataBase->getTable(tableName);
+	HashAggregate aggregate(target, selectList, groupBy);
+	Query query(where, target.getTableScheme(), target.getPrimaryKey());
+	vector<Record> answer = aggregate.execute(query);
+	if (!cp.getOrderBy().empty())
+		aggregate.orderBy(answer, cp.getOrderBy());
+
+	return ResultSet(aggregate.getColumnNames(), answer, aggregate.getColIndex());
+}
+
+ResultSet Connection::selectView(const CommandParser& cp)
+{
+	string viewName, where;
+	vector<string> selectedColumns, groupBy;
+	parseSelect(cp, 1, viewName, selectedColumns, groupBy, where);
+	if (!groupBy.empty())
+		throw invalid_argument("A view is already grouped, it can't be grouped again");
+
+	const MaterializedView& view = fDataBase->getView(viewName);
+	if (selectedColumns.size() == 1 && selectedColumns[0] == "*")
+		selectedColumns = view.getColumnNames();
+
+	for (const string& col : selectedColumns)
+		if (view.getColIndex().find(col) == view.getColIndex().end())
+			throw invalid_argument("There is no column with name {" + col + "} in view " + viewName + ".");
+
+	vector<Record> answer = view.getRecords();
+	if (!where.empty())
+	{
+		// The columns of a view may be aggregates, whose names got split from their braces: COUNT (*) -> COUNT(*)
+		for (size_t pos = where.find(" ("); pos != string::npos; pos = where.find(" (", pos + 1))
+			if (pos > 0 && isalnum(where[pos - 1]) && pos + 2 < where.size() && where[pos + 2] != ' ')
+				where.erase(pos, 1);
+
+		Query query(where, view.getScheme(), "");
+		vector<Query::Step> steps = query.resolve(view.getColIndex());
+		answer.erase(std::remove_if(answer.begin(), answer.end(), [&](const Record& r) {
+			return !query.checkRecordAgainstQuery(r, steps);
+			}), answer.end());
+	}
+
+	if (cp.isDistinct())
+		answer = Table::distinct(answer, selectedColumns, view.getColIndex());
+	if (!cp.getOrderBy().empty())
+		view.orderBy(answer, cp.getOrderBy());
+
+	return ResultSet(selectedColumns, answer, view.getColIndex());
+}
+
+bool Connection::isPlainSelect(const CommandParser& cp) const
+{
+	size_t from = 1;
+	while (from < cp.size() && sh::toUpper(cp.atToken(from)) != "FROM")
+		from++;
+
+	if (from + 1 < cp.size() && fDataBase->hasView(cp.atToken(from + 1)))
+		return false;
+	if (cp.size() > 4 && sh::toUpper(cp.atToken(4)) == "JOIN")
+		return false;
+	if (!cp.getGroupBy().empty())
+		return false;
+
+	for (size_t i = 1; i < from; i++)
+		if (cp.atToken(i)[0] == '(')
+			return false;
+
+	return true;
+}
+
+PlanCache::Plan Connection::compile(const CommandParser& cp)
+{
+	PlanCache::Plan plan;
+	plan.command = cp;
+
+	string where;
+	if (cp.getCommandType() == CommandType::SELECT && isPlainSelect(cp))
+	{
+		plan.table = cp.atToken(3);
+		where = cp.size() > 4 ? cp.atToken(4) : "";
+	}
+	else if (cp.getCommandType() == CommandType::REMOVE)
+	{
+		plan.table = cp.atToken(2);
+		where = cp.atToken(3);
+	}
+	else
+		throw invalid_argument("Only Select and Remove statements on a table can be prepared.");
+
+	Table& target = fDataBase->getTable(plan.table);
+	plan.query.emplace(where, target.getTableScheme(), target.getPrimaryKey());
+	return plan;
+}
+
+ResultSet Connection::execute(PlanCache::Plan& plan)
+{
+	const CommandParser& cp = plan.command;
+	Table& target = fDataBase->getTable(plan.table);
+	if (cp.getCommandType() == CommandType::REMOVE)
+	{
+		int deleted = fDataBase->remove(plan.table, *plan.query);
+		return ResultSet(CommandType::REMOVE, "Total " + std::to_string(deleted) + " rows deleted from " + plan.table, deleted);
+	}
+
+	vector<string> selectedColumns = sh::splitBy(cp.atToken(1), ",");
+	if (selectedColumns.size() == 1 && selectedColumns[0] == "*")
+	{
+		selectedColumns = sh::splitBy(target.getTableHeader(), ",");
+		sh::removeEmptyStringsInVector(selectedColumns);
+	}
+
+	vector<Record> answer = target.select(*plan.query, cp.getOrderBy(), cp.isDistinct(), selectedColumns);
+	return ResultSet(selectedColumns, answer, target.getColIndex());
+}
+
+vector<string> Connection::splitArguments(const string& arguments) const
+{
+	if (arguments.size() < 2 || arguments.front() != '(' || arguments.back() != ')')
+		throw invalid_argument("Expected Execute {name} (value1, value2..)");
+
+	vector<string> result;
+	string current;
+	bool inQuotes = false;
+	for (size_t i = 1; i + 1 < arguments.size(); i++)
+	{
+		if (arguments[i] == '"')
+			inQuotes = !inQuotes;
+
+		if (arguments[i] == ',' && !inQuotes)
+		{
+			sh::trim(current);
+			result.push_back(current);
+			current.clear();
+		}
+		else
+			current += arguments[i];
+	}
+
+	sh::trim(current);
+	if (!current.empty() || !result.empty())
+		result.push_back(current);
+
+	return result;
+}
+
+string Connection::describeTable(const string& tableName)
+{
+	Table& t = fDataBase->getTable(tableName);
+	string header = t.getTableHeader();
+	sh::trim(header);
+
+	vector<string> cols = sh::splitBy(header, ",");
+	sh::removeEmptyStringsInVector(cols);
+
+	string scheme = "(";
+	for (const string& name : cols)
+		scheme += name + ":" + t.getTableScheme().at(name) + ", ";
+
+	scheme += ") " + (t.getPrimaryKey().empty() ? "No Index on this table" :
+		((t.getIndexType() == IndexType::HASH ? "Hash Index ON " : "Index ON ") + t.getPrimaryKey()));
+	if (!t.getBloomColumns().empty())
+	{
+		scheme += ", Bloom filters ON ";
+		for (size_t i = 0; i < t.getBloomColumns().size(); i++)
+			scheme += (i > 0 ? ", " : "") + t.getBloomColumns()[i];
+	}
+	if (t.isSingleFile())
+		scheme += ", pages in one file";
+
+	string size = t.getBytesData() < 1024 ? std::to_string(t.getBytesData()) + " B" : std::to_string(t.getBytesData() / 1024) + " KB";
+	return "Table " + tableName + " : " + scheme + "\n(" + size + " data) in the table";
+}
+
+ResultSet Connection::listTables()
+{
+	vector<string> columns{ "Name", "Table" };
+	unordered_map<string, size_t> colIndex{ { "Name", 0 }, { "Table", 1 } };
+	vector<Record> rows;
+	for (const string& name : fDataBase->getTableNames())
+	{
+		Record r(columns.size());
+		r.addValue(TypeWrapper(name));
+		r.addValue(TypeWrapper());
+		rows.push_back(r);
+	}
+	for (const string& name : fDataBase->getViewNames())
+	{
+		Record r(columns.size());
+		r.addValue(TypeWrapper(name));
+		r.addValue(TypeWrapper(fDataBase->getViewTableName(name)));
+		rows.push_back(r);
+	}
+
+	return ResultSet(columns, rows, colIndex, CommandType::LIST_TABLES);
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+#include<memory>
+#include<sstream>
+#include<iomanip>
+#include<limits>
+#include<cmath>
+#include<algorithm>
+#include "DataBase.h"
+#include "CommandParser.hpp"
+#include "Join.hpp"
+#include "HashAggregate.hpp"
+#include "PlanCache.hpp"
+#include "ResultSet.hpp"
+
+using std::unique_ptr;
+
+class Connection;
+
+/**
+ * @brief Descriptor of a statement parsed once and run many times with different values - a Select or a Remove whose
+ * WHERE clause has ? in place of values (Select * FROM t WHERE ID = ?). The values are bound by their position, from 0.
+*/
+class PreparedStatement
+{
+public:
+	size_t getParametersCount() const { return fPlan.query->getParametersCount(); }
+
+	PreparedStatement& bind(size_t index, int value) { return bindText(index, std::to_string(value)); }
+
+	/**
+	 * @brief The value is written in fixed notation, as the parser doesn't read exponents, with enough digits
+	 * to be read back as the same double
+	*/
+	PreparedStatement& bind(size_t index, double value)
+	{
+		if (!std::isfinite(value))
+			throw invalid_argument("Only finite values can be bound.");
+
+		int exponent = value == 0 ? 0 : (int)std::floor(std::log10(std::fabs(value)));
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(std::max(1, std::numeric_limits<double>::max_digits10 - 1 - exponent)) << value;
+		return bindText(index, text.str());
+	}
+
+	/**
+	 * @param value - the string, without quotes
+	*/
+	PreparedStatement& bind(size_t index, const string& value) { return bindText(index, "\"" + value + "\""); }
+
+	PreparedStatement& bind(size_t index, const char* value) { return bind(index, string(value)); }
+
+	/**
+	 * @brief Run the statement with the bound values, throws invalid_argument if some value isn't bound or doesn't
+	 * match the type of its column
+	*/
+	ResultSet execute();
+
+private:
+	friend class Connection;
+
+	PreparedStatement(Connection& connection, PlanCache::Plan plan)
+		: fConnection(&connection), fPlan(std::move(plan)), fValues(fPlan.query->getParametersCount()) {}
+
+	PreparedStatement& bindText(size_t index, const string& value)
+	{
+		if (index >= fValues.size())
+			throw out_of_range("The statement has " + std::to_string(fValues.size()) + " parameters.");
+
+		fValues[index] = value;
+		return *this;
+	}
+
+	Connection* fConnection;
+	PlanCache::Plan fPlan;
+	vector<string> fValues;
+};
+
+/**
+ * @brief Descriptor of an open database, the way into the engine for a program: the statements are given as text
+ * and their results come back as typed values, nothing is printed. The console is a client of it too.
+ * Errors in the statements are thrown as invalid_argument or out_of_range, with the database left as it was.
+*/
+class Connection
+{
+public:
+	/**
+	 * @brief Open a database, creating it if it doesn't exist
+	 * @param directory - directory of the database, i.e. DB/
+	 * @param name - name of the database
+	*/
+	Connection(const string& directory, const string& name = "FMISql");
+
+	/**
+	 * @brief Like the constructor, for the programs that keep the connection on the heap
+	*/
+	static unique_ptr<Connection> open(const string& directory, const string& name = "FMISql");
+
+	Connection(const Connection& other) = delete;
+	Connection& operator=(const Connection& other) = delete;
+
+	/**
+	 * @brief Commit an open batch and save the database
+	*/
+	~Connection();
+
+	/**
+	 * @brief Run one statement, in the same language as the console
+	 * @param statement - the text of the statement
+	 * @return the selected rows of a Select, the message of the other statements
+	*/
+	ResultSet execute(const string& statement);
+
+	/**
+	 * @brief Parse a Select or a Remove with ? values, to be run later with bound values
+	*/
+	PreparedStatement prepare(const string& statement);
+
+	/**
+	 * @brief Commit an open batch and save the database. Exit does it too, no statement may run after it
+	*/
+	void close();
+
+	bool isClosed() const { return fClosed; }
+
+	/**
+	 * @brief In script mode the statements always run in a batch: BEGIN does nothing and COMMIT starts the next batch
+	*/
+	void setScriptMode(bool enabled);
+
+	/**
+	 * @brief Prepare and Execute use the named statements of the current session, so the clients of a server that share
+	 * the connection don't see or replace each other's statements. The console and the programs stay in session 0.
+	 * @param session - the session whose statements run next
+	*/
+	void setSession(uint64_t session) { fSession = session; }
+
+	/**
+	 * @brief Forget the statements prepared by an ended session and commit the batch it started. If the batch can't be
+	 * written it stays open, and any session may COMMIT it
+	*/
+	void endSession(uint64_t session);
+
+	DataBase& getDataBase() { return *fDataBase; }
+
+private:
+	friend class PreparedStatement;
+
+	unique_ptr<DataBase> fDataBase;
+	/// The plans of the Select and Remove statements run last, by their text
+	PlanCache fPlans;
+	/// The statements made by Prepare, by their sessions and their names
+	unordered_map<uint64_t, unordered_map<string, PlanCache::Plan>> fPrepared;
+	uint64_t fSession;
+	/// The session that started the open batch, only it may COMMIT it
+	uint64_t fBatchSession;
+	/// fBatchSession of a batch whose session ended before it could be committed
+	static constexpr uint64_t ORPHANED_BATCH = UINT64_MAX;
+	bool fClosed, fScriptMode;
+
+	ResultSet run(const string& statement);
+
+	/**
+	 * @brief By given string of form ({columnName}:{columnType}) convert it into hashtable
+	 * @param scheme - stringified table scheme
+	 * @return hashtable where each key is column name and value is column data type
+	*/
+	unordered_map<string, string> getColNameType(string scheme, vector<string>& colNames);
+
+	/**
+	 * @brief By given record in form {({DataType}, {DataType}, {DataType})} where each datatype corresponds to a column
+	 * check if it satisfies the table's scheme, after which insert it into the desired table
+	 * @param values - stringified values to be inserted
+	 * @return vector of hashtables, each hashtable corresponding to one record that the user will be inserting
+	*/
+	vector<unordered_map<string, TypeWrapper>> getColNameValues(string values, unordered_map<string, string>& scheme, unordered_map<size_t, string>& indexColumn);
+
+	/**
+	 * @brief Execute a command of form Select {columnNames} FROM {tableName} JOIN {tableName} ON {column} = {column} WHERE ..
+	 * @param cp - the parsed command
+	*/
+	ResultSet selectJoin(const CommandParser& cp);
+
+	/**
+	 * @brief Execute a command of form Select {columnNames}, {aggregates} FROM {tableName} WHERE .. GROUP BY {columnNames}
+	 * @param cp - the parsed command
+	*/
+	ResultSet selectAggregate(const CommandParser& cp);
+
+	/**
+	 * @brief Execute a command of form Select {columnNames} FROM {viewName} WHERE .. ORDER BY {columnName}
+	 * @param cp - the parsed command
+	*/
+	ResultSet selectView(const CommandParser& cp);
+
+	/**
+	 * @brief Split a command of form .. {items} FROM {source} WHERE .. GROUP BY {columnNames} into its parts
+	 * @param first - index of the token of the first selected item
+	 * @param source - set to the name of the table or the view after FROM
+	 * @param selectList - set to the selected items
+	 * @param groupBy - set to the grouping columns, empty without GROUP BY
+	 * @param where - set to the WHERE clause, empty without it
+	*/
+	void parseSelect(const CommandParser& cp, size_t first, string& source, vector<string>& selectList, vector<string>& groupBy, string& where) const;
+
+	/**
+	 * @return True for a Select of columns of one table, not of a view, a join or aggregates
+	*/
+	bool isPlainSelect(const CommandParser& cp) const;
+
+	/**
+	 * @brief Parse a Select {columnNames} FROM {tableName} WHERE .. or a Remove FROM {tableName} WHERE .. into a plan that can be run
+	 * many times. Throws invalid_argument for the other statements
+	 * @param cp - the parsed command
+	*/
+	PlanCache::Plan compile(const CommandParser& cp);
+
+	/**
+	 * @brief Run a plan made by compile
+	*/
+	ResultSet execute(PlanCache::Plan& plan);
+
+	/**
+	 * @brief Split the values of Execute {name} (value1, value2..), commas inside strings are kept
+	*/
+	vector<string> splitArguments(const string& arguments) const;
+
+	/**
+	 * @return the description of a table shown by TableInfo
+	*/
+	string describeTable(const string& tableName);
+
+	/**
+	 * @return one row per table and view: its name and, for a view, the name of its table
+	*/
+	ResultSet listTables();
+};
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#if defined(_M_X64)
+#include<intrin.h>
+#include<nmmintrin.h>
+#define CRC32C_SSE42
+#elif defined(__x86_64__)
+#include<cpuid.h>
+#include<nmmintrin.h>
+#define CRC32C_SSE42
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include<arm_acle.h>
+#define CRC32C_ARM
+#endif
+
+/**
+ * @brief CRC-32C (Castagnoli) checksums of the files of the database. The crc32 instructions of SSE 4.2 or ARMv8 are used
+ * when the processor has them, otherwise a slicing-by-8 table computes 8 bytes per step.
+*/
+class Crc32c
+{
+public:
+	/**
+	 * @param data - the bytes to checksum
+	 * @param size - number of bytes
+	 * @return the checksum of the bytes
+	*/
+	static uint32_t compute(const char* data, size_t size)
+	{
+		uint32_t crc = 0xFFFFFFFFu;
+#if defined(CRC32C_SSE42)
+		static const bool hardware = hasSse42();
+		crc = hardware ? computeSse42(crc, data, size) : computeTable(crc, data, size);
+#elif defined(CRC32C_ARM)
+		crc = computeArm(crc, data, size);
+#else
+		crc = computeTable(crc, data, size);
+#endif
+		return ~crc;
+	}
+
+	/// Starts a metadata file that carries a checksum, it is followed by the checksum of the rest of the file
+	static constexpr char FILE_MAGIC[8] = { 'F', 'M', 'I', 'C', 'R', 'C', '3', '2' };
+	static constexpr size_t FILE_HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(uint32_t);
+
+private:
+	static constexpr uint32_t POLYNOMIAL = 0x82F63B78u;
+
+	static uint32_t computeTable(uint32_t crc, const char* data, size_t size)
+	{
+		static const Tables tables;
+		const unsigned char* bytes = (const unsigned char*)data;
+		while (size >= 8)
+		{
+			uint32_t low = 0, high = 0;
+			std::memcpy(&low, bytes, sizeof(low));
+			std::memcpy(&high, bytes + sizeof(low), sizeof(high));
+			low ^= crc;
+			crc = tables.t[7][low & 0xFF] ^ tables.t[6][(low >> 8) & 0xFF] ^ tables.t[5][(low >> 16) & 0xFF] ^ tables.t[4][low >> 24] ^
+				tables.t[3][high & 0xFF] ^ tables.t[2][(high >> 8) & 0xFF] ^ tables.t[1][(high >> 16) & 0xFF] ^ tables.t[0][high >> 24];
+			bytes += 8;
+			size -= 8;
+		}
+
+		while (size-- > 0)
+			crc = tables.t[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+
+		return crc;
+	}
+
+	/**
+	 * @brief t[0] is the table of one byte, t[k] advances a byte over k more zero bytes
+	*/
+	struct Tables
+	{
+		uint32_t t[8][256];
+
+		Tables()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+					crc = (crc >> 1) ^ (crc & 1 ? POLYNOMIAL : 0);
+				t[0][i] = crc;
+			}
+
+			for (int k = 1; k < 8; k++)
+				for (uint32_t i = 0; i < 256; i++)
+					t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+		}
+	};
+
+#if defined(CRC32C_SSE42)
+	static bool hasSse42()
+	{
+#if defined(_M_X64)
+		int info[4] = {};
+		__cpuid(info, 1);
+		return (info[2] >> 20) & 1;
+#else
+		unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && ((ecx >> 20) & 1);
+#endif
+	}
+
+#if !defined(_M_X64)
+	__attribute__((target("sse4.2")))
+#endif
+	static uint32_t computeSse42(uint32_t crc, const char* data, size_t size)
+	{
+		uint64_t crc64 = crc;
+		while (size >= 8)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, data, sizeof(word));
+			crc64 = _mm_crc32_u64(crc64, word);
+			data += 8;
+			size -= 8;
+		}
+
+		crc = (uint32_t)crc64;
+		while (size-- > 0)
+			crc = _mm_crc32_u8(crc, (unsigned char)*data++);
+
+		return crc;
+	}
+#endif
+
+#if defined(CRC32C_ARM)
+	static uint32_t computeArm(uint32_t crc, const char* data, size_t size)
+	{
+		while (size >= 8)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, data, sizeof(word));
+			crc = __crc32cd(crc, word);
+			data += 8;
+			size -= 8;
+		}
+
+		while (size-- > 0)
+			crc = __crc32cb(crc, (unsigned char)*data++);
+
+		return crc;
+	}
+#endif
+};
\ No newline at end of file
@@ -1,24 +1,60 @@
 #include "DataBase.h"
+#include <algorithm>
 
-DataBase::DataBase(ifstream& in)
+DataBase::DataBase(BinaryReader& in, size_t prefetchedTables)
 {
-	fh::readString(in, fDBName);
-	fh::readString(in, fDBPath);
+	in.readString(fDBName);
+	in.readString(fDBPath);
 
 	size_t size = 0;
-	in.read((char*)&size, sizeof(size));
+	in.read(size);
 	for (size_t i = 0; i < size; i++)
 	{
 		string first, second;
-		fh::readString(in, first);
-		fh::readString(in, second);
+		in.readString(first);
+		in.readString(second);
 
-		ifstream tableReader(second + first + ".bin", std::ios::binary);
-		if (!tableReader.is_open())
-			throw invalid_argument("Couldn't open " + second + " path for reading. Check for file corruption!");
+		// The file of the table is read on the first access to it
+		fTables[first].path = second;
+	}
+
+	size_t nextTxnId = 1;
+	in.read(nextTxnId);
+	TransactionManager::getInstance().setNextTxnId(nextTxnId);
+
+	// Databases saved before the views were added end here
+	size_t views = 0;
+	if (!in.eof())
+		in.read(views);
+
+	// The groups of a view are read with its table, on the first access to it
+	for (size_t i = 0; i < views; i++)
+	{
+		ViewSlot slot;
+		in.readString(slot.tableName);
+		slot.definition = MaterializedView::Definition::read(in);
+		string viewName = slot.definition.name;
+		fViews.emplace(viewName, std::move(slot));
+	}
+
+	// ...and so do the ones saved before the uses of the tables were counted
+	size_t countedTables = 0;
+	if (!in.eof())
+		in.read(countedTables);
+
+	for (size_t i = 0; i < countedTables; i++)
+	{
+		string tableName;
+		size_t uses = 0;
+		in.readString(tableName);
+		in.read(uses);
 
-		fTables.insert({ first, Table(tableReader) });
+		auto it = fTables.find(tableName);
+		if (it != fTables.end())
+			it->second.uses += uses;
 	}
+
+	prefetch(prefetchedTables);
 }
 
 DataBase::DataBase(const string& name, const string& path)
@@ -29,79 +65,420 @@ DataBase::DataBase(const string& name, const string& path)
 	save();
 }
 
-void DataBase::createTable(const string& path, const string& tableName, unordered_map<string, string>& colNameType, vector<string>& colNames, const string primaryKey, int maxRecordsPerPage)
+DataBase::~DataBase()
 {
-	if (fTables.find(tableName) != fTables.end())
+	finishPrefetch();
+}
+
+void DataBase::createTable(const string& path, const string& tableName, unordered_map<string, string>& colNameType, vector<string>& colNames, const string primaryKey, IndexType indexType, int maxRecordsPerPage)
+{
+	if (fTables.find(tableName) != fTables.end() || hasView(tableName))
 		throw invalid_argument("There is already a table with this name in the system");
 
-	Table t(fDBPath, tableName, colNameType, colNames, primaryKey, maxRecordsPerPage);
-	fTables[tableName] = t;
+	unique_ptr<Table> table = std::make_unique<Table>(fDBPath, tableName, colNameType, colNames, primaryKey, indexType, maxRecordsPerPage);
+	table->setSavesDeferred(fInBatch);
+
+	TableSlot& slot = fTables[tableName];
+	slot.path = table->getTablePath();
+	slot.uses = 1;
+	slot.usedInSession = true;
+	std::call_once(slot.loaded, [&]() {
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		slot.table = std::move(table);
+	});
 	save();
 }
 
 void DataBase::dropTable(const string& tableName)
 {
-	string pathToDelete = getTable(tableName).getTablePath();
+	auto slot = fTables.find(tableName);
+	if (slot == fTables.end())
+		throw invalid_argument("There is no such table!");
+
+	// The table may be being read in the background
+	finishPrefetch();
+	string pathToDelete = slot->second.path;
+	for (const pair<const string, ViewSlot>& entry : fViews)
+		if (entry.second.tableName == tableName)
+			throw invalid_argument("View " + entry.first + " is defined over table " + tableName + ", drop it first");
+
+	// An open file can't be removed on Windows, the page file of the table is closed first
+	bool hadPageFile = BufferPool::getInstance().unmount(pathToDelete) != nullptr;
 	std::error_code errorCode;
 	if (!fs::remove_all(pathToDelete, errorCode))
+	{
+		if (hadPageFile)
+			BufferPool::getInstance().mount(pathToDelete, std::make_shared<PageFile>(slot->second.table->getPageFilePath()));
+
 		throw logic_error(errorCode.message());
+	}
 
+	BufferPool::getInstance().forgetDirectory(pathToDelete);
 	fTables.erase(tableName);
 	save();
 }
 
+void DataBase::createView(const string& viewName, const string& tableName, const vector<string>& selectList, const vector<string>& groupBy, const string& where)
+{
+	if (fTables.find(viewName) != fTables.end() || hasView(viewName))
+		throw invalid_argument("There is already a table or a view with this name in the system");
+
+	Table& table = getTable(tableName);
+	unique_ptr<MaterializedView> view = std::make_unique<MaterializedView>(viewName, fDBPath, table, selectList, groupBy, where);
+	view->build();
+	view->save();
+
+	MaterializedView* stored = view.get();
+	{
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		fViews.emplace(viewName, ViewSlot{ tableName, stored->getDefinition(), std::move(view) });
+	}
+	table.addChangeListener(viewName, [stored](const Record& r, int sign) { stored->apply(r, sign); });
+	save();
+}
+
+void DataBase::dropView(const string& viewName)
+{
+	auto it = fViews.find(viewName);
+	if (it == fViews.end())
+		throw invalid_argument("There is no such view!");
+
+	// The view is read with its table if it wasn't yet, then it stops listening to it
+	getTable(it->second.tableName).removeChangeListener(viewName);
+	it->second.view->removeFile();
+	{
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		fViews.erase(it);
+	}
+	save();
+}
+
+const MaterializedView& DataBase::getView(const string& name)
+{
+	auto it = fViews.find(name);
+	if (it == fViews.end())
+		throw invalid_argument("There is no such view!");
+
+	getTable(it->second.tableName);
+	return *it->second.view;
+}
+
+const string& DataBase::getViewTableName(const string& name) const
+{
+	auto it = fViews.find(name);
+	if (it == fViews.end())
+		throw invalid_argument("There is no such view!");
+
+	return it->second.tableName;
+}
+
 void DataBase::insert(const string& tableName, vector<unordered_map<string, TypeWrapper>> colNameValueList)
 {
-	for (size_t i = 0; i < colNameValueList.size(); i++)
-		getTable(tableName).insert(colNameValueList[i]);
+	Transaction txn;
+	getTable(tableName).insert(colNameValueList, txn);
+	txn.commit();
+
+	if (fInBatch)
+		return;
 
+	saveViews();
 	save();
 }
 
 int DataBase::remove(const string& tableName, Query& query)
 {
-	int deletedRecords = getTable(tableName).deleteRecord(query);
+	Transaction txn;
+	int deletedRecords = getTable(tableName).deleteRecord(query, txn);
+	txn.commit();
+
+	if (!fInBatch)
+	{
+		saveViews();
+		save();
+	}
 
-	save();
 	return deletedRecords;
 }
 
+void DataBase::begin()
+{
+	if (fInBatch)
+		throw invalid_argument("A batch is already started, COMMIT it first");
 
-void DataBase::listTables() const
+	std::lock_guard<std::mutex> lock(fTablesMutex);
+	fInBatch = true;
+	BufferPool::getInstance().setWriteBack(true);
+	for (pair<const string, TableSlot>& entry : fTables)
+		if (entry.second.table)
+			entry.second.table->setSavesDeferred(true);
+}
+
+void DataBase::commit()
 {
-	for (const pair<string, Table>& entry : fTables)
-		std::cout << "\t-" << entry.first << "\n";
+	if (!fInBatch)
+		throw invalid_argument("There is no batch to commit, start one with BEGIN");
+
+	{
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		fInBatch = false;
+	}
+	BufferPool::getInstance().setWriteBack(false);
+	if (!BufferPool::getInstance().flush())
+	{
+		// The batch stays open with the pages that weren't written still held back, so COMMIT can be run again
+		BufferPool::getInstance().setWriteBack(true);
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		fInBatch = true;
+		throw logic_error("Couldn't write the pages changed by the batch, COMMIT can be run again");
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		for (pair<const string, TableSlot>& entry : fTables)
+			if (entry.second.table)
+				entry.second.table->setSavesDeferred(false);
+	}
+
+	saveViews();
+	save();
+}
+
+
+size_t DataBase::vacuum()
+{
+	size_t horizon = TransactionManager::getInstance().getVacuumHorizon();
+	size_t reclaimed = 0;
+
+	// The tables that weren't read have nothing in memory to reclaim yet
+	std::lock_guard<std::mutex> lock(fTablesMutex);
+	for (pair<const string, TableSlot>& entry : fTables)
+	{
+		Table* table = entry.second.table.get();
+		if (!table)
+			continue;
+
+		reclaimed += table->vacuum(horizon);
+		if (table->needsCompaction())
+			table->compact(horizon);
+	}
+
+	return reclaimed;
+}
+
+size_t DataBase::compactTable(const string& tableName)
+{
+	return getTable(tableName).compact(TransactionManager::getInstance().getVacuumHorizon());
+}
+
+void DataBase::repairTable(const string& tableName, const vector<int>& damagedPages, const vector<int>& damagedBlooms)
+{
+	getTable(tableName).repair(damagedPages, damagedBlooms, TransactionManager::getInstance().getVacuumHorizon());
+
+	// The records of the damaged pages are gone without the views hearing of it, so they are counted again
+	for (pair<const string, ViewSlot>& entry : fViews)
+		if (entry.second.tableName == tableName)
+		{
+			entry.second.view->build();
+			entry.second.view->save();
+		}
+}
+
+void DataBase::setAutoVacuum(const string& tableName, double ratio)
+{
+	getTable(tableName).setAutoVacuumRatio(ratio);
+}
+
+void DataBase::setBloomFilter(const string& tableName, const string& colName, bool enabled)
+{
+	getTable(tableName).setBloomFilter(colName, enabled);
+}
+
+void DataBase::setSingleFile(const string& tableName, bool enabled)
+{
+	getTable(tableName).setSingleFile(enabled);
+}
+
+vector<string> DataBase::getTableNames() const
+{
+	vector<string> names;
+	for (const pair<const string, TableSlot>& entry : fTables)
+		names.push_back(entry.first);
+
+	return names;
+}
+
+vector<string> DataBase::getViewNames() const
+{
+	vector<string> names;
+	for (const pair<const string, ViewSlot>& entry : fViews)
+		names.push_back(entry.first);
+
+	return names;
 }
 
 Table& DataBase::getTable(const string& name)
 {
-	if (fTables.find(name) == fTables.end())
+	auto it = fTables.find(name);
+	if (it == fTables.end())
 		throw invalid_argument("There is no such table!");
 
-	return fTables[name];
+	TableSlot& slot = it->second;
+	if (!slot.usedInSession)
+	{
+		slot.usedInSession = true;
+		slot.uses++;
+	}
+
+	return load(name, slot);
 }
 
-void DataBase::save() const
+size_t DataBase::getLoadedTablesCount() const
 {
-	ofstream out(fDBPath + fDBName + ".bin", std::ios::binary);
-	if (!out.is_open())
-		throw exception("Couldn't open file to save Database");
+	std::lock_guard<std::mutex> lock(fTablesMutex);
+	size_t loaded = 0;
+	for (const pair<const string, TableSlot>& entry : fTables)
+		loaded += entry.second.table ? 1 : 0;
+
+	return loaded;
+}
 
-	fh::writeString(out, fDBName);
-	fh::writeString(out, fDBPath);
+Table& DataBase::load(const string& name, TableSlot& slot)
+{
+	// A second caller waits for the first one, a failed read is tried again by the next caller
+	std::call_once(slot.loaded, [&]() {
+		BinaryReader tableReader(slot.path + name + ".bin");
+		if (!tableReader.isOpen())
+			throw invalid_argument("Couldn't open " + slot.path + " path for reading. Check for file corruption!");
+
+		unique_ptr<Table> table = std::make_unique<Table>(tableReader);
+		vector<pair<string, unique_ptr<MaterializedView>>> views = openViews(name, *table);
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		table->setSavesDeferred(fInBatch);
+		for (pair<string, unique_ptr<MaterializedView>>& view : views)
+		{
+			MaterializedView* stored = view.second.get();
+			table->addChangeListener(view.first, [stored](const Record& r, int sign) { stored->apply(r, sign); });
+			fViews.at(view.first).view = std::move(view.second);
+		}
+
+		slot.table = std::move(table);
+	});
+
+	return *slot.table;
+}
+
+vector<pair<string, unique_ptr<MaterializedView>>> DataBase::openViews(const string& tableName, Table& table)
+{
+	vector<MaterializedView::Definition> definitions;
+	{
+		std::lock_guard<std::mutex> lock(fTablesMutex);
+		for (const pair<const string, ViewSlot>& entry : fViews)
+			if (entry.second.tableName == tableName)
+				definitions.push_back(entry.second.definition);
+	}
+
+	vector<pair<string, unique_ptr<MaterializedView>>> views;
+	for (const MaterializedView::Definition& definition : definitions)
+	{
+		unique_ptr<MaterializedView> view = std::make_unique<MaterializedView>(definition, fDBPath, table);
+		if (!view->load())
+		{
+			view->build();
+			view->save();
+		}
+
+		views.emplace_back(definition.name, std::move(view));
+	}
+
+	return views;
+}
+
+void DataBase::prefetch(size_t count)
+{
+	vector<pair<const string, TableSlot>*> hottest;
+	for (pair<const string, TableSlot>& entry : fTables)
+		if (entry.second.uses > 0)
+			hottest.push_back(&entry);
+
+	std::sort(hottest.begin(), hottest.end(), [](const pair<const string, TableSlot>* a, const pair<const string, TableSlot>* b) {
+		return a->second.uses > b->second.uses;
+	});
+	if (hottest.size() > count)
+		hottest.resize(count);
+
+	if (hottest.empty())
+		return;
+
+	// The slots stay where they are until a table is dropped, and dropTable waits for the thread
+	fPrefetch = std::thread([this, hottest]() {
+		for (pair<const string, TableSlot>* entry : hottest)
+		{
+			try
+			{
+				load(entry->first, entry->second);
+			}
+			catch (const std::exception&)
+			{
+				// A table that can't be read is reported on the first access to it
+			}
+		}
+	});
+}
+
+void DataBase::finishPrefetch()
+{
+	if (fPrefetch.joinable())
+		fPrefetch.join();
+}
+
+void DataBase::save() const
+{
+	BinaryWriter out;
+	out.writeString(fDBName);
+	out.writeString(fDBPath);
 
 	size_t tablePathsSize = fTables.size();
-	out.write((char*)&tablePathsSize, sizeof(tablePathsSize));
-	for (const pair<string, Table>& entry : fTables)
+	out.write(tablePathsSize);
+	for (const pair<const string, TableSlot>& entry : fTables)
 	{
-		fh::writeString(out, entry.first);
-		fh::writeString(out, entry.second.getTablePath());
+		out.writeString(entry.first);
+		out.writeString(entry.second.path);
 	}
 
-	out.close();
+	size_t nextTxnId = TransactionManager::getInstance().getNextTxnId();
+	out.write(nextTxnId);
+
+	size_t views = fViews.size();
+	out.write(views);
+	for (const pair<const string, ViewSlot>& entry : fViews)
+	{
+		out.writeString(entry.second.tableName);
+		entry.second.definition.write(out);
+	}
+
+	size_t countedTables = fTables.size();
+	out.write(countedTables);
+	for (const pair<const string, TableSlot>& entry : fTables)
+	{
+		out.writeString(entry.first);
+		size_t uses = entry.second.uses;
+		out.write(uses);
+	}
+
+	if (!out.save(fDBPath + fDBName + ".bin"))
+		throw exception("Couldn't open file to save Database");
 }
 
 void DataBase::createDirectory() const
 {
 	fs::create_directories(fDBPath);
 }
+
+void DataBase::saveViews()
+{
+	// The views of the tables that weren't read yet didn't change
+	std::lock_guard<std::mutex> lock(fTablesMutex);
+	for (pair<const string, ViewSlot>& entry : fViews)
+		if (entry.second.view)
+			entry.second.view->save();
+}
@@ -1,22 +1,44 @@
 #pragma once
+#include<memory>
+#include<mutex>
+#include<thread>
 #include "Table.hpp"
+#include "MaterializedView.hpp"
 
+using std::unique_ptr;
+
+/**
+ * @brief Descriptor of the database: its tables and views. A table is only registered by its name and path when the
+ * database is opened, its file is read on the first access to it. The tables used by the most sessions before are
+ * read in the background meanwhile. The views over a table are read and start listening to its changes when the table is.
+*/
 class DataBase
 {
 public:
-	DataBase(ifstream& in);
+	/**
+	 * @brief Open a saved database
+	 * @param in - the file of the database
+	 * @param prefetchedTables - how many of the most used tables are read in the background, 0 for none
+	*/
+	DataBase(BinaryReader& in, size_t prefetchedTables = 8);
 
 	DataBase(const string& name, const string& path);
 
+	DataBase(const DataBase& other) = delete;
+	DataBase& operator=(const DataBase& other) = delete;
+
+	~DataBase();
+
 	/**
 	 * @brief Attempt to create a table with given name, column types and primary key
 	 * @param path - path of table on disk
 	 * @param tableName - name of table
 	 * @param colNameType - hashtable where against each column name we have a column type (Integer, String, Double)
 	 * @param primaryKey - the name of the indexed column
+	 * @param indexType - B+ tree for every comparison on the primary key, hash for equality only
 	 * @param maxRecordsPerPage - how many records we can keep in a page
 	*/
-	void createTable(const string& path, const string& tableName, unordered_map<string, string>& colNameType, vector<string>& colNames, const string primaryKey = "", int maxRecordsPerPage = 1024);
+	void createTable(const string& path, const string& tableName, unordered_map<string, string>& colNameType, vector<string>& colNames, const string primaryKey = "", IndexType indexType = IndexType::BPTREE, int maxRecordsPerPage = 1024);
 
 	/**
 	 * @brief Attempts to drop a table with given name, removing it from fTables and deleting the binary file of the table on the disk
@@ -24,6 +46,38 @@ public:
 	*/
 	void dropTable(const string& tableName);
 
+	/**
+	 * @brief Create a view aggregating a table and fill it with one scan of the table. From then on it is maintained
+	 * by the inserts into the table and the deletes from it.
+	 * @param viewName - name of the view, no table or view may have it
+	 * @param tableName - name of the aggregated table
+	 * @param selectList - the selected items: columns of the GROUP BY and aggregates
+	 * @param groupBy - the grouping columns, may be empty
+	 * @param where - the WHERE clause filtering the records of the table, empty for none
+	*/
+	void createView(const string& viewName, const string& tableName, const vector<string>& selectList, const vector<string>& groupBy, const string& where);
+
+	/**
+	 * @brief Drop a view and delete the file of its groups
+	 * @param viewName - name of view
+	*/
+	void dropView(const string& viewName);
+
+	/**
+	 * @return True if there is a view with this name
+	*/
+	bool hasView(const string& name) const { return fViews.find(name) != fViews.end(); }
+
+	/**
+	 * @return desired view by it's name, its table is read from its file if it wasn't yet
+	*/
+	const MaterializedView& getView(const string& name);
+
+	/**
+	 * @return the name of the table a view aggregates, without reading the table
+	*/
+	const string& getViewTableName(const string& name) const;
+
 	/**
 	 * @brief Attempts to insert an array of records in the table with name {tableName}
 	 * @param tableName - name of table
@@ -33,21 +87,97 @@ public:
 
 	int remove(const string& tableName, Query& query);
 
+	/**
+	 * @brief Start a batch of statements. Until commit the changed pages stay in the buffer pool and the tables, the views
+	 * and the database are not saved after every statement, so a batch of many inserts writes its files once.
+	 * The statements of the batch still see each other. Nothing of the batch is sure to be on the disk before commit.
+	*/
+	void begin();
+
+	/**
+	 * @brief End the batch started by begin, writing everything it changed. Throws logic_error if some page couldn't
+	 * be written, the batch is then still open and commit can be called again
+	*/
+	void commit();
+
+	/**
+	 * @return True between begin and commit
+	*/
+	bool isInBatch() const { return fInBatch; }
+
+	/**
+	 * @brief Reclaims the deleted record versions that no alive snapshot can see anymore, in all tables
+	 * @return the number of reclaimed versions
+	*/
+	size_t vacuum();
+
+	/**
+	 * @brief Rewrites the pages of a table densely, dropping its tombstones and merging its sparse pages
+	 * @param tableName - name of table
+	 * @return the number of freed record slots
+	*/
+	size_t compactTable(const string& tableName);
+
+	/**
+	 * @brief Repairs the damaged files of a table found by Recovery, see Table::repair. The views over the table are built again
+	 * @param tableName - name of table
+	 * @param damagedPages - indices of the pages whose files are damaged
+	 * @param damagedBlooms - indices of the pages whose Bloom filters are damaged
+	*/
+	void repairTable(const string& tableName, const vector<int>& damagedPages, const vector<int>& damagedBlooms);
+
+	/**
+	 * @brief Sets the dead records ratio above which a table gets compacted automatically
+	 * @param tableName - name of table
+	 * @param ratio - value in the range [0, 1), 0 turns automatic compaction off
+	*/
+	void setAutoVacuum(const string& tableName, double ratio);
+
+	/**
+	 * @brief Turns on or off the per-page Bloom filters of a column, used by the equality conditions on it
+	 * @param tableName - name of table
+	 * @param colName - name of the column
+	 * @param enabled - True to turn the filters on
+	*/
+	void setBloomFilter(const string& tableName, const string& colName, bool enabled);
+
+	/**
+	 * @brief Moves the pages of a table into one page file, or back into a file each
+	 * @param tableName - name of table
+	 * @param enabled - True to keep the pages in one file
+	*/
+	void setSingleFile(const string& tableName, bool enabled);
+
 	/**
 	 * @return the number of tables in the database
 	*/
 	size_t getNumTables() const { return fTables.size(); }
 
 	/**
-	 * @brief used to display the names of all tables in the database
+	 * @return the names of all tables in the database
 	*/
-	void listTables() const;
+	vector<string> getTableNames() const;
 
 	/**
-	 * @return desired table by it's name
+	 * @return the names of all views in the database
+	*/
+	vector<string> getViewNames() const;
+
+	/**
+	 * @return the directory of the database
+	*/
+	const string& getPath() const { return fDBPath; }
+
+	/**
+	 * @return desired table by it's name, read from its file if it wasn't yet
 	*/
 	Table& getTable(const string& name);
 
+	/**
+	 * @return the number of tables read from their files so far
+	*/
+	size_t getLoadedTablesCount() const;
+
 	/**
 	 * @brief Saves the metadata of Database object to binary file
 	*/
@@ -56,6 +186,62 @@ private:
 
 	void createDirectory() const;
 
+	/**
+	 * @brief Saves the groups of the views changed by the last statement
+	*/
+	void saveViews();
+
+	/**
+	 * @brief A table of the database, read from its file once
+	*/
+	struct TableSlot
+	{
+		string path;
+		unique_ptr<Table> table;
+		std::once_flag loaded;
+		/// Number of sessions that used the table, the most used tables are prefetched
+		size_t uses = 0;
+		bool usedInSession = false;
+	};
+
+	/**
+	 * @brief A view of the database, defined when the database is opened and read with its table
+	*/
+	struct ViewSlot
+	{
+		string tableName;
+		MaterializedView::Definition definition;
+		/// Null until the table is read
+		unique_ptr<MaterializedView> view;
+	};
+
+	/**
+	 * @brief Read the table of a slot from its file, if no other thread did it, with the views over it
+	*/
+	Table& load(const string& name, TableSlot& slot);
+
+	/**
+	 * @brief Read the views over a table just read from its file, or build them if their files are missing
+	 * @return the views by their names, they are not listening to the table yet
+	*/
+	vector<pair<string, unique_ptr<MaterializedView>>> openViews(const string& tableName, Table& table);
+
+	/**
+	 * @brief Start reading the most used tables on a background thread
+	*/
+	void prefetch(size_t count);
+
+	/**
+	 * @brief Wait for the background reading to end, before the tables are dropped or the database is closed
+	*/
+	void finishPrefetch();
+
 	string fDBName, fDBPath;
-	unordered_map<string, Table> fTables;
+	unordered_map<string, TableSlot> fTables;
+	/// The views are bound to tables of fTables, whose addresses never change
+	unordered_map<string, ViewSlot> fViews;
+	bool fInBatch = false;
+	/// Guards the tables and the views of the slots, which the prefetch thread sets
+	mutable std::mutex fTablesMutex;
+	std::thread fPrefetch;
 };
\ No newline at end of file
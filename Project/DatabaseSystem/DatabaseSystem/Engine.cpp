@@ -1,123 +1,115 @@
 #include "Engine.h"
 #include <algorithm>
+#include <chrono>
 
 using std::max;
 
 void Engine::menu()
 {
 	cout << yellow << "\t\t\t\t\t\t\tMENU" << endl;
-	cout << "CreateTable {tableName} (ColumnName1:DataType1, ColumnName2:DataType2..) Index ON {columnName}" << endl;
+	cout << "CreateTable {tableName} (ColumnName1:DataType1, ColumnName2:DataType2..) Index [HASH] ON {columnName}" << endl;
 	cout << "DropTable {tableName}" << endl;
 	cout << "ListTables" << endl;
 	cout << "TableInfo {tableName}" << endl;
 	cout << "Select {columnNames} FROM {tableName} WHERE {condition1} {OR|AND} {condition2} OrderBy {columnName} DISTINCT" << endl;
+	cout << "Select {columnNames} FROM {tableName} JOIN {tableName} ON {column1} = {column2} WHERE {condition1} .." << endl;
+	cout << "Select {columnNames}, {COUNT|SUM|MIN|MAX|AVG}({column}|*) FROM {tableName} WHERE {condition1} .. GROUP BY {columnNames}" << endl;
+	cout << "CreateView {viewName} AS Select {columnNames}, {aggregates} FROM {tableName} WHERE {condition1} .. GROUP BY {columnNames}" << endl;
+	cout << "DropView {viewName}" << endl;
 	cout << "Remove FROM {tableName} WHERE {condition1} {OR|AND} {condition2} .." << endl;
-	cout << "Insert INTO {tableName} {(value1, value2...)}" << reset << endl;
+	cout << "Insert INTO {tableName} {(value1, value2...)}" << endl;
+	cout << "Prepare {name} AS {Select|Remove} .. WHERE {column} = ? .." << endl;
+	cout << "Execute {name} (value1, value2..)" << endl;
+	cout << "BEGIN / COMMIT" << endl;
+	cout << "Vacuum {tableName} [AUTO {deadRatio}]" << endl;
+	cout << "BloomFilter {tableName} {ON|OFF} {columnName}" << endl;
+	cout << "SingleFile {tableName} {ON|OFF}" << reset << endl;
 }
 
-unordered_map<string, string> Engine::getColNameType(string scheme, vector<string>& colNames)
+Engine& Engine::getInstance()
 {
-	unordered_map<string, string> colNameType;
-	scheme.erase(scheme.begin());
-	scheme.pop_back();
-
-	vector<string> parts = sh::splitBy(scheme, ",");
-	for (size_t i = 0; i < parts.size(); i++)
-	{
-		vector<string> tuple = sh::splitBy(parts[i], ":");
-		colNames.push_back(tuple[0]);
-		colNameType.insert({ tuple[0], tuple[1] });
-	}
-	return colNameType;
+	static Engine inst;
+	return inst;
 }
 
-vector<unordered_map<string, TypeWrapper>> Engine::getColNameValues(string values, unordered_map<string, string>& scheme, unordered_map<size_t, string>& indexColumn)
+void Engine::printResult(const ResultSet& result) const
 {
-	vector<unordered_map<string, TypeWrapper>> result;
-	values.erase(values.begin());
-	values.pop_back();
-
-	vector<string> parts = sh::splitBy(values, ", ");
-	for (size_t i = 0; i < parts.size(); i++)
+	switch (result.getType())
 	{
-		sh::trim(parts[i]);
-		parts[i].erase(parts[i].begin());
-		parts[i].pop_back();
-
-		vector<string> splitRecord = sh::splitBy(parts[i], ",");
-		if (splitRecord.size() != scheme.size())
-			throw invalid_argument("Passed number of columns and table's number of columns are mismatching. Please check the record you are about to insert.");
+	case CommandType::SELECT:
+		printSelectedRecords(result);
+		break;
+	case CommandType::LIST_TABLES:
+	{
+		// The views have the name of their table in the second column
+		size_t tablesCount = 0;
+		for (size_t i = 0; i < result.getRowsCount(); i++)
+			tablesCount += result.getRow(i)[1].isEmpty() ? 1 : 0;
 
-		unordered_map<string, TypeWrapper> colVal;
-		for (size_t j = 0; j < splitRecord.size(); j++)
+		cout << yellow << "There " << (tablesCount == 1 ? "is " : "are ") << tablesCount << " tables in the database:" << reset << endl;
+		for (size_t i = 0; i < result.getRowsCount(); i++)
 		{
-			string colName = indexColumn[j];
-			string colType = scheme[colName];
+			const vector<TypeWrapper>& row = result.getRow(i);
+			cout << "\t-" << row[0].toString();
+			if (!row[1].isEmpty())
+				cout << " (view over " << row[1].toString() << ")";
 
-			if (sh::isCorrectColumnType(colType, splitRecord[j]))
-			{
-				if (colType == "Integer")
-					colVal.insert({ colName, TypeWrapper(stoi(splitRecord[j])) });
-				else if (colType == "Double")
-					colVal.insert({ colName, TypeWrapper(stod(splitRecord[j])) });
-				else if (colType == "String")
-					colVal.insert({ colName, TypeWrapper(splitRecord[j]) });
-			}
-			else
-			{
-				throw invalid_argument("Invalid type for column {" + colName + "} with value {" + splitRecord[j] + "}");
-			}
+			cout << "\n";
 		}
-		result.push_back(colVal);
+		break;
+	}
+	case CommandType::TABLE_INFO:
+		cout << yellow << result.getMessage() << reset << endl;
+		break;
+	default:
+		cout << green << result.getMessage() << reset << endl;
+		break;
 	}
-	return result;
 }
 
-Engine& Engine::getInstance()
+void Engine::printSelectedRecords(const ResultSet& result) const
 {
-	static Engine inst;
-	return inst;
-}
+	const vector<string>& selectedColumns = result.getColumnNames();
+	vector<size_t> longestWordsPerCol;
+	for (size_t j = 0; j < selectedColumns.size(); j++)
+		longestWordsPerCol.push_back(getLongestContentAtCol(j, result));
 
-void Engine::printSelectedRecords(vector<Record>& records, vector<string>& selectedColumns, unordered_map<string, size_t> colIndex) const
-{
-	unordered_map<string, size_t> longestWordsPerCol = getLongestWordPerCol(records, selectedColumns, colIndex);
 	printHeader(selectedColumns, longestWordsPerCol);
 
-	for (size_t i = 0; i < records.size(); i++)
+	for (size_t i = 0; i < result.getRowsCount(); i++)
 	{
+		const vector<TypeWrapper>& row = result.getRow(i);
 		cout << " | ";
 		for (size_t j = 0; j < selectedColumns.size(); j++)
 		{
-			TypeWrapper content = records[i].get(colIndex[selectedColumns[j]]);
-			printCellInformation(content, longestWordsPerCol[selectedColumns[j]], selectedColumns[j].size());
+			printCellInformation(row[j], longestWordsPerCol[j], selectedColumns[j].size());
 			cout << " | ";
 		}
 
 		cout << endl;
 	}
 
-	cout << "Total " << records.size() << " records selected." << endl;
+	cout << "Total " << result.getRowsCount() << " records selected." << endl;
 }
 
-void Engine::printCellInformation(TypeWrapper& cell, size_t longestWordOfCol, size_t colSize) const
+void Engine::printCellInformation(const TypeWrapper& cell, size_t longestWordOfCol, size_t colSize) const
 {
-	if (cell.getContent() != nullptr)
+	if (!cell.isEmpty())
 	{
-		string spaces(colSize > longestWordOfCol ? colSize - cell.getContent()->size() : longestWordOfCol - cell.getContent()->size(), ' ');
-		cout << cell.getContent()->toString();
+		string spaces(colSize > longestWordOfCol ? colSize - cell.size() : longestWordOfCol - cell.size(), ' ');
+		cout << cell.toString();
 		cout << spaces;
 	}
 }
 
-void Engine::printHeader(vector<string>& selectedColumns, unordered_map<string, size_t>& longestWordsPerCol) const
+void Engine::printHeader(const vector<string>& selectedColumns, const vector<size_t>& longestWordsPerCol) const
 {
 	for (size_t j = 0; j < selectedColumns.size(); j++)
 	{
 		string spaces;
-		if (longestWordsPerCol[selectedColumns[j]] != 0)
+		if (longestWordsPerCol[j] != 0)
 		{
-			size_t numSpaces = longestWordsPerCol[selectedColumns[j]] > selectedColumns[j].size() ? longestWordsPerCol[selectedColumns[j]] - selectedColumns[j].size() : 0;
+			size_t numSpaces = longestWordsPerCol[j] > selectedColumns[j].size() ? longestWordsPerCol[j] - selectedColumns[j].size() : 0;
 			spaces = string(numSpaces, ' ');
 		}
 		//else
@@ -130,7 +122,7 @@ void Engine::printHeader(vector<string>& selectedColumns, unordered_map<string,
 
 	cout << " --";
 	for (size_t i = 0; i < selectedColumns.size(); i++) {
-		for (size_t j = 0; j < longestWordsPerCol[selectedColumns[i]]; j++)
+		for (size_t j = 0; j < longestWordsPerCol[i]; j++)
 			cout << "-";
 
 		cout << "---";
@@ -139,16 +131,16 @@ void Engine::printHeader(vector<string>& selectedColumns, unordered_map<string,
 	cout << "--" << endl;
 }
 
-size_t Engine::getLongestContentAtCol(size_t col, vector<Record>& records) const
+size_t Engine::getLongestContentAtCol(size_t col, const ResultSet& result) const
 {
 	size_t longest = 0;
 
-	for (size_t i = 0; i < records.size(); i++)
+	for (size_t i = 0; i < result.getRowsCount(); i++)
 	{
-		TypeWrapper content = records[i].get(col);
-		if (content.getContent() != nullptr)
+		const TypeWrapper& content = result.getRow(i)[col];
+		if (!content.isEmpty())
 		{
-			size_t len = content.getContent()->size();
+			size_t len = content.size();
 			if (longest < len)
 				longest = len;
 		}
@@ -157,266 +149,195 @@ size_t Engine::getLongestContentAtCol(size_t col, vector<Record>& records) const
 	return longest;
 }
 
-unordered_map<string, size_t> Engine::getLongestWordPerCol(vector<Record>& records, vector<string>& selectedColumns, unordered_map<string, size_t> colIndex) const
+void Engine::run()
 {
-	unordered_map<string, size_t> lengthPerCol;
+	menu();
+	runStatements(cin, true);
+}
 
-	for (size_t i = 0; i < selectedColumns.size(); i++)
-		lengthPerCol.insert({ selectedColumns[i] ,getLongestContentAtCol(colIndex[selectedColumns[i]],records) });
+bool Engine::runBatch(const string& path)
+{
+	ifstream script(path);
+	if (!script.is_open())
+	{
+		cout << red << "Couldn't open " << path << " for reading." << reset << endl;
+		return false;
+	}
 
-	return lengthPerCol;
+	auto start = std::chrono::steady_clock::now();
+	runStatements(script, false);
+	cout << green << "Batch " << path << " done in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms." << reset << endl;
+	return true;
 }
 
-void Engine::run()
+bool Engine::runRecovery(bool repair)
+{
+	string dbName = "FMISql";
+	string dbPath = "DB/";
+	if (!fs::exists(dbPath + dbName + ".bin"))
+	{
+		cout << red << "There is no database at " << dbPath << dbName << " to check." << reset << endl;
+		return false;
+	}
+
+	auto listIndices = [](const vector<int>& indices) {
+		string list;
+		for (size_t i = 0; i < indices.size(); i++)
+			list += (i > 0 ? ", " : "") + std::to_string(indices[i]);
+		return list;
+	};
+
+	try
+	{
+		Connection connection(dbPath, dbName);
+		Recovery recovery(connection.getDataBase());
+		auto start = std::chrono::steady_clock::now();
+		const vector<Recovery::Damage>& damaged = recovery.check();
+		cout << "Checked " << recovery.getCheckedFiles() << " files on " << recovery.getThreadsCount() << " threads in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms, "
+			<< recovery.getUncheckedFiles() << " of them were written before the checksums." << endl;
+
+		for (const Recovery::Damage& damage : damaged)
+		{
+			cout << yellow << "Table " << damage.table << ":";
+			if (!damage.metadataError.empty())
+				cout << " " << damage.metadataError << " It can't be repaired.";
+			if (!damage.pages.empty())
+				cout << " damaged pages " << listIndices(damage.pages) << ".";
+			if (!damage.blooms.empty())
+				cout << " damaged Bloom filters of pages " << listIndices(damage.blooms) << ".";
+			cout << reset << endl;
+		}
+
+		if (damaged.empty())
+		{
+			cout << green << "No damaged files." << reset << endl;
+			return true;
+		}
+
+		if (!repair)
+		{
+			cout << yellow << "Run with --recover repair to repair them, the records of the damaged pages are lost." << reset << endl;
+			return false;
+		}
+
+		size_t repaired = recovery.repair();
+		cout << green << "Repaired " << repaired << " of " << damaged.size() << " tables." << reset << endl;
+		return repaired == damaged.size();
+	}
+	catch (const std::exception& e)
+	{
+		cout << red << e.what() << reset << endl;
+		return false;
+	}
+}
+
+void Engine::runStatements(istream& input, bool interactive)
 {
-	menu();
-	CommandParser cp;
 	string dbName = "FMISql";
 	string dbPath = "DB/";
 
 	ifstream in(dbPath + dbName + ".bin", std::ios::binary);
 	if (!in.is_open())
-	{
 		cout << red << "Couldn't open DB for reading. Creating new file directory for database..." << reset << endl;
-		DataBase db(dbName, dbPath);
-	}
 	in.close();
 
 	try
 	{
-		ifstream inDb(dbPath + dbName + ".bin", std::ios::binary);
-		DataBase db(inDb);
-		inDb.close();
+		// The connection commits an open batch and saves the database when it is closed, so does the end of the input
+		Connection connection(dbPath, dbName);
+		connection.setScriptMode(!interactive);
 
-		while (true)
+		while (!connection.isClosed())
 		{
 			string cmd;
-			cout << dbName << '>';
-			getline(cin, cmd);
+			if (interactive)
+				cout << dbName << '>';
+
+			if (!getline(input, cmd))
+				return;
+
+			// Scripts may have empty lines and -- comments
+			if (!interactive && (sh::trim(cmd).empty() || cmd.rfind("--", 0) == 0))
+				continue;
 
-			cp.clearCmd();
 			try
 			{
-				cp.setData(cmd);
+				printResult(connection.execute(cmd));
 			}
-			catch (const invalid_argument& e)
+			catch (const logic_error& e)
 			{
 				cout << red << e.what() << reset << endl;
-				continue;
 			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		cout << red << e.what() << reset << endl;
+	}
+}
 
-			switch (cp.getCommandType())
+#ifdef __linux__
+bool Engine::runServer(const string& socketPath)
+{
+	string dbName = "FMISql";
+	string dbPath = "DB/";
+
+	try
+	{
+		Connection connection(dbPath, dbName);
+		Server server(connection, socketPath);
+		if (!server.open())
+		{
+			cout << red << "Couldn't listen on " << socketPath << ", the path is too long or another server uses it." << reset << endl;
+			return false;
+		}
+
+		cout << green << "Serving " << dbPath << dbName << " on " << socketPath << " with " << server.getWorkersCount() << " workers." << reset << endl;
+		server.run();
+		cout << green << "Server stopped after " << server.getSessionsCount() << " sessions and " << server.getStatementsCount() << " statements." << reset << endl;
+	}
+	catch (const std::exception& e)
+	{
+		cout << red << e.what() << reset << endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Engine::runClient(const string& socketPath)
+{
+	try
+	{
+		Client client(socketPath);
+		menu();
+
+		while (true)
+		{
+			string cmd;
+			cout << socketPath << '>';
+			if (!getline(cin, cmd))
+				return true;
+
+			try
 			{
-			case CommandType::CREATE_TABLE:
-				try
-				{
-					string tblName = cp.atToken(1);
-					vector<string> colNames;
-					unordered_map<string, string> scheme = getColNameType(cp.atToken(2), colNames);
-					string primaryKey = cp.size() >= 6 ? cp.atToken(5) : "";
-					db.createTable(dbPath, tblName, scheme, colNames, primaryKey);
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-
-				cout << green << "Table " << cp.atToken(1) << " created!" << reset << endl;
-				break;
-			case CommandType::DROP_TABLE:
-				try
-				{
-					string tblName = cp.atToken(1);
-					db.dropTable(tblName);
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const exception& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-
-				cout << green << "Table " << cp.atToken(1) << " dropped!" << reset << endl;
-				break;
-			case CommandType::LIST_TABLES:
-				cout << yellow << "There " << (db.getNumTables() == 1 ? "is " : "are ") << db.getNumTables() << " tables in the database:" << reset << endl;
-				db.listTables();
-				break;
-			case CommandType::TABLE_INFO:
-				try
-				{
-					Table& t = db.getTable(cp.atToken(1));
-					string header = t.getTableHeader();
-					sh::trim(header);
-
-					vector<string> cols = sh::splitBy(header, ",");
-					sh::removeEmptyStringsInVector(cols);
-
-					string scheme = "(";
-					for (const string& name : cols)
-						scheme += name + ":" + t.getTableScheme().at(name) + ", ";
-
-					scheme += ") " + (t.getPrimaryKey().empty() ? "No Index on this table" : ("Index ON " + t.getPrimaryKey()));
-
-					cout << yellow << "Table " << cp.atToken(1) << " : " << scheme << endl;
-
-					if (t.getBytesData() < 1024)
-					{
-						cout << "(" << t.getBytesData() << " B data) in the table" << reset << endl;
-					}
-					else
-					{
-						cout << "(" << (t.getBytesData() / 1024) << " KB data) in the table" << reset << endl;
-					}
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-				}
-				break;
-			case CommandType::INSERT:
-				try
-				{
-					string tblName = cp.atToken(2);
-					if (cp.size() > 4)
-					{
-						cout << red << "Too many arguments for this command." << reset << endl;
-						break;
-					}
-
-					Table& target = db.getTable(tblName);
-					unordered_map<size_t, string> indexColumn;
-					unordered_map<string, string> tableScheme = target.getTableScheme();
-
-					size_t ind = 0;
-					vector<string> header = sh::splitBy(target.getTableHeader(), ",");
-					sh::removeEmptyStringsInVector(header);
-					for (const string& entry : header)
-						indexColumn.insert({ ind++, entry });
-
-					vector<unordered_map<string, TypeWrapper>> values = getColNameValues(cp.atToken(3), tableScheme, indexColumn);
-
-					db.insert(tblName, values);
-					cout << green << "Total " << values.size() << " rows inserted." << reset << endl;
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-
-				break;
-			case CommandType::SELECT:
-				try
-				{
-					vector<string> selectedColumns = sh::splitBy(cp.atToken(1), ",");
-					string tblName = cp.atToken(3);
-					Table& target = db.getTable(tblName);
-					bool isDistinct = cp.isDistinct();
-					string orderBy = cp.getOrderBy();
-
-					if (cp.size() <= 4)
-					{
-						Query q("", target.getTableScheme(), target.getPrimaryKey());
-						if (selectedColumns.size() == 1 && selectedColumns[0] == "*")
-						{
-							selectedColumns = sh::splitBy(db.getTable(tblName).getTableHeader(), ",");
-							sh::removeEmptyStringsInVector(selectedColumns);
-							vector<Record> answer = target.select(q, orderBy, isDistinct, selectedColumns);
-							printSelectedRecords(answer, selectedColumns, target.getColIndex());
-						}
-						else
-						{
-							vector<Record> answer = target.select(q, orderBy, isDistinct, selectedColumns);
-							printSelectedRecords(answer, selectedColumns, target.getColIndex());
-						}
-					}
-					else
-					{
-						Query query(cp.atToken(4), target.getTableScheme(), target.getPrimaryKey());
-						if (selectedColumns.size() == 1 && selectedColumns[0] == "*")
-						{
-							selectedColumns = sh::splitBy(db.getTable(tblName).getTableHeader(), ",");
-							sh::removeEmptyStringsInVector(selectedColumns);
-							vector<Record> answer = target.select(query, orderBy, isDistinct, selectedColumns);
-							printSelectedRecords(answer, selectedColumns, target.getColIndex());
-						}
-						else
-						{
-							vector<Record> answer = target.select(query, orderBy, isDistinct, selectedColumns);
-							printSelectedRecords(answer, selectedColumns, target.getColIndex());
-						}
-					}
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-
-				break;
-			case CommandType::REMOVE:
-				try
-				{
-					string tblName = cp.atToken(2);
-					Table& target = db.getTable(tblName);
-					Query query(cp.atToken(3), target.getTableScheme(), target.getPrimaryKey());
-					cout << green << "Total " << db.remove(tblName, query) << " rows deleted from " << tblName << reset << endl;
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-				catch (const out_of_range& e)
-				{
-					cout << red << e.what() << reset << endl;
-					break;
-				}
-
-				break;
-			case CommandType::EXIT:
-				db.save();
-				cout << green << "Goodbye" << reset << endl;
-				return;
-			case CommandType::NONE:
-				cout << red << "Unrecognized command." << reset << endl;
-				break;
+				ResultSet result = client.execute(cmd);
+				printResult(result);
+				if (result.getType() == CommandType::EXIT)
+					return true;
+			}
+			catch (const logic_error& e)
+			{
+				cout << red << e.what() << reset << endl;
 			}
 		}
 	}
 	catch (const std::exception& e)
 	{
 		cout << red << e.what() << reset << endl;
+		return false;
 	}
 }
+#endif
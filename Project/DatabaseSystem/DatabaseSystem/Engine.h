@@ -1,19 +1,23 @@
 #pragma once
 #include<iostream>
 #include "termcolor.hpp"
-#include "Database.h"
-#include "CommandParser.hpp"
+#include "Connection.h"
+#include "Server.h"
+#include "Client.hpp"
+#include "Recovery.hpp"
 
 using std::cout;
 using std::endl;
 using std::cin;
+using std::istream;
 using termcolor::red;
 using termcolor::reset;
 using termcolor::green;
 using termcolor::yellow;
 
 /**
- * @brief Descriptor of engine singleton class
+ * @brief Descriptor of engine singleton class - the console of the database. It reads the statements, runs them through
+ * a Connection and prints their results.
 */
 class Engine
 {
@@ -23,29 +27,24 @@ private:
 	void menu();
 
 	/**
-	 * @brief By given string of form ({columnName}:{columnType}) convert it into hashtable
-	 * @param scheme - stringified table scheme
-	 * @return hashtable where each key is column name and value is column data type
+	 * @brief Read statements from the input and run them until Exit or the end of the input
+	 * @param input - the console or a script
+	 * @param interactive - False for a script: no prompt is printed and the whole script runs as one batch
 	*/
-	unordered_map<string, string> getColNameType(string scheme, vector<string>& colNames);
+	void runStatements(istream& input, bool interactive);
 
 	/**
-	 * @brief By given record in form {({DataType}, {DataType}, {DataType})} where each datatype corresponds to a column
-	 * check if it satisfies the table's scheme, after which insert it into the desired table
-	 * @param values - stringified values to be inserted
-	 * @return vector of hashtables, each hashtable corresponding to one record that the user will be inserting
+	 * @brief Print the result of a statement: the selected rows as a table, the message of the other statements
 	*/
-	vector<unordered_map<string, TypeWrapper>> getColNameValues(string values, unordered_map<string, string>& scheme, unordered_map<size_t, string>& indexColumn);
+	void printResult(const ResultSet& result) const;
 
-	void printSelectedRecords(vector<Record>& records, vector<string>& selectedColumns, unordered_map<string, size_t> colIndex) const;
+	void printSelectedRecords(const ResultSet& result) const;
 
-	void printHeader(vector<string>& selectedColumns, unordered_map<string, size_t>& longestWordsPerCol) const;
+	void printHeader(const vector<string>& selectedColumns, const vector<size_t>& longestWordsPerCol) const;
 
-	size_t getLongestContentAtCol(size_t col, vector<Record>& records) const;
+	size_t getLongestContentAtCol(size_t col, const ResultSet& result) const;
 
-	void printCellInformation(TypeWrapper& cell, size_t longestWordOfCol, size_t colSize) const;
-
-	unordered_map<string, size_t> getLongestWordPerCol(vector<Record>& records, vector<string>& selectedColumns, unordered_map<string, size_t> colIndex) const;
+	void printCellInformation(const TypeWrapper& cell, size_t longestWordOfCol, size_t colSize) const;
 
 public:
 	static Engine& getInstance();
@@ -56,4 +55,34 @@ public:
 	Engine& operator=(Engine&& other) = delete;
 
 	void run();
+
+	/**
+	 * @brief Run the statements of a script without the console, as one batch with one write of the files at the end
+	 * @param path - path to the script, one statement per line
+	 * @return False if the script couldn't be opened
+	*/
+	bool runBatch(const string& path);
+
+	/**
+	 * @brief Check every page of the database against its checksum and report the damaged ones, see Recovery
+	 * @param repair - True to also repair the damaged tables
+	 * @return False if damaged files were found and not repaired
+	*/
+	bool runRecovery(bool repair);
+
+#ifdef __linux__
+	/**
+	 * @brief Serve the database to the other processes of the host over a Unix socket, until SIGINT or SIGTERM
+	 * @param socketPath - path of the socket
+	 * @return False if the socket couldn't be opened
+	*/
+	bool runServer(const string& socketPath);
+
+	/**
+	 * @brief The console, for a database served by another process
+	 * @param socketPath - path of the socket of the server
+	 * @return False if the server couldn't be reached or was lost
+	*/
+	bool runClient(const string& socketPath);
+#endif
 };
\ No newline at end of file
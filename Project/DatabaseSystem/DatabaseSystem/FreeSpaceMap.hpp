@@ -0,0 +1,119 @@
+#pragma once
+#include<vector>
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::vector;
+
+/**
+ * @brief Descriptor of the free space map of a table. It knows how many record slots are free in every page,
+ * either because the page is not filled up yet or because the vacuum has turned some of its records into tombstones.
+ * The pages that have room are also kept in a list, so finding one takes O(1).
+*/
+class FreeSpaceMap
+{
+public:
+	FreeSpaceMap() {}
+
+	FreeSpaceMap(BinaryReader& in)
+	{
+		size_t pages = 0;
+		in.read(pages);
+		for (size_t i = 0; i < pages; i++)
+		{
+			int freeSlots = 0;
+			in.read(freeSlots);
+			addPage(freeSlots);
+		}
+	}
+
+	/**
+	 * @brief Write the free slots of every page to file
+	 * @param out - the buffer of the file
+	*/
+	void write(BinaryWriter& out) const
+	{
+		size_t pages = fFreeSlots.size();
+		out.write(pages);
+		for (size_t i = 0; i < pages; i++)
+			out.write(fFreeSlots[i]);
+	}
+
+	/**
+	 * @brief Register a new page at the end of the table
+	 * @param freeSlots - number of free slots in the page
+	*/
+	void addPage(int freeSlots)
+	{
+		fFreeSlots.push_back(0);
+		fPositionInRoomList.push_back(-1);
+		release(fFreeSlots.size() - 1, freeSlots);
+	}
+
+	/**
+	 * @return the index of a page with at least one free slot, -1 if all the pages are full
+	*/
+	int findPageWithRoom() const
+	{
+		return fPagesWithRoom.empty() ? -1 : fPagesWithRoom.back();
+	}
+
+	/**
+	 * @brief Called after a record is placed in the page
+	*/
+	void use(size_t page)
+	{
+		if (fFreeSlots[page] == 0)
+			return;
+
+		if (--fFreeSlots[page] == 0)
+			removeFromRoomList(page);
+	}
+
+	/**
+	 * @brief Called when slots in the page become free again
+	 * @param count - number of freed slots
+	*/
+	void release(size_t page, int count)
+	{
+		if (count <= 0)
+			return;
+
+		if (fFreeSlots[page] == 0)
+		{
+			fPositionInRoomList[page] = fPagesWithRoom.size();
+			fPagesWithRoom.push_back(page);
+		}
+
+		fFreeSlots[page] += count;
+	}
+
+	int getFreeSlots(size_t page) const { return fFreeSlots[page]; }
+
+	size_t size() const { return fFreeSlots.size(); }
+
+	void clear()
+	{
+		fFreeSlots.clear();
+		fPositionInRoomList.clear();
+		fPagesWithRoom.clear();
+	}
+
+private:
+	vector<int> fFreeSlots;
+	vector<int> fPositionInRoomList;
+	vector<int> fPagesWithRoom;
+
+	/**
+	 * @brief Swap the page with the last one in the list of pages with room and drop it
+	*/
+	void removeFromRoomList(size_t page)
+	{
+		int pos = fPositionInRoomList[page];
+		int last = fPagesWithRoom.back();
+		fPagesWithRoom[pos] = last;
+		fPositionInRoomList[last] = pos;
+		fPagesWithRoom.pop_back();
+		fPositionInRoomList[page] = -1;
+	}
+};
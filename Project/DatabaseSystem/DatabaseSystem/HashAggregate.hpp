@@ -0,0 +1,637 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<thread>
+#include<atomic>
+#include<cstdint>
+#include<climits>
+#include<cmath>
+#include<exception>
+#include<algorithm>
+#include<unordered_map>
+#include "Table.hpp"
+#include "Query.hpp"
+#include "Arena.hpp"
+#include "SpillFile.hpp"
+#include "SortingHelper.h"
+#include "TransactionManager.hpp"
+#include "AggregateFunction.h"
+
+using std::vector;
+using std::string;
+using std::unordered_map;
+using std::invalid_argument;
+
+/**
+ * @brief Descriptor of an aggregation of a table (Select City, COUNT(*), AVG(Salary) FROM t WHERE ... GROUP BY City), executed
+ * as a streaming hash aggregation: every group keeps only its running aggregates, never its records.
+ * The pages of the table are split between threads and every thread builds its own partial groups, which are merged at the end.
+ * When the groups of a thread outgrow its share of the memory budget, the records of new groups are spilled to partitions on disk
+ * by the hash of their group, and every partition is aggregated on its own after the scan.
+ * The aggregates skip empty cells, only COUNT(*) counts every record. SUM of an Integer column stays an Integer if it fits in one,
+ * AVG is always a Double. Groups are told apart by the exact values of their columns.
+ * Without GROUP BY, COUNT(*) and COUNT, MIN and MAX of the primary key are answered from the table's record count or its
+ * B+ tree when the WHERE bounds only the primary key, so such queries read no pages at all.
+*/
+class HashAggregate
+{
+public:
+	/// Bytes of groups kept in memory before the aggregation starts spilling
+	static const size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+	/**
+	 * @param table - the aggregated table
+	 * @param selectList - the selected items: columns of the GROUP BY and aggregates - COUNT(*), COUNT(col), SUM(col), MIN(col), MAX(col), AVG(col)
+	 * @param groupBy - the grouping columns, empty to aggregate the whole table into one record
+	 * @param memoryBudget - bytes of groups kept in memory before spilling
+	 * @param threads - the most threads scanning the table, 0 for one per hardware thread
+	*/
+	HashAggregate(Table& table, const vector<string>& selectList, const vector<string>& groupBy, size_t memoryBudget = DEFAULT_MEMORY_BUDGET,
+		size_t threads = 0)
+		: fTable(table), fMemoryBudget(memoryBudget), fMaxThreads(threads), fThreads(1), fSpilled(false), fIndexOnly(false)
+	{
+		if (selectList.empty())
+			throw invalid_argument("Nothing is selected");
+
+		if (fMaxThreads == 0)
+			fMaxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+		for (const string& column : groupBy)
+			fGroupColumns.push_back(columnOf(column));
+
+		fGroupNames = groupBy;
+
+		for (const string& rawItem : selectList)
+		{
+			string item = rawItem;
+			item.erase(std::remove(item.begin(), item.end(), ' '), item.end());
+			if (fColIndex.find(item) != fColIndex.end())
+				throw invalid_argument("Selected twice: " + item);
+
+			fColIndex[item] = fColumnNames.size();
+			fColumnNames.push_back(item);
+
+			size_t open = item.find('(');
+			if (open == string::npos)
+			{
+				auto group = std::find(groupBy.begin(), groupBy.end(), item);
+				if (group == groupBy.end())
+					throw invalid_argument("Column " + item + " must be in the GROUP BY or inside an aggregate");
+
+				fOutputs.push_back(Output{ true, (size_t)(group - groupBy.begin()) });
+				continue;
+			}
+
+			if (item.back() != ')')
+				throw invalid_argument("Invalid aggregate " + item);
+
+			Aggregate aggregate;
+			aggregate.function = functionOf(item.substr(0, open));
+			string argument = item.substr(open + 1, item.size() - open - 2);
+			if (argument == "*")
+			{
+				if (aggregate.function != AggregateFunction::COUNT)
+					throw invalid_argument("Only COUNT can be applied to *");
+
+				aggregate.column = -1;
+				aggregate.type = ObjectType::INT;
+			}
+			else
+			{
+				aggregate.column = (int)columnOf(argument);
+				aggregate.type = typeOf(argument);
+				if (aggregate.type == ObjectType::STRING && (aggregate.function == AggregateFunction::SUM || aggregate.function == AggregateFunction::AVG))
+					throw invalid_argument("Cannot sum or average the String column " + argument);
+			}
+
+			fOutputs.push_back(Output{ false, fAggregates.size() });
+			fAggregates.push_back(aggregate);
+		}
+
+		fGroupBytes = GROUP_OVERHEAD + fGroupColumns.size() * sizeof(TypeWrapper) + fAggregates.size() * sizeof(Accumulator);
+	}
+
+	/**
+	 * @brief Aggregate the records of the table that satisfy the query, the query is on the columns of the table
+	 * @return one record per group, holding the selected items in order
+	*/
+	vector<Record> execute(const Query& query)
+	{
+		SnapshotGuard guard;
+		const Snapshot& snapshot = guard.get();
+		fSpilled = false;
+		fIndexOnly = false;
+
+		vector<Record> result;
+		if (aggregateByIndex(query, snapshot, result))
+		{
+			fIndexOnly = true;
+			fThreads = 0;
+			return result;
+		}
+
+		int pages = fTable.getPagesCount();
+		fThreads = std::max<size_t>(1, std::min(fMaxThreads, (size_t)pages / MIN_PAGES_PER_THREAD));
+
+		size_t aggregateId = fNextAggregateId++;
+		vector<Partial> partials(fThreads);
+		if (fThreads == 1)
+			aggregatePages(partials[0], 0, pages, query, snapshot, aggregateId, 0);
+		else
+		{
+			vector<std::thread> workers;
+			vector<std::exception_ptr> errors(fThreads);
+			for (size_t t = 0; t < fThreads; t++)
+			{
+				int firstPage = (int)(pages * t / fThreads), endPage = (int)(pages * (t + 1) / fThreads);
+				workers.emplace_back([&, t, firstPage, endPage]() {
+					try
+					{
+						aggregatePages(partials[t], firstPage, endPage, query, snapshot, aggregateId, t);
+					}
+					catch (...)
+					{
+						errors[t] = std::current_exception();
+					}
+					});
+			}
+
+			for (std::thread& worker : workers)
+				worker.join();
+
+			for (const std::exception_ptr& error : errors)
+				if (error)
+					std::rethrow_exception(error);
+		}
+
+		// The partial groups of all threads are merged into the ones of the first thread
+		GroupTable& groups = partials[0].groups;
+		for (size_t t = 1; t < fThreads; t++)
+		{
+			for (auto& group : partials[t].groups)
+			{
+				auto it = groups.find(group.first);
+				if (it == groups.end())
+					groups.emplace(group.first, std::move(group.second));
+				else
+					for (size_t i = 0; i < fAggregates.size(); i++)
+						merge(it->second[i], group.second[i]);
+			}
+
+			partials[t].groups.clear();
+		}
+
+		for (const Partial& partial : partials)
+			fSpilled = fSpilled || !partial.spills.empty();
+
+		if (!fSpilled)
+			emitGroups(groups, result);
+		else
+		{
+			// A spilled record can belong to a group that is in memory, so the groups are split into the same partitions
+			vector<GroupTable> partitions(SPILL_PARTITIONS);
+			for (auto& group : groups)
+				partitions[partitionOf(group.first)].emplace(group.first, std::move(group.second));
+
+			groups.clear();
+			for (size_t p = 0; p < SPILL_PARTITIONS; p++)
+			{
+				for (Partial& partial : partials)
+				{
+					if (partial.spills.empty())
+						continue;
+
+					for (const Record& r : partial.spills[p].readAll())
+						accumulate(partitions[p], r);
+				}
+
+				emitGroups(partitions[p], result);
+				partitions[p].clear();
+			}
+		}
+
+		// Without GROUP BY there is always one record, even if no record was aggregated
+		if (result.empty() && fGroupColumns.empty())
+		{
+			GroupTable empty;
+			empty.emplace(vector<TypeWrapper>(), vector<Accumulator>(fAggregates.size()));
+			emitGroups(empty, result);
+		}
+
+		return result;
+	}
+
+	/**
+	 * @brief Order the aggregated records by one of the selected items
+	*/
+	void orderBy(vector<Record>& target, const string& orderByWhat) const
+	{
+		if (fColIndex.find(orderByWhat) == fColIndex.end())
+			throw invalid_argument("Cannot order by an item that is not selected. (" + orderByWhat + ")");
+
+		heapSort(target, fColIndex.at(orderByWhat));
+	}
+
+	const vector<string>& getColumnNames() const { return fColumnNames; }
+
+	const unordered_map<string, size_t>& getColIndex() const { return fColIndex; }
+
+	/**
+	 * @return the number of threads of the last execution, 0 if no page was read
+	*/
+	size_t getThreads() const { return fThreads; }
+
+	/**
+	 * @return True if the last execution spilled groups to disk
+	*/
+	bool hasSpilled() const { return fSpilled; }
+
+	/**
+	 * @return True if the last execution was answered from the record count or the index of the table, without reading pages
+	*/
+	bool isIndexOnly() const { return fIndexOnly; }
+
+	/// An aggregate function applied to a column of the table
+	struct Aggregate
+	{
+		AggregateFunction function;
+		/// -1 for COUNT(*)
+		int column;
+		ObjectType type;
+	};
+
+	/// The running value of an aggregate in a group
+	struct Accumulator
+	{
+		size_t count = 0;
+		int64_t intSum = 0;
+		double sum = 0;
+		/// The low bits lost by the additions to sum, see addToSum
+		double compensation = 0;
+		TypeWrapper min, max;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const vector<TypeWrapper>& key) const
+		{
+			uint64_t hash = 0;
+			for (const TypeWrapper& value : key)
+				hash = hash * 0x9E3779B97F4A7C15ull ^ value.hash();
+
+			return (size_t)hash;
+		}
+	};
+
+	/// Doubles are compared exactly, so equal groups always have equal hashes
+	struct KeyEqual
+	{
+		bool operator()(const vector<TypeWrapper>& lhs, const vector<TypeWrapper>& rhs) const
+		{
+			for (size_t i = 0; i < lhs.size(); i++)
+			{
+				if (lhs[i].getType() != rhs[i].getType())
+					return false;
+				if (lhs[i].getType() == ObjectType::DOUBLE ? lhs[i].getDouble() != rhs[i].getDouble() : !(lhs[i] == rhs[i]))
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	/**
+	 * @return the types of the selected items, the type of SUM is the one of its column
+	*/
+	unordered_map<string, string> getScheme() const
+	{
+		unordered_map<string, string> scheme;
+		for (size_t i = 0; i < fOutputs.size(); i++)
+		{
+			const Output& output = fOutputs[i];
+			if (output.isGroupColumn)
+				scheme[fColumnNames[i]] = fTable.getTableScheme().at(fGroupNames[output.index]);
+			else if (fAggregates[output.index].function == AggregateFunction::COUNT)
+				scheme[fColumnNames[i]] = "Integer";
+			else if (fAggregates[output.index].function == AggregateFunction::AVG)
+				scheme[fColumnNames[i]] = "Double";
+			else
+				scheme[fColumnNames[i]] = fAggregates[output.index].type == ObjectType::INT ? "Integer" :
+					fAggregates[output.index].type == ObjectType::DOUBLE ? "Double" : "String";
+		}
+
+		return scheme;
+	}
+
+	const vector<Aggregate>& getAggregates() const { return fAggregates; }
+
+	/**
+	 * @return True if there is a GROUP BY, otherwise all records make one group
+	*/
+	bool isGrouped() const { return !fGroupColumns.empty(); }
+
+	/**
+	 * @return the values of the grouping columns of a record of the table
+	*/
+	vector<TypeWrapper> keyOf(const Record& r) const
+	{
+		vector<TypeWrapper> key;
+		key.reserve(fGroupColumns.size());
+		for (size_t column : fGroupColumns)
+			key.push_back(r.get(column));
+
+		return key;
+	}
+
+	/**
+	 * @brief Make the record of a group, holding the selected items in order
+	 * @param key - the values of the grouping columns of the group
+	 * @param accumulators - the running values of the aggregates of the group
+	*/
+	Record makeRecord(const vector<TypeWrapper>& key, const vector<Accumulator>& accumulators) const
+	{
+		Record r(fOutputs.size());
+		for (const Output& output : fOutputs)
+		{
+			if (output.isGroupColumn)
+				r.addValue(key[output.index]);
+			else
+				r.addValue(finalize(accumulators[output.index], fAggregates[output.index]));
+		}
+
+		return r;
+	}
+
+	/**
+	 * @brief Add a record of the table to the running value of an aggregate
+	*/
+	static void update(Accumulator& accumulator, const Aggregate& aggregate, const Record& r)
+	{
+		if (aggregate.column < 0)
+		{
+			accumulator.count++;
+			return;
+		}
+
+		const TypeWrapper& value = r.get(aggregate.column);
+		if (value.isEmpty())
+			return;
+
+		accumulator.count++;
+		switch (aggregate.function)
+		{
+		case AggregateFunction::SUM:
+		case AggregateFunction::AVG:
+			if (aggregate.type == ObjectType::INT)
+				accumulator.intSum += value.getInt();
+			else
+				addToSum(accumulator, value.getDouble());
+			break;
+		case AggregateFunction::MIN:
+			if (accumulator.min.isEmpty() || value < accumulator.min)
+				accumulator.min = value;
+			break;
+		case AggregateFunction::MAX:
+			if (accumulator.max.isEmpty() || accumulator.max < value)
+				accumulator.max = value;
+			break;
+		default: break;
+		}
+	}
+
+	/**
+	 * @brief Add a value to the sum of doubles with compensated (Kahan-Babuska) summation: the low bits every addition loses
+	 * are collected apart, so a sum that many values were added to and taken out of doesn't drift away from the sum of
+	 * the values left. Unlike plain Kahan summation it holds when a value is much larger than the sum.
+	*/
+	static void addToSum(Accumulator& accumulator, double value)
+	{
+		double sum = accumulator.sum + value;
+		if (std::fabs(accumulator.sum) >= std::fabs(value))
+			accumulator.compensation += (accumulator.sum - sum) + value;
+		else
+			accumulator.compensation += (value - sum) + accumulator.sum;
+
+		accumulator.sum = sum;
+	}
+
+	/**
+	 * @return the sum of doubles of an accumulator, with the bits lost by its additions
+	*/
+	static double sumOf(const Accumulator& accumulator) { return accumulator.sum + accumulator.compensation; }
+
+	/**
+	 * @return the value of an aggregate of a group, empty if the group has no values to sum, average or compare
+	*/
+	static TypeWrapper finalize(const Accumulator& accumulator, const Aggregate& aggregate)
+	{
+		switch (aggregate.function)
+		{
+		case AggregateFunction::COUNT: return TypeWrapper((int)accumulator.count);
+		case AggregateFunction::MIN: return accumulator.min;
+		case AggregateFunction::MAX: return accumulator.max;
+		default: break;
+		}
+
+		if (accumulator.count == 0)
+			return TypeWrapper();
+
+		if (aggregate.function == AggregateFunction::AVG)
+		{
+			double sum = aggregate.type == ObjectType::INT ? (double)accumulator.intSum : sumOf(accumulator);
+			return TypeWrapper(sum / accumulator.count);
+		}
+
+		if (aggregate.type == ObjectType::DOUBLE)
+			return TypeWrapper(sumOf(accumulator));
+		if (accumulator.intSum < INT_MIN || accumulator.intSum > INT_MAX)
+			return TypeWrapper((double)accumulator.intSum);
+
+		return TypeWrapper((int)accumulator.intSum);
+	}
+
+private:
+	/// A selected item is either one of the grouping columns or one of the aggregates
+	struct Output
+	{
+		bool isGroupColumn;
+		size_t index;
+	};
+
+	using GroupTable = unordered_map<vector<TypeWrapper>, vector<Accumulator>, KeyHash, KeyEqual>;
+
+	/// The groups built by one thread and the records it spilled
+	struct Partial
+	{
+		GroupTable groups;
+		size_t bytes = 0;
+		vector<SpillFile> spills;
+	};
+
+	static const size_t SPILL_PARTITIONS = 32;
+	/// Fewer pages are scanned faster by one thread than the threads are started
+	static const size_t MIN_PAGES_PER_THREAD = 8;
+	/// Estimated bytes of a group on top of its values - the node and the bucket of the hash table
+	static const size_t GROUP_OVERHEAD = 64;
+
+	static inline std::atomic<size_t> fNextAggregateId{ 0 };
+
+	Table& fTable;
+	size_t fMemoryBudget, fMaxThreads, fThreads, fGroupBytes;
+	bool fSpilled, fIndexOnly;
+	vector<size_t> fGroupColumns;
+	vector<string> fGroupNames;
+	vector<Aggregate> fAggregates;
+	vector<Output> fOutputs;
+	vector<string> fColumnNames;
+	unordered_map<string, size_t> fColIndex;
+
+	size_t columnOf(const string& column) const
+	{
+		auto it = fTable.getColIndex().find(column);
+		if (it == fTable.getColIndex().end())
+			throw invalid_argument("No column " + column + " in table " + fTable.getTableName());
+
+		return it->second;
+	}
+
+	ObjectType typeOf(const string& column) const
+	{
+		const string& type = fTable.getTableScheme().at(column);
+		if (type == "Integer")
+			return ObjectType::INT;
+		if (type == "Double")
+			return ObjectType::DOUBLE;
+
+		return ObjectType::STRING;
+	}
+
+	static AggregateFunction functionOf(string name)
+	{
+		std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+		if (name == "COUNT")
+			return AggregateFunction::COUNT;
+		if (name == "SUM")
+			return AggregateFunction::SUM;
+		if (name == "MIN")
+			return AggregateFunction::MIN;
+		if (name == "MAX")
+			return AggregateFunction::MAX;
+		if (name == "AVG")
+			return AggregateFunction::AVG;
+
+		throw invalid_argument("Unknown aggregate function " + name);
+	}
+
+	size_t partitionOf(const vector<TypeWrapper>& key) const
+	{
+		return (KeyHash()(key) >> 32) % SPILL_PARTITIONS;
+	}
+
+	/**
+	 * @brief Answer an aggregation without GROUP BY made of COUNT(*) and COUNT, MIN and MAX of the primary key without reading
+	 * pages - counts of the whole table come from its record count, the rest from the B+ tree if the WHERE bounds the primary key only
+	 * @return False if the pages have to be scanned
+	*/
+	bool aggregateByIndex(const Query& query, const Snapshot& snapshot, vector<Record>& result) const
+	{
+		if (!fGroupColumns.empty() || !snapshot.isLatest())
+			return false;
+
+		const string& primaryKey = fTable.getPrimaryKey();
+		int keyColumn = primaryKey.empty() ? -1 : (int)fTable.getColIndex().at(primaryKey);
+		bool onlyCounts = true;
+		for (const Aggregate& aggregate : fAggregates)
+		{
+			if (aggregate.column >= 0 && aggregate.column != keyColumn)
+				return false;
+			if (aggregate.function == AggregateFunction::SUM || aggregate.function == AggregateFunction::AVG)
+				return false;
+
+			onlyCounts = onlyCounts && aggregate.function == AggregateFunction::COUNT;
+		}
+
+		// The primary key is set in every record, so counting it is counting the records
+		Accumulator keys;
+		if (onlyCounts && query.isEmpty())
+			keys.count = fTable.getRecordsCount();
+		else if (!fTable.summarizeByIndex(query, snapshot, keys.count, keys.min, keys.max))
+			return false;
+
+		GroupTable single;
+		single.emplace(vector<TypeWrapper>(), vector<Accumulator>(fAggregates.size(), keys));
+		emitGroups(single, result);
+		return true;
+	}
+
+	/**
+	 * @brief Scan a range of pages on this thread, with an arena of its own
+	*/
+	void aggregatePages(Partial& partial, int firstPage, int endPage, const Query& query, const Snapshot& snapshot, size_t aggregateId, size_t thread)
+	{
+		Arena arena;
+		ArenaScope scope(arena);
+		size_t budget = fMemoryBudget / fThreads;
+
+		fTable.scanPages(firstPage, endPage, query, fTable.getColIndex(), snapshot, [&](const Record& r) {
+			vector<TypeWrapper> key = keyOf(r);
+			auto it = partial.groups.find(key);
+			if (it == partial.groups.end())
+			{
+				if (partial.bytes + fGroupBytes > budget)
+				{
+					spill(partial, key, r, aggregateId, thread);
+					return;
+				}
+
+				it = partial.groups.emplace(std::move(key), vector<Accumulator>(fAggregates.size())).first;
+				partial.bytes += fGroupBytes;
+			}
+
+			for (size_t i = 0; i < fAggregates.size(); i++)
+				update(it->second[i], fAggregates[i], r);
+			});
+	}
+
+	void spill(Partial& partial, const vector<TypeWrapper>& key, const Record& r, size_t aggregateId, size_t thread)
+	{
+		if (partial.spills.empty())
+		{
+			partial.spills = vector<SpillFile>(SPILL_PARTITIONS);
+			for (size_t p = 0; p < SPILL_PARTITIONS; p++)
+				partial.spills[p].open(fTable.getTablePath() + "aggregate" + to_string(aggregateId) + "_" + to_string(thread) + "_" + to_string(p) + ".tmp");
+		}
+
+		partial.spills[partitionOf(key)].add(r);
+	}
+
+	/**
+	 * @brief Add a record to its group, without a memory budget - used for the spilled records
+	*/
+	void accumulate(GroupTable& groups, const Record& r) const
+	{
+		auto it = groups.try_emplace(keyOf(r), fAggregates.size()).first;
+		for (size_t i = 0; i < fAggregates.size(); i++)
+			update(it->second[i], fAggregates[i], r);
+	}
+
+	static void merge(Accumulator& target, const Accumulator& source)
+	{
+		target.count += source.count;
+		target.intSum += source.intSum;
+		addToSum(target, source.sum);
+		target.compensation += source.compensation;
+		if (!source.min.isEmpty() && (target.min.isEmpty() || source.min < target.min))
+			target.min = source.min;
+		if (!source.max.isEmpty() && (target.max.isEmpty() || target.max < source.max))
+			target.max = source.max;
+	}
+
+	void emitGroups(const GroupTable& groups, vector<Record>& result) const
+	{
+		for (const auto& group : groups)
+		{
+			result.push_back(makeRecord(group.first, group.second));
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+#include<vector>
+#include<cstdint>
+#include<stdexcept>
+#include "RecordPtr.hpp"
+#include "TypeWrapper.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::vector;
+
+/**
+ * @brief Descriptor of a linear hash index from the values of a column to the records holding them. A lookup hashes
+ * the key once and scans one short bucket, instead of walking the levels of a tree. It answers only equality -
+ * the keys are not kept in order.
+ * The table grows one bucket at a time: when the average bucket gets too long, the bucket at the split pointer is
+ * divided between itself and a new bucket at the end, so no insert ever rehashes the whole index.
+ * The index is stored in the table metadata together with its level and split pointer, so loading it rehashes nothing.
+*/
+class HashIndex
+{
+public:
+	HashIndex() : fLevel(0), fNext(0), fSize(0), fBuckets(INITIAL_BUCKETS) {}
+
+	HashIndex(BinaryReader& in)
+	{
+		in.read(fLevel);
+		in.read(fNext);
+		in.read(fSize);
+
+		size_t buckets = 0;
+		in.read(buckets);
+		if (buckets != (INITIAL_BUCKETS << fLevel) + fNext)
+			throw std::logic_error("Hash index has " + to_string(buckets) + " buckets, its level and split pointer need " +
+				to_string((INITIAL_BUCKETS << fLevel) + fNext));
+
+		fBuckets.resize(buckets);
+		for (vector<Entry>& bucket : fBuckets)
+		{
+			bucket.resize(in.readVarint());
+			for (Entry& entry : bucket)
+			{
+				entry.key = TypeWrapper(in);
+				entry.ptr = RecordPtr(in);
+				entry.hash = entry.key.hash();
+			}
+		}
+	}
+
+	/**
+	 * @brief Write the index to file, bucket by bucket
+	 * @param out - the buffer of the file
+	*/
+	void write(BinaryWriter& out) const
+	{
+		out.write(fLevel);
+		out.write(fNext);
+		out.write(fSize);
+
+		size_t buckets = fBuckets.size();
+		out.write(buckets);
+		for (const vector<Entry>& bucket : fBuckets)
+		{
+			out.writeVarint(bucket.size());
+			for (const Entry& entry : bucket)
+			{
+				entry.key.write(out);
+				entry.ptr.write(out);
+			}
+		}
+	}
+
+	/**
+	 * @brief Insert a key, it must not be in the index already
+	 * @param key - value of the indexed column
+	 * @param ptr - where the record with this value is
+	*/
+	void insert(const TypeWrapper& key, const RecordPtr& ptr)
+	{
+		uint64_t hash = key.hash();
+		fBuckets[bucketOf(hash)].push_back(Entry{ key, ptr, hash });
+		fSize++;
+
+		if (fSize > fBuckets.size() * MAX_LOAD)
+			split();
+	}
+
+	/**
+	 * @brief Remove a key from the index
+	 * @return False if the key wasn't there
+	*/
+	bool remove(const TypeWrapper& key)
+	{
+		uint64_t hash = key.hash();
+		vector<Entry>& bucket = fBuckets[bucketOf(hash)];
+		for (size_t i = 0; i < bucket.size(); i++)
+		{
+			if (bucket[i].hash == hash && bucket[i].key == key)
+			{
+				bucket[i] = std::move(bucket.back());
+				bucket.pop_back();
+				fSize--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @return where the record with the key is, nullptr if the key is not in the index
+	*/
+	const RecordPtr* find(const TypeWrapper& key) const
+	{
+		uint64_t hash = key.hash();
+		for (const Entry& entry : fBuckets[bucketOf(hash)])
+			if (entry.hash == hash && entry.key == key)
+				return &entry.ptr;
+
+		return nullptr;
+	}
+
+	bool contains(const TypeWrapper& key) const { return find(key) != nullptr; }
+
+	size_t size() const { return fSize; }
+
+	void clear()
+	{
+		fLevel = 0;
+		fNext = 0;
+		fSize = 0;
+		fBuckets.assign(INITIAL_BUCKETS, vector<Entry>());
+	}
+
+private:
+	struct Entry
+	{
+		TypeWrapper key;
+		RecordPtr ptr;
+		uint64_t hash;
+	};
+
+	static const size_t INITIAL_BUCKETS = 16;
+	/// Average number of keys in a bucket above which the next bucket is split
+	static const size_t MAX_LOAD = 4;
+
+	size_t fLevel, fNext, fSize;
+	vector<vector<Entry>> fBuckets;
+
+	/**
+	 * @brief The buckets before the split pointer are already split in this round, so they are addressed with one more bit
+	*/
+	size_t bucketOf(uint64_t hash) const
+	{
+		size_t bucket = hash % (INITIAL_BUCKETS << fLevel);
+		if (bucket < fNext)
+			bucket = hash % (INITIAL_BUCKETS << (fLevel + 1));
+
+		return bucket;
+	}
+
+	/**
+	 * @brief Divide the bucket at the split pointer between itself and a new bucket at the end
+	*/
+	void split()
+	{
+		vector<Entry> old = std::move(fBuckets[fNext]);
+		fBuckets[fNext].clear();
+		fBuckets.emplace_back();
+
+		size_t round = INITIAL_BUCKETS << fLevel;
+		if (++fNext == round)
+		{
+			fLevel++;
+			fNext = 0;
+		}
+
+		for (Entry& entry : old)
+			fBuckets[bucketOf(entry.hash)].push_back(std::move(entry));
+	}
+};
\ No newline at end of file
@@ -0,0 +1,5 @@
+enum class IndexType
+{
+	BPTREE,
+	HASH
+};
\ No newline at end of file
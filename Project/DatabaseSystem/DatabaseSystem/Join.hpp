@@ -0,0 +1,517 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<fstream>
+#include<atomic>
+#include<unordered_map>
+#include "Table.hpp"
+#include "Query.hpp"
+#include "SortingHelper.h"
+#include "TransactionManager.hpp"
+#include "JoinStrategy.h"
+#include "SpillFile.hpp"
+
+using std::vector;
+using std::string;
+using std::unordered_map;
+using std::unordered_multimap;
+using std::invalid_argument;
+
+/**
+ * @brief Descriptor of an equi-join of two tables (Select ... FROM a JOIN b ON a.x = b.y). The planner picks one of three strategies
+ * by the indexes of the joined columns and the sizes of the tables:
+ *	- merge join - both columns are primary keys indexed by B+ trees. The sorted keys of both indexes are merged and only
+ *	  the records with matching keys are read.
+ *	- index nested loop - one column is a primary key. The other table is scanned and every record probes the index,
+ *	  only the matched records of the indexed table are read.
+ *	- hash join - the table with fewer records is the build side: its records are put in a hash table by their join key,
+ *	  then the pages of the other table are scanned and every record looks up its matches. When the build side outgrows
+ *	  the memory budget, both sides are first split into partitions on disk by the hash of the key (grace hash join) and every
+ *	  pair of partitions is joined on its own, so only one partition of the build side is in memory at a time.
+ * A joined record holds the columns of the left table followed by the ones of the right table. The columns are named
+ * {table}.{column}, the ones whose names are in only one of the tables can be named without the table too.
+ * The keys are compared by their hashes first, so they can't be doubles - two equal doubles may have different bytes.
+*/
+class Join
+{
+public:
+	/// Bytes of build records kept in memory before the join starts partitioning
+	static const size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+	/**
+	 * @param left - the table before JOIN
+	 * @param right - the table after JOIN
+	 * @param onLhs, onRhs - the columns compared in ON, in any order
+	 * @param memoryBudget - bytes of build records kept in memory before partitioning
+	*/
+	Join(Table& left, Table& right, const string& onLhs, const string& onRhs, size_t memoryBudget = DEFAULT_MEMORY_BUDGET)
+		: fLeft(left), fRight(right), fMemoryBudget(memoryBudget), fPartitions(0), fStrategy(JoinStrategy::HASH), fInner(nullptr)
+	{
+		if (&left == &right)
+			throw invalid_argument("Cannot join table " + left.getTableName() + " with itself");
+
+		unordered_map<string, size_t> nameCount;
+		for (const Side* side : { &fLeft, &fRight })
+			for (const auto& column : side->table.getColIndex())
+				nameCount[column.first]++;
+
+		addColumns(fLeft, 0, nameCount);
+		addColumns(fRight, left.getColIndex().size(), nameCount);
+
+		string lhs = onLhs, rhs = onRhs;
+		sh::trim(lhs);
+		sh::trim(rhs);
+		if (fRight.colIndex.count(lhs) && fLeft.colIndex.count(rhs))
+			std::swap(lhs, rhs);
+		if (!fLeft.colIndex.count(lhs) || !fRight.colIndex.count(rhs))
+			throw invalid_argument("JOIN ON must compare a column of " + left.getTableName() + " with a column of " + right.getTableName());
+
+		if (fScheme.at(lhs) != fScheme.at(rhs))
+			throw invalid_argument("Cannot join column " + lhs + " of type " + fScheme.at(lhs) + " with column " + rhs + " of type " + fScheme.at(rhs));
+		if (fScheme.at(lhs) == "Double")
+			throw invalid_argument("Cannot join on Double columns");
+
+		fLeft.keyCol = fLeft.colIndex.at(lhs);
+		fRight.keyCol = fRight.colIndex.at(rhs);
+		plan();
+	}
+
+	/**
+	 * @brief Join the records of both tables that are visible to a snapshot taken when the join starts
+	 * @param query - WHERE clause over the columns of the joined record. Each table is filtered by its own conditions
+	 * while it is scanned, the whole clause is checked on the joined records.
+	 * @return the joined records satisfying the query
+	*/
+	vector<Record> execute(const Query& query)
+	{
+		SnapshotGuard snapshot;
+		fPartitions = 0;
+		fSteps = query.resolve(fColIndex);
+		fLeft.steps = query.resolve(fLeft.colIndex);
+		fRight.steps = query.resolve(fRight.colIndex);
+		switch (fStrategy)
+		{
+		case JoinStrategy::MERGE:
+			return executeMerge(query, snapshot.get());
+		case JoinStrategy::INDEX_NESTED_LOOP:
+			return executeIndexNestedLoop(query, snapshot.get());
+		default:
+			return executeHash(query, snapshot.get());
+		}
+	}
+
+	/**
+	 * @brief Override the choice of the planner
+	 * @param strategy - a merge join needs both columns to be primary keys indexed by B+ trees,
+	 * an index nested loop needs at least one of them to be a primary key
+	*/
+	void setStrategy(JoinStrategy strategy)
+	{
+		bool leftIndexed = isJoinedOnPrimaryKey(fLeft), rightIndexed = isJoinedOnPrimaryKey(fRight);
+		if (strategy == JoinStrategy::MERGE && !(leftIndexed && rightIndexed
+			&& fLeft.table.getIndexType() == IndexType::BPTREE && fRight.table.getIndexType() == IndexType::BPTREE))
+			throw invalid_argument("Merge join needs both columns to be primary keys with a B+ tree index");
+		if (strategy == JoinStrategy::INDEX_NESTED_LOOP && !leftIndexed && !rightIndexed)
+			throw invalid_argument("Index nested loop join needs one of the columns to be a primary key");
+
+		fStrategy = strategy;
+		if (strategy == JoinStrategy::INDEX_NESTED_LOOP)
+			fInner = rightIndexed && (!leftIndexed || fLeft.table.getRecordsCount() <= fRight.table.getRecordsCount()) ? &fRight : &fLeft;
+	}
+
+	JoinStrategy getStrategy() const { return fStrategy; }
+
+	/**
+	 * @brief Given a vector of joined records, order them by the given column
+	*/
+	void orderBy(vector<Record>& target, const string& orderByWhat) const
+	{
+		if (fColIndex.find(orderByWhat) == fColIndex.end())
+			throw invalid_argument("Cannot order by a column that is not part of the joined tables. (" + orderByWhat + ")");
+
+		heapSort(target, fColIndex.at(orderByWhat));
+	}
+
+	/**
+	 * @return hashtable where against each column name of the joined record we have its type, used to parse the WHERE clause
+	*/
+	const unordered_map<string, string>& getScheme() const { return fScheme; }
+
+	const unordered_map<string, size_t>& getColIndex() const { return fColIndex; }
+
+	/**
+	 * @return the names of all columns of the joined record with their tables, in order
+	*/
+	const vector<string>& getColumnNames() const { return fColumnNames; }
+
+	/**
+	 * @return the number of partitions the last execution was split into, 0 if it was joined in memory
+	*/
+	size_t getPartitions() const { return fPartitions; }
+
+private:
+	struct Side
+	{
+		Side(Table& table) : table(table) {}
+
+		Table& table;
+		/// The names the query may use for the columns of the table and their indices in the table's records
+		unordered_map<string, size_t> colIndex;
+		/// The query of the running execution resolved for the records of the table
+		vector<Query::Step> steps;
+		size_t keyCol = 0;
+	};
+
+	static const size_t MAX_PARTITIONS = 256;
+	/// Records of the outer side whose matches are read together, so every page of the inner side is read once per batch
+	static const size_t FETCH_BATCH = 4096;
+	/// The merge join walks all keys of both indexes. Below this ratio of the smaller to the bigger table, probing the index of
+	/// the bigger one with the records of the smaller one touches fewer keys
+	static constexpr double MERGE_MIN_SIZE_RATIO = 1.0 / 16;
+
+	/// Tells apart the temporary files of joins running at the same time
+	static inline std::atomic<size_t> fNextJoinId{ 0 };
+
+	Side fLeft, fRight;
+	size_t fMemoryBudget, fPartitions;
+	JoinStrategy fStrategy;
+	/// The side whose index is probed in an index nested loop
+	Side* fInner;
+	unordered_map<string, string> fScheme;
+	unordered_map<string, size_t> fColIndex;
+	/// The query of the running execution resolved for the joined records
+	vector<Query::Step> fSteps;
+	vector<string> fColumnNames;
+
+	/**
+	 * @brief Name the columns of a side in the joined record
+	 * @param offset - index of the first column of the side in the joined record
+	 * @param nameCount - in how many of the tables each column name is
+	*/
+	void addColumns(Side& side, size_t offset, const unordered_map<string, size_t>& nameCount)
+	{
+		fColumnNames.resize(offset + side.table.getColIndex().size());
+		for (const auto& column : side.table.getColIndex())
+		{
+			vector<string> names{ side.table.getTableName() + "." + column.first };
+			if (nameCount.at(column.first) == 1)
+				names.push_back(column.first);
+
+			for (const string& name : names)
+			{
+				side.colIndex[name] = column.second;
+				fColIndex[name] = offset + column.second;
+				fScheme[name] = side.table.getTableScheme().at(column.first);
+			}
+
+			fColumnNames[offset + column.second] = names[0];
+		}
+	}
+
+	/**
+	 * @return True if the joined column of the side is the primary key of its table, so it is unique and indexed
+	*/
+	bool isJoinedOnPrimaryKey(const Side& side) const
+	{
+		const string& primaryKey = side.table.getPrimaryKey();
+		return !primaryKey.empty() && side.table.getColIndex().at(primaryKey) == side.keyCol;
+	}
+
+	/**
+	 * @brief Pick the strategy by the indexes of the joined columns and the numbers of records in the tables
+	*/
+	void plan()
+	{
+		bool leftIndexed = isJoinedOnPrimaryKey(fLeft), rightIndexed = isJoinedOnPrimaryKey(fRight);
+		size_t leftRecords = fLeft.table.getRecordsCount(), rightRecords = fRight.table.getRecordsCount();
+
+		if (leftIndexed && rightIndexed && fLeft.table.getIndexType() == IndexType::BPTREE && fRight.table.getIndexType() == IndexType::BPTREE
+			&& std::min(leftRecords, rightRecords) >= std::max(leftRecords, rightRecords) * MERGE_MIN_SIZE_RATIO)
+		{
+			fStrategy = JoinStrategy::MERGE;
+		}
+		// The smaller table is scanned and the index of the bigger one is probed, the hash join would scan both
+		else if (rightIndexed && leftRecords <= rightRecords)
+		{
+			fStrategy = JoinStrategy::INDEX_NESTED_LOOP;
+			fInner = &fRight;
+		}
+		else if (leftIndexed && rightRecords <= leftRecords)
+		{
+			fStrategy = JoinStrategy::INDEX_NESTED_LOOP;
+			fInner = &fLeft;
+		}
+		else
+		{
+			fStrategy = JoinStrategy::HASH;
+		}
+	}
+
+	/**
+	 * @brief Merge the sorted keys of both B+ tree indexes. A key has one version visible to the snapshot at most, but the index
+	 * may hold deleted versions of it for older snapshots, so every pair of versions of a matching key is read.
+	 * The matched records are read in batches, page by page.
+	*/
+	vector<Record> executeMerge(const Query& query, const Snapshot& snapshot)
+	{
+		vector<const data*> leftKeys = fLeft.table.getPrimaryKeysInOrder();
+		vector<const data*> rightKeys = fRight.table.getPrimaryKeysInOrder();
+
+		vector<Record> result;
+		vector<RecordPtr> leftPtrs, rightPtrs;
+		size_t i = 0, j = 0;
+		while (i < leftKeys.size() && j < rightKeys.size())
+		{
+			if (leftKeys[i]->first < rightKeys[j]->first)
+			{
+				i++;
+			}
+			else if (rightKeys[j]->first < leftKeys[i]->first)
+			{
+				j++;
+			}
+			else
+			{
+				size_t leftEnd = i + 1, rightEnd = j + 1;
+				while (leftEnd < leftKeys.size() && leftKeys[leftEnd]->first == leftKeys[i]->first)
+					leftEnd++;
+				while (rightEnd < rightKeys.size() && rightKeys[rightEnd]->first == rightKeys[j]->first)
+					rightEnd++;
+
+				for (size_t l = i; l < leftEnd; l++)
+				{
+					for (size_t r = j; r < rightEnd; r++)
+					{
+						leftPtrs.push_back(leftKeys[l]->second);
+						rightPtrs.push_back(rightKeys[r]->second);
+					}
+				}
+
+				i = leftEnd;
+				j = rightEnd;
+				if (leftPtrs.size() >= FETCH_BATCH)
+					joinReferences(leftPtrs, rightPtrs, query, snapshot, result);
+			}
+		}
+
+		joinReferences(leftPtrs, rightPtrs, query, snapshot, result);
+		return result;
+	}
+
+	/**
+	 * @brief Read the records of matched pairs of references from both tables and join them, the references are cleared after that
+	*/
+	void joinReferences(vector<RecordPtr>& leftPtrs, vector<RecordPtr>& rightPtrs, const Query& query, const Snapshot& snapshot,
+		vector<Record>& result) const
+	{
+		vector<Record> leftRecords(leftPtrs.size());
+		fLeft.table.fetchByReference(leftPtrs, snapshot, [&](size_t i, const Record& r) {
+			if (query.mayRecordSatisfyQuery(r, fLeft.steps))
+				leftRecords[i] = r;
+			});
+
+		fRight.table.fetchByReference(rightPtrs, snapshot, [&](size_t i, const Record& r) {
+			// An empty record of the left side was not visible or didn't satisfy its conditions
+			if (leftRecords[i].size() != 0 && query.mayRecordSatisfyQuery(r, fRight.steps))
+				emit(leftRecords[i], r, query, result);
+			});
+
+		leftPtrs.clear();
+		rightPtrs.clear();
+	}
+
+	/**
+	 * @brief Scan the outer side and probe the index of the inner side with every record. The matched records of the inner side
+	 * are read in batches, page by page.
+	*/
+	vector<Record> executeIndexNestedLoop(const Query& query, const Snapshot& snapshot)
+	{
+		const Side& inner = *fInner;
+		const Side& outer = fInner == &fLeft ? fRight : fLeft;
+
+		vector<Record> result, outerRecords;
+		vector<RecordPtr> innerPtrs;
+		auto joinBatch = [&]() {
+			inner.table.fetchByReference(innerPtrs, snapshot, [&](size_t i, const Record& r) {
+				if (r.get(inner.keyCol) != outerRecords[i].get(outer.keyCol) || !query.mayRecordSatisfyQuery(r, inner.steps))
+					return;
+
+				if (&outer == &fLeft)
+					emit(outerRecords[i], r, query, result);
+				else
+					emit(r, outerRecords[i], query, result);
+				});
+
+			outerRecords.clear();
+			innerPtrs.clear();
+		};
+
+		outer.table.scan(query, outer.colIndex, snapshot, [&](const Record& r) {
+			const TypeWrapper& key = r.get(outer.keyCol);
+			if (key.isEmpty())
+				return;
+
+			// The deleted versions of the key are probed too, the snapshot may still see one of them
+			inner.table.forEachVersion(key, [&](const RecordPtr& match) {
+				outerRecords.push_back(r);
+				innerPtrs.push_back(match);
+				});
+
+			if (outerRecords.size() >= FETCH_BATCH)
+				joinBatch();
+			});
+
+		joinBatch();
+		return result;
+	}
+
+	/**
+	 * @brief Estimate how many partitions keep one partition of the build side within half of the budget
+	 * @param bytes, records - the size of the build records seen so far
+	 * @param totalRecords - the records in the build table
+	*/
+	size_t partitionsFor(size_t bytes, size_t records, size_t totalRecords) const
+	{
+		size_t expectedBytes = bytes / records * std::max(records, totalRecords);
+		size_t partitions = expectedBytes / std::max<size_t>(fMemoryBudget / 2, 1) + 1;
+		return std::min(std::max<size_t>(partitions, 2), MAX_PARTITIONS);
+	}
+
+	/**
+	 * @brief The high bits of the hash pick the partition, the hash table of a partition uses the low ones
+	*/
+	size_t partitionOf(const TypeWrapper& key) const
+	{
+		return (size_t)((key.hash() >> 32) % fPartitions);
+	}
+
+	vector<SpillFile> openSpills(const Side& side, const string& role) const
+	{
+		size_t joinId = fNextJoinId++;
+		vector<SpillFile> spills(fPartitions);
+		for (size_t i = 0; i < fPartitions; i++)
+			spills[i].open(side.table.getTablePath() + "join" + to_string(joinId) + "_" + role + to_string(i) + ".tmp");
+
+		return spills;
+	}
+
+	/**
+	 * @brief Build a hash table on the smaller side and probe it with the records of the other, partitioning both sides to disk
+	 * when the build side outgrows the memory budget
+	*/
+	vector<Record> executeHash(const Query& query, const Snapshot& snapshot)
+	{
+		Side& build = fLeft.table.getRecordsCount() <= fRight.table.getRecordsCount() ? fLeft : fRight;
+		Side& probe = &build == &fLeft ? fRight : fLeft;
+
+		vector<Record> buildRecords;
+		vector<SpillFile> buildSpills;
+		size_t buildBytes = 0;
+		build.table.scan(query, build.colIndex, snapshot, [&](const Record& r) {
+			// An empty cell is equal to nothing
+			if (r.get(build.keyCol).isEmpty())
+				return;
+
+			if (fPartitions != 0)
+			{
+				buildSpills[partitionOf(r.get(build.keyCol))].add(r);
+				return;
+			}
+
+			buildBytes += sizeof(Record) + r.getKiloBytesData();
+			buildRecords.push_back(r);
+			if (buildBytes > fMemoryBudget)
+			{
+				fPartitions = partitionsFor(buildBytes, buildRecords.size(), build.table.getRecordsCount());
+				buildSpills = openSpills(build, "build");
+				for (const Record& spilled : buildRecords)
+					buildSpills[partitionOf(spilled.get(build.keyCol))].add(spilled);
+
+				buildRecords = vector<Record>();
+			}
+			});
+
+		vector<Record> result;
+		if (fPartitions == 0)
+		{
+			unordered_multimap<uint64_t, const Record*> hashTable = buildHashTable(buildRecords, build);
+			probe.table.scan(query, probe.colIndex, snapshot, [&](const Record& r) {
+				probeRecord(r, build, probe, hashTable, query, result);
+				});
+
+			return result;
+		}
+
+		vector<SpillFile> probeSpills = openSpills(probe, "probe");
+		probe.table.scan(query, probe.colIndex, snapshot, [&](const Record& r) {
+			if (!r.get(probe.keyCol).isEmpty())
+				probeSpills[partitionOf(r.get(probe.keyCol))].add(r);
+			});
+
+		for (size_t i = 0; i < fPartitions; i++)
+		{
+			vector<Record> partition = buildSpills[i].readAll();
+			unordered_multimap<uint64_t, const Record*> hashTable = buildHashTable(partition, build);
+			for (const Record& r : probeSpills[i].readAll())
+				probeRecord(r, build, probe, hashTable, query, result);
+		}
+
+		return result;
+	}
+
+	unordered_multimap<uint64_t, const Record*> buildHashTable(const vector<Record>& records, const Side& build) const
+	{
+		unordered_multimap<uint64_t, const Record*> hashTable;
+		hashTable.reserve(records.size());
+		for (const Record& r : records)
+			hashTable.insert({ r.get(build.keyCol).hash(), &r });
+
+		return hashTable;
+	}
+
+	/**
+	 * @brief Join a record of the probe side with its matches in the hash table of the build side
+	 * @param result - the joined records satisfying the query are added to it
+	*/
+	void probeRecord(const Record& r, const Side& build, const Side& probe, const unordered_multimap<uint64_t, const Record*>& hashTable,
+		const Query& query, vector<Record>& result) const
+	{
+		const TypeWrapper& key = r.get(probe.keyCol);
+		if (key.isEmpty())
+			return;
+
+		auto matches = hashTable.equal_range(key.hash());
+		for (auto it = matches.first; it != matches.second; ++it)
+		{
+			const Record& match = *it->second;
+			if (match.get(build.keyCol) != key)
+				continue;
+
+			if (&probe == &fLeft)
+				emit(r, match, query, result);
+			else
+				emit(match, r, query, result);
+		}
+	}
+
+	/**
+	 * @brief Join a record of the left table with a record of the right one and keep the result if it satisfies the query
+	*/
+	void emit(const Record& left, const Record& right, const Query& query, vector<Record>& result) const
+	{
+		Record joined = join(left, right);
+		if (query.isEmpty() || query.checkRecordAgainstQuery(joined, fSteps))
+			result.push_back(std::move(joined));
+	}
+
+	static Record join(const Record& left, const Record& right)
+	{
+		Record joined(left.size() + right.size());
+		for (size_t i = 0; i < left.size(); i++)
+			joined.addValue(left.get(i));
+		for (size_t i = 0; i < right.size(); i++)
+			joined.addValue(right.get(i));
+
+		return joined;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,6 @@
+enum class JoinStrategy
+{
+	HASH,
+	INDEX_NESTED_LOOP,
+	MERGE
+};
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+#include<vector>
+#include<cstring>
+#include<cstdint>
+#include<stdexcept>
+#include<algorithm>
+
+using std::vector;
+
+/**
+ * @brief Block compressor of the LZ family, in the spirit of LZ4. The block is a sequence of
+ * [token][literal length bytes][literals][2-byte offset][match length bytes]. The high half of the token is the number
+ * of literals and the low half the length of the match minus 4, a 15 in either half is continued with bytes of 255
+ * and a final byte below 255. The last sequence carries only literals.
+ * Matches are found through a hash table of the 4-byte sequences seen in the last 64KB, so compressing is fast enough
+ * to be done on every save of a sealed page.
+*/
+class LZCodec
+{
+public:
+	/**
+	 * @param src - the bytes to be compressed
+	 * @param size - number of bytes
+	 * @return the compressed block
+	*/
+	static vector<char> compress(const char* src, size_t size)
+	{
+		vector<char> out;
+		out.reserve(size / 2 + 16);
+		vector<int64_t> lastSeen(HASH_SIZE, -1);
+
+		size_t anchor = 0, pos = 0;
+		while (pos + MIN_MATCH <= size)
+		{
+			uint32_t sequence = load32(src + pos);
+			uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+			int64_t candidate = lastSeen[hash];
+			lastSeen[hash] = pos;
+
+			if (candidate < 0 || pos - candidate > MAX_OFFSET || load32(src + candidate) != sequence)
+			{
+				pos++;
+				continue;
+			}
+
+			size_t length = MIN_MATCH;
+			while (pos + length < size && src[candidate + length] == src[pos + length])
+				length++;
+
+			writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+			pos += length;
+			anchor = pos;
+		}
+
+		writeSequence(out, src + anchor, size - anchor, 0, 0);
+		return out;
+	}
+
+	/**
+	 * @brief Decode a block. The block may come from a damaged file, so every length is checked against the bytes left
+	 * in the block and in the output before it is copied. Throws logic_error if the block is malformed.
+	 * @param src - the compressed block
+	 * @param size - size of the compressed block
+	 * @param decodedSize - size of the original bytes
+	 * @return the original bytes
+	*/
+	static vector<char> decompress(const char* src, size_t size, size_t decodedSize)
+	{
+		// A length byte stands for 255 bytes at most, so a larger size can't be right and isn't allocated
+		if (decodedSize > size * 255 + 15)
+			throw std::logic_error("LZCodec decompress() - the decoded size doesn't fit the block");
+
+		vector<char> out(decodedSize);
+		size_t pos = 0, written = 0;
+		while (pos < size)
+		{
+			unsigned char token = (unsigned char)src[pos++];
+
+			size_t literals = readLength(src, size, pos, token >> 4);
+			if (size - pos < literals)
+				throw std::logic_error("LZCodec decompress() - literals run past the end of the block");
+			if (decodedSize - written < literals)
+				throw std::logic_error("LZCodec decompress() - literals run past the decoded size");
+
+			std::memcpy(out.data() + written, src + pos, literals);
+			written += literals;
+			pos += literals;
+			if (pos == size)
+				break;
+
+			if (size - pos < 2)
+				throw std::logic_error("LZCodec decompress() - missing match offset");
+
+			size_t offset = (unsigned char)src[pos] | ((size_t)(unsigned char)src[pos + 1] << 8);
+			pos += 2;
+			if (offset == 0 || offset > written)
+				throw std::logic_error("LZCodec decompress() - match offset points before the start of the block");
+
+			size_t length = readLength(src, size, pos, token & 0x0F) + MIN_MATCH;
+			if (decodedSize - written < length)
+				throw std::logic_error("LZCodec decompress() - match runs past the decoded size");
+
+			// The match may overlap the bytes it produces, so it is copied one byte at a time
+			size_t from = written - offset;
+			for (size_t i = 0; i < length; i++)
+				out[written + i] = out[from + i];
+			written += length;
+		}
+
+		if (written != decodedSize)
+			throw std::logic_error("LZCodec decompress() - the block doesn't decode to the expected size");
+
+		return out;
+	}
+
+private:
+	static const size_t MIN_MATCH = 4;
+	static const size_t MAX_OFFSET = 65535;
+	static const int HASH_BITS = 12;
+	static const size_t HASH_SIZE = 1 << HASH_BITS;
+
+	static uint32_t load32(const char* src)
+	{
+		uint32_t value;
+		std::memcpy(&value, src, sizeof(value));
+		return value;
+	}
+
+	/**
+	 * @brief Append a sequence of literals followed by a match. A match of length 0 ends the block
+	*/
+	static void writeSequence(vector<char>& out, const char* literals, size_t literalsCount, size_t offset, size_t matchLength)
+	{
+		size_t matchCode = matchLength == 0 ? 0 : matchLength - MIN_MATCH;
+		unsigned char token = (unsigned char)((std::min<size_t>(literalsCount, 15) << 4) | std::min<size_t>(matchCode, 15));
+		out.push_back((char)token);
+
+		writeLength(out, literalsCount);
+		out.insert(out.end(), literals, literals + literalsCount);
+		if (matchLength == 0)
+			return;
+
+		out.push_back((char)(offset & 0xFF));
+		out.push_back((char)(offset >> 8));
+		writeLength(out, matchCode);
+	}
+
+	/**
+	 * @brief Append the part of a length that does not fit in its half of the token
+	*/
+	static void writeLength(vector<char>& out, size_t length)
+	{
+		if (length < 15)
+			return;
+
+		length -= 15;
+		while (length >= 255)
+		{
+			out.push_back((char)255);
+			length -= 255;
+		}
+
+		out.push_back((char)length);
+	}
+
+	static size_t readLength(const char* src, size_t size, size_t& pos, size_t length)
+	{
+		if (length < 15)
+			return length;
+
+		unsigned char byte = 255;
+		while (byte == 255)
+		{
+			if (pos >= size)
+				throw std::logic_error("LZCodec decompress() - length runs past the end of the block");
+
+			byte = (unsigned char)src[pos++];
+			length += byte;
+		}
+
+		return length;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#ifdef __linux__
+#include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<iostream>
+#include<string>
+#include<thread>
+#include<vector>
+#include "Client.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Measures a server under load: a number of sessions, each on a thread of its own, run a statement over and over
+ * at the same time. Every ? in the statement is replaced by the number of the run, so the runs can insert different
+ * records or look up different keys. The throughput and the latencies of the statements are reported.
+*/
+class LoadGenerator
+{
+public:
+	/**
+	 * @param socketPath - path to the socket of the server
+	 * @param sessions - number of sessions opened at the same time
+	 * @param statements - number of statements run by each session
+	*/
+	LoadGenerator(const string& socketPath, size_t sessions, size_t statements)
+		: fSocketPath(socketPath), fSessions(std::max<size_t>(sessions, 1)), fStatements(statements) {}
+
+	/**
+	 * @brief Run the load and print its report
+	 * @param statement - the statement to run, with ? in place of the values that change
+	 * @return False if some session couldn't reach the server or lost it
+	*/
+	bool run(const string& statement)
+	{
+		vector<vector<double>> latencies(fSessions);
+		std::atomic<size_t> errors{ 0 }, lostSessions{ 0 };
+
+		auto start = std::chrono::steady_clock::now();
+		vector<std::thread> threads;
+		for (size_t s = 0; s < fSessions; s++)
+		{
+			threads.emplace_back([&, s]() {
+				try
+				{
+					Client client(fSocketPath);
+					latencies[s].reserve(fStatements);
+					for (size_t i = 0; i < fStatements; i++)
+					{
+						string text = bindRun(statement, s * fStatements + i);
+						auto sent = std::chrono::steady_clock::now();
+						try
+						{
+							client.execute(text);
+						}
+						catch (const std::logic_error&)
+						{
+							errors++;
+						}
+						latencies[s].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+					}
+				}
+				catch (const std::runtime_error&)
+				{
+					lostSessions++;
+				}
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		vector<double> all;
+		for (const vector<double>& session : latencies)
+			all.insert(all.end(), session.begin(), session.end());
+
+		std::sort(all.begin(), all.end());
+		cout << all.size() << " statements over " << fSessions << " sessions in " << (size_t)(seconds * 1000) << " ms: "
+			<< (size_t)(all.size() / std::max(seconds, 1e-9)) << " statements/s" << endl;
+		if (!all.empty())
+			cout << "latency p50 " << percentile(all, 0.5) << " us, p99 " << percentile(all, 0.99) << " us, max " << all.back() << " us" << endl;
+		cout << errors << " statements failed, " << lostSessions << " sessions couldn't reach the server." << endl;
+
+		return lostSessions == 0;
+	}
+
+private:
+	string fSocketPath;
+	size_t fSessions, fStatements;
+
+	static string bindRun(const string& statement, size_t run)
+	{
+		string text;
+		for (char c : statement)
+		{
+			if (c == '?')
+				text += std::to_string(run);
+			else
+				text += c;
+		}
+
+		return text;
+	}
+
+	static double percentile(const vector<double>& sorted, double fraction)
+	{
+		return sorted[std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()))];
+	}
+};
+#endif
\ No newline at end of file
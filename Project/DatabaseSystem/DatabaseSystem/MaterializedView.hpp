@@ -0,0 +1,335 @@
+#pragma once
+#include<map>
+#include<vector>
+#include<string>
+#include<filesystem>
+#include<unordered_map>
+#include "HashAggregate.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::map;
+using std::vector;
+using std::string;
+using std::unordered_map;
+
+/**
+ * @brief Descriptor of a materialized view - an aggregation of a table (CreateView v AS Select City, COUNT(*) FROM t WHERE ... GROUP BY City)
+ * whose groups are kept and maintained incrementally. The view listens to the changes of its table: every inserted record that satisfies
+ * the WHERE is added to its group and every deleted one is taken out of it, so reading the view costs O(groups) instead of a scan of the table.
+ * MIN and MAX keep how many times every value occurs in the group, so a deleted minimum is replaced exactly.
+ * Like the index of the table, the view holds the latest state of the table and not its versions.
+ * The groups are saved to their own file after the statements that change them.
+*/
+class MaterializedView
+{
+public:
+	/**
+	 * @brief Define the view, it is empty until it is built or loaded
+	 * @param name - name of the view
+	 * @param directory - directory of the database, the groups are saved to {directory}{name}.view
+	 * @param table - the aggregated table
+	 * @param selectList - the selected items: columns of the GROUP BY and aggregates
+	 * @param groupBy - the grouping columns, empty to aggregate the whole table into one record
+	 * @param where - the WHERE clause filtering the records of the table, empty for none
+	*/
+	MaterializedView(const string& name, const string& directory, Table& table, const vector<string>& selectList, const vector<string>& groupBy,
+		const string& where)
+		: fName(name), fPath(directory + name + ".view"), fWhere(where), fSelectList(selectList), fGroupBy(groupBy), fDefinition(table, selectList, groupBy),
+		fQuery(where, table.getTableScheme(), table.getPrimaryKey()), fSteps(fQuery.resolve(table.getColIndex())), fTable(table), fDirty(false) {}
+
+	/**
+	 * @brief The name, the WHERE clause and the selected items of a view, not its groups. It is kept in the file of the database
+	*/
+	struct Definition
+	{
+		string name, where;
+		vector<string> selectList, groupBy;
+
+		/**
+		 * @brief Read a definition, as written by write
+		*/
+		static Definition read(BinaryReader& in)
+		{
+			Definition definition;
+			in.readString(definition.name);
+			in.readString(definition.where);
+			definition.selectList = readStrings(in);
+			definition.groupBy = readStrings(in);
+			return definition;
+		}
+
+		void write(BinaryWriter& out) const
+		{
+			out.writeString(name);
+			out.writeString(where);
+			writeStrings(out, selectList);
+			writeStrings(out, groupBy);
+		}
+	};
+
+	/**
+	 * @brief Define a view read from the file of the database, it is empty until it is built or loaded
+	*/
+	MaterializedView(const Definition& definition, const string& directory, Table& table)
+		: MaterializedView(definition.name, directory, table, definition.selectList, definition.groupBy, definition.where) {}
+
+	Definition getDefinition() const { return Definition{ fName, fWhere, fSelectList, fGroupBy }; }
+
+	/**
+	 * @brief Fill the view with one scan of the table
+	*/
+	void build()
+	{
+		fGroups.clear();
+		SnapshotGuard snapshot;
+		fTable.scan(fQuery, fTable.getColIndex(), snapshot.get(), [&](const Record& r) { change(r, 1); });
+		fDirty = true;
+	}
+
+	/**
+	 * @brief Add an inserted record of the table to its group, or take a deleted one out of it
+	 * @param sign - 1 for an inserted record, -1 for a deleted one
+	*/
+	void apply(const Record& r, int sign)
+	{
+		if (fQuery.isEmpty() || fQuery.checkRecordAgainstQuery(r, fSteps))
+			change(r, sign);
+	}
+
+	/**
+	 * @return one record per group, holding the selected items in order
+	*/
+	vector<Record> getRecords() const
+	{
+		vector<Record> result;
+		result.reserve(fGroups.size());
+		for (const auto& group : fGroups)
+			result.push_back(fDefinition.makeRecord(group.first, group.second.accumulators));
+
+		// Without GROUP BY there is always one record, even if no record was aggregated
+		if (result.empty() && !fDefinition.isGrouped())
+			result.push_back(fDefinition.makeRecord(vector<TypeWrapper>(), vector<HashAggregate::Accumulator>(fDefinition.getAggregates().size())));
+
+		return result;
+	}
+
+	/**
+	 * @brief Save the groups to the file of the view if they changed since the last save
+	*/
+	void save()
+	{
+		if (!fDirty)
+			return;
+
+		BinaryWriter out;
+		out.writeVarint(fGroups.size());
+		for (const auto& group : fGroups)
+		{
+			for (const TypeWrapper& value : group.first)
+				value.write(out);
+
+			out.writeVarint(group.second.records);
+			for (size_t i = 0; i < group.second.accumulators.size(); i++)
+			{
+				const HashAggregate::Accumulator& accumulator = group.second.accumulators[i];
+				out.writeVarint(accumulator.count);
+				out.write(accumulator.intSum);
+				// The lost bits are saved added to the sum
+				out.write(HashAggregate::sumOf(accumulator));
+
+				out.writeVarint(group.second.values[i].size());
+				for (const pair<const TypeWrapper, size_t>& value : group.second.values[i])
+				{
+					value.first.write(out);
+					out.writeVarint(value.second);
+				}
+			}
+		}
+
+		if (!out.save(fPath))
+			throw invalid_argument("Couldn't save view " + fName + " to " + fPath);
+
+		fDirty = false;
+	}
+
+	/**
+	 * @brief Read the groups from the file of the view
+	 * @return False if there is no such file
+	*/
+	bool load()
+	{
+		BinaryReader in(fPath);
+		if (!in.isOpen())
+			return false;
+
+		fGroups.clear();
+		size_t groups = in.readVarint();
+		size_t keySize = fGroupBy.size(), aggregates = fDefinition.getAggregates().size();
+		for (size_t g = 0; g < groups; g++)
+		{
+			vector<TypeWrapper> key;
+			for (size_t i = 0; i < keySize; i++)
+				key.push_back(TypeWrapper(in));
+
+			Group& group = fGroups.try_emplace(std::move(key), aggregates).first->second;
+			group.records = in.readVarint();
+			for (size_t i = 0; i < aggregates; i++)
+			{
+				HashAggregate::Accumulator& accumulator = group.accumulators[i];
+				accumulator.count = in.readVarint();
+				in.read(accumulator.intSum);
+				in.read(accumulator.sum);
+
+				size_t values = in.readVarint();
+				for (size_t v = 0; v < values; v++)
+				{
+					TypeWrapper value(in);
+					group.values[i][value] = in.readVarint();
+				}
+
+				updateExtremes(accumulator, group.values[i]);
+			}
+		}
+
+		fDirty = false;
+		return true;
+	}
+
+	/**
+	 * @brief Delete the file of the view
+	*/
+	void removeFile() const
+	{
+		std::error_code errorCode;
+		std::filesystem::remove(fPath, errorCode);
+	}
+
+	void orderBy(vector<Record>& target, const string& orderByWhat) const { fDefinition.orderBy(target, orderByWhat); }
+
+	const string& getName() const { return fName; }
+
+	const string& getTableName() const { return fTable.getTableName(); }
+
+	const vector<string>& getColumnNames() const { return fDefinition.getColumnNames(); }
+
+	const unordered_map<string, size_t>& getColIndex() const { return fDefinition.getColIndex(); }
+
+	/**
+	 * @return the types of the columns of the view, used to filter it
+	*/
+	unordered_map<string, string> getScheme() const { return fDefinition.getScheme(); }
+
+	size_t getGroupsCount() const { return fGroups.size(); }
+
+private:
+	struct Group
+	{
+		Group(size_t aggregates) : records(0), accumulators(aggregates), values(aggregates) {}
+
+		size_t records;
+		vector<HashAggregate::Accumulator> accumulators;
+		/// For MIN and MAX, how many times every value occurs in the group
+		vector<map<TypeWrapper, size_t>> values;
+	};
+
+	string fName, fPath, fWhere;
+	vector<string> fSelectList, fGroupBy;
+	HashAggregate fDefinition;
+	Query fQuery;
+	/// fQuery resolved for the records of the table
+	vector<Query::Step> fSteps;
+	Table& fTable;
+	unordered_map<vector<TypeWrapper>, Group, HashAggregate::KeyHash, HashAggregate::KeyEqual> fGroups;
+	bool fDirty;
+
+	void change(const Record& r, int sign)
+	{
+		const vector<HashAggregate::Aggregate>& aggregates = fDefinition.getAggregates();
+		vector<TypeWrapper> key = fDefinition.keyOf(r);
+		auto it = fGroups.find(key);
+		if (it == fGroups.end())
+		{
+			if (sign < 0)
+				return;
+
+			it = fGroups.try_emplace(std::move(key), aggregates.size()).first;
+		}
+
+		Group& group = it->second;
+		group.records += sign;
+		for (size_t i = 0; i < aggregates.size(); i++)
+		{
+			if (sign > 0)
+				HashAggregate::update(group.accumulators[i], aggregates[i], r);
+			else
+				retract(group.accumulators[i], aggregates[i], r);
+
+			const HashAggregate::Aggregate& aggregate = aggregates[i];
+			if ((aggregate.function == AggregateFunction::MIN || aggregate.function == AggregateFunction::MAX) && !r.get(aggregate.column).isEmpty())
+			{
+				map<TypeWrapper, size_t>& values = group.values[i];
+				const TypeWrapper& value = r.get(aggregate.column);
+				if (sign > 0)
+					values[value]++;
+				else if (values.count(value) && --values[value] == 0)
+					values.erase(value);
+
+				updateExtremes(group.accumulators[i], values);
+			}
+		}
+
+		if (group.records == 0)
+			fGroups.erase(it);
+
+		fDirty = true;
+	}
+
+	/**
+	 * @brief Take a deleted record out of the running value of an aggregate, the inverse of HashAggregate::update.
+	 * MIN and MAX are restored from the counts of the values instead.
+	*/
+	static void retract(HashAggregate::Accumulator& accumulator, const HashAggregate::Aggregate& aggregate, const Record& r)
+	{
+		if (aggregate.column < 0)
+		{
+			accumulator.count--;
+			return;
+		}
+
+		const TypeWrapper& value = r.get(aggregate.column);
+		if (value.isEmpty())
+			return;
+
+		accumulator.count--;
+		if (aggregate.function == AggregateFunction::SUM || aggregate.function == AggregateFunction::AVG)
+		{
+			if (aggregate.type == ObjectType::INT)
+				accumulator.intSum -= value.getInt();
+			else
+				HashAggregate::addToSum(accumulator, -value.getDouble());
+		}
+	}
+
+	static void updateExtremes(HashAggregate::Accumulator& accumulator, const map<TypeWrapper, size_t>& values)
+	{
+		accumulator.min = values.empty() ? TypeWrapper() : values.begin()->first;
+		accumulator.max = values.empty() ? TypeWrapper() : values.rbegin()->first;
+	}
+
+	static void writeStrings(BinaryWriter& out, const vector<string>& strings)
+	{
+		out.writeVarint(strings.size());
+		for (const string& s : strings)
+			out.writeString(s);
+	}
+
+	static vector<string> readStrings(BinaryReader& in)
+	{
+		vector<string> strings(in.readVarint());
+		for (string& s : strings)
+			in.readString(s);
+
+		return strings;
+	}
+};
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
+#include<unordered_map>
 #include "Record.hpp"
-#include "FileHelper.hpp"
-using fh = FileHelper;
+#include "BufferPool.hpp"
 
 class Page
 {
@@ -14,26 +14,45 @@ private:
 	 */
 	int maxSize;
 	string path;
+	vector<ObjectType> columnTypes;
 	vector<Record> records;
 
+	/**
+	 * Marks a page in the compact encoding. Older pages start with their max capacity, which is never negative
+	 */
+	static constexpr int COMPACT_FORMAT = -1;
+
+	/**
+	 * A String column gets a dictionary when its values repeat at least twice on average
+	 */
+	static constexpr size_t DICTIONARY_MIN_REPEATS = 2;
+
 public:
-	Page(ifstream &in)
+	/**
+	 * Read a page from file
+	 * @param in the content of the page file
+	 * @param columnTypes the types of the table's columns in the order of its header
+	 */
+	Page(BinaryReader &in, const vector<ObjectType> &columnTypes) : columnTypes(columnTypes)
 	{
-		/// @brief Read page's max capacity to object
-		in.read((char *)&maxSize, sizeof(maxSize));
-
-		/// @brief Read page's path to object
-		fh::readString(in, path);
+		int format = 0;
+		in.read(format);
+		if (format != COMPACT_FORMAT)
+		{
+			readLegacy(in, format);
+			return;
+		}
 
-		/// @brief Read number of records
-		size_t num_records = 0;
-		in.read((char *)&num_records, sizeof(num_records));
+		/// @brief Read page's max capacity and path to object
+		maxSize = (int)in.readVarint();
+		in.readCompactString(path);
 
-		/// @brief Read records themselves
+		/// @brief Read the dictionaries, then the records themselves
+		PageLayout layout(in, columnTypes);
+		size_t num_records = in.readVarint();
+		records.reserve(num_records);
 		for (size_t i = 0; i < num_records; i++)
-		{
-			records.push_back(Record(in));
-		}
+			records.push_back(Record(in, layout));
 	}
 
 	/**
@@ -42,11 +61,13 @@ public:
 	 *
 	 * @param maxSize the maximum number of records that fit in one page
 	 * @param path the path at which the page is stored relative to the executable files
+	 * @param columnTypes the types of the table's columns in the order of its header
 	 */
-	Page(int maxSize, const string &path)
+	Page(int maxSize, const string &path, const vector<ObjectType> &columnTypes)
 	{
 		this->path = path;
 		this->maxSize = maxSize;
+		this->columnTypes = columnTypes;
 		this->save();
 	}
 
@@ -60,55 +81,126 @@ public:
 	}
 
 	/**
-	 * Insert a new record at the end of the page
+	 * Insert a new record in the page. The slot of a tombstone left by the vacuum is reused if there is one,
+	 * otherwise the record goes at the end of the page
 	 * @param record the record to be inserted
-	 * @return a boolean to indicate a successful/failed insertion
+	 * @return the index of the slot holding the record, -1 if there was no room for it
 	 */
-	bool addRecord(const Record &record)
+	int addRecord(const Record &record)
 	{
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (records[i].isInvalid())
+			{
+				records[i] = record;
+				save();
+				return i;
+			}
+		}
+
 		if (isFull())
-			return false;
+			return -1;
 
 		records.push_back(record);
 		save();
 
-		return true;
+		return records.size() - 1;
 	}
 
 	/**
 	 * Delete a record from the page at specified index
 	 * @param index the index of the record in the page to be deleted
+	 * @param txnId the transaction deleting the record
+	 */
+	void removeRecord(size_t index, size_t txnId)
+	{
+		records[index].markDeleted(txnId);
+		save();
+	}
+
+	/**
+	 * Undo the delete of a record by an aborted transaction
+	 * @param index the index of the record in the page
+	 */
+	void restoreRecord(size_t index)
+	{
+		records[index].markDeleted(0);
+		save();
+	}
+
+	/**
+	 * Turn a record into a tombstone at once, used to undo the insert of an aborted transaction
+	 * @param index the index of the record in the page
 	 */
-	void removeRecord(size_t index)
+	void reclaimRecord(size_t index)
 	{
 		records[index].invalidateRecord();
 		save();
 	}
 
 	/**
-	 * @brief Save the page on the disk
+	 * Replace all the records of the page and save it
+	 * @param newRecords the records that the page will hold, at most maxSize
+	 */
+	void rewrite(const vector<Record>& newRecords)
+	{
+		if (newRecords.size() > maxSize)
+			throw std::out_of_range("Page rewrite(records) - too many records for one page");
+
+		records = newRecords;
+		save();
+	}
+
+	/**
+	 * Reclaim the deleted records that no alive snapshot can see anymore
+	 * @param horizon the oldest transaction id that is still needed by someone
+	 * @return the number of reclaimed records
+	 */
+	size_t vacuum(size_t horizon)
+	{
+		size_t reclaimed = 0;
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			if (records[i].isReclaimable(horizon))
+			{
+				records[i].invalidateRecord();
+				reclaimed++;
+			}
+		}
+
+		if (reclaimed > 0)
+			save();
+
+		return reclaimed;
+	}
+
+	/**
+	 * @brief Save the page on the disk. The page is encoded in memory and written at once through the buffer pool.
+	 * A sealed (full) page is rarely changed again, so it is stored compressed
 	 */
 	void save()
 	{
-		ofstream out(path, std::ios::binary);
-		if (!out.is_open())
-			throw std::logic_error("Couldn't open file to save page " + path);
+		BinaryWriter out;
+		out.write(COMPACT_FORMAT);
 
-		/// @brief Save page's max capacity to file
-		out.write((char *)&maxSize, sizeof(maxSize));
+		/// @brief Save page's max capacity and path to file
+		out.writeVarint(maxSize);
+		out.writeCompactString(path);
 
-		/// @brief Save page's path to file
-		fh::writeString(out, path);
+		/// @brief Save the dictionaries of the low-cardinality String columns
+		PageLayout layout(columnTypes);
+		chooseDictionaries(layout);
+		layout.write(out);
 
 		/// @brief Save page's number of current records to file
-		size_t size = records.size();
-		out.write((char *)&size, sizeof(size));
+		out.writeVarint(records.size());
 
 		/// @brief Save the records themseleves to file
 		for (size_t i = 0; i < records.size(); i++)
-			records[i].write(out);
+			records[i].write(out, layout);
 
-		out.close();
+		if (!BufferPool::getInstance().write(path, out.release(), isFull()))
+			throw std::logic_error("Couldn't open file to save page " + path);
 	}
 
 	/**
@@ -125,11 +217,56 @@ public:
 	 * @param index the position of the record in the page
 	 * @return the required record
 	 */
-	Record get(size_t index)
+	const Record& get(size_t index) const
 	{
 		if (index >= 0 && index < records.size())
 			return records[index];
 
-		throw std::out_of_range(index + " is out of range");
+		throw std::out_of_range(std::to_string(index) + " is out of range");
+	}
+
+private:
+	/**
+	 * Read the rest of a page written before the compact encoding. It is saved in the compact one the next time it changes
+	 * @param maxSize the max capacity, already read from the file
+	 */
+	void readLegacy(BinaryReader &in, int maxSize)
+	{
+		this->maxSize = maxSize;
+		in.readString(path);
+
+		size_t num_records = 0;
+		in.read(num_records);
+		records.reserve(num_records);
+		for (size_t i = 0; i < num_records; i++)
+			records.push_back(Record(in));
+	}
+
+	/**
+	 * Give a dictionary to every String column whose values repeat enough in this page
+	 */
+	void chooseDictionaries(PageLayout &layout) const
+	{
+		for (size_t col = 0; col < columnTypes.size(); col++)
+		{
+			if (columnTypes[col] != ObjectType::STRING)
+				continue;
+
+			std::unordered_map<string_view, size_t> codes;
+			vector<TypeWrapper> distinct;
+			size_t cells = 0;
+			for (const Record &r : records)
+			{
+				if (r.isInvalid() || r.get(col).isEmpty())
+					continue;
+
+				cells++;
+				if (codes.insert({ r.get(col).getString(), distinct.size() }).second)
+					distinct.push_back(r.get(col));
+			}
+
+			if (!distinct.empty() && distinct.size() * DICTIONARY_MIN_REPEATS <= cells)
+				layout.setDictionary(col, std::move(distinct));
+		}
 	}
 };
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "PageFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::logic_error;
+using std::shared_lock;
+using std::unique_lock;
+
+PageFile::PageFile(const string& path) : fPath(path), fHandle(-1), fBlocksCount(1), fNextGeneration(1)
+{
+	uint64_t fileSize = 0;
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size{};
+	if (handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(handle, &size))
+	{
+		if (handle != INVALID_HANDLE_VALUE)
+			CloseHandle(handle);
+
+		throw logic_error("Couldn't open the page file " + path);
+	}
+	fHandle = (intptr_t)handle;
+	fileSize = size.QuadPart;
+#else
+	fHandle = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	struct stat status {};
+	if (fHandle < 0 || fstat(fHandle, &status) < 0)
+	{
+		if (fHandle >= 0)
+			::close(fHandle);
+
+		throw logic_error("Couldn't open the page file " + path);
+	}
+	fileSize = status.st_size;
+#endif
+
+	char superblock[BLOCK_SIZE] = {};
+	if (fileSize == 0)
+	{
+		uint32_t version = VERSION, blockSize = BLOCK_SIZE;
+		std::memcpy(superblock, MAGIC, sizeof(MAGIC));
+		std::memcpy(superblock + sizeof(MAGIC), &version, sizeof(version));
+		std::memcpy(superblock + sizeof(MAGIC) + sizeof(version), &blockSize, sizeof(blockSize));
+		if (!writeAt(0, superblock, BLOCK_SIZE))
+		{
+			close();
+			throw logic_error("Couldn't write the page file " + path);
+		}
+		return;
+	}
+
+	uint32_t version = 0, blockSize = 0;
+	if (fileSize >= BLOCK_SIZE && readAt(0, superblock, BLOCK_SIZE))
+	{
+		std::memcpy(&version, superblock + sizeof(MAGIC), sizeof(version));
+		std::memcpy(&blockSize, superblock + sizeof(MAGIC) + sizeof(version), sizeof(blockSize));
+	}
+
+	if (std::memcmp(superblock, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION || blockSize != BLOCK_SIZE)
+	{
+		close();
+		throw logic_error(path + " is not a page file of this version.");
+	}
+
+	readDirectory(fileSize);
+}
+
+PageFile::~PageFile()
+{
+	close();
+}
+
+void PageFile::close()
+{
+#ifdef _WIN32
+	if (fHandle != -1)
+		CloseHandle((HANDLE)fHandle);
+#else
+	if (fHandle >= 0)
+		::close(fHandle);
+#endif
+	fHandle = -1;
+}
+
+bool PageFile::read(const string& name, vector<char>& dest) const
+{
+	shared_lock<shared_mutex> lock(fMutex);
+	auto it = fExtents.find(name);
+	if (it == fExtents.end())
+		return false;
+
+	dest.resize(it->second.length);
+	uint64_t offset = it->second.block * BLOCK_SIZE + EXTENT_HEADER_SIZE + name.size();
+	return readAt(offset, dest.data(), dest.size());
+}
+
+bool PageFile::write(const string& name, const vector<char>& content)
+{
+	if (name.size() > UINT16_MAX)
+		throw logic_error("The name " + name + " is too long for a page file.");
+
+	unique_lock<shared_mutex> lock(fMutex);
+	uint32_t blocks = blocksFor(EXTENT_HEADER_SIZE + name.size() + content.size());
+	auto it = fExtents.find(name);
+	if (it != fExtents.end() && it->second.blocks >= blocks)
+	{
+		Extent& extent = it->second;
+		if (!writeExtent(extent.block, extent.blocks, extent.generation, name, content))
+			return false;
+
+		extent.length = content.size();
+		return true;
+	}
+
+	Extent extent{ allocate(blocks), blocks, fNextGeneration++, content.size() };
+	if (!writeExtent(extent.block, extent.blocks, extent.generation, name, content))
+	{
+		release(extent.block, extent.blocks);
+		return false;
+	}
+
+	if (it != fExtents.end())
+	{
+		release(it->second.block, it->second.blocks);
+		it->second = extent;
+	}
+	else
+		fExtents.insert({ name, extent });
+
+	return true;
+}
+
+void PageFile::remove(const string& name)
+{
+	unique_lock<shared_mutex> lock(fMutex);
+	auto it = fExtents.find(name);
+	if (it == fExtents.end())
+		return;
+
+	release(it->second.block, it->second.blocks);
+	fExtents.erase(it);
+}
+
+bool PageFile::contains(const string& name) const
+{
+	shared_lock<shared_mutex> lock(fMutex);
+	return fExtents.find(name) != fExtents.end();
+}
+
+uint64_t PageFile::getBlocksCount() const
+{
+	shared_lock<shared_mutex> lock(fMutex);
+	return fBlocksCount;
+}
+
+void PageFile::readDirectory(uint64_t fileSize)
+{
+	uint64_t fileBlocks = fileSize / BLOCK_SIZE;
+	uint64_t block = 1;
+	char header[EXTENT_HEADER_SIZE];
+	while (block < fileBlocks && readAt(block * BLOCK_SIZE, header, EXTENT_HEADER_SIZE))
+	{
+		uint32_t tag = 0, blocks = 0;
+		uint64_t generation = 0, length = 0;
+		uint16_t nameLength = 0;
+		const char* field = header;
+		std::memcpy(&tag, field, sizeof(tag)); field += sizeof(tag);
+		std::memcpy(&blocks, field, sizeof(blocks)); field += sizeof(blocks);
+		std::memcpy(&generation, field, sizeof(generation)); field += sizeof(generation);
+		std::memcpy(&length, field, sizeof(length)); field += sizeof(length);
+		std::memcpy(&nameLength, field, sizeof(nameLength));
+
+		if (tag != EXTENT_TAG || blocks == 0 || block + blocks > fileBlocks || EXTENT_HEADER_SIZE + nameLength + length > (uint64_t)blocks * BLOCK_SIZE)
+			break;
+
+		if (generation == 0)
+		{
+			fFree.insert({ blocks, block });
+			block += blocks;
+			continue;
+		}
+
+		string name(nameLength, '\0');
+		if (!readAt(block * BLOCK_SIZE + EXTENT_HEADER_SIZE, &name[0], nameLength))
+			break;
+
+		Extent extent{ block, blocks, generation, length };
+		fNextGeneration = std::max(fNextGeneration, generation + 1);
+		auto it = fExtents.find(name);
+		if (it == fExtents.end())
+			fExtents.insert({ name, extent });
+		else if (it->second.generation < generation)
+		{
+			release(it->second.block, it->second.blocks);
+			it->second = extent;
+		}
+		else
+			release(block, blocks);
+
+		block += blocks;
+	}
+
+	fBlocksCount = block;
+}
+
+uint64_t PageFile::allocate(uint32_t blocks)
+{
+	auto it = fFree.lower_bound(blocks);
+	if (it == fFree.end())
+	{
+		uint64_t block = fBlocksCount;
+		fBlocksCount += blocks;
+		return block;
+	}
+
+	uint32_t freeBlocks = it->first;
+	uint64_t block = it->second;
+	fFree.erase(it);
+	// The rest of a longer free extent stays free
+	if (freeBlocks > blocks)
+		release(block + blocks, freeBlocks - blocks);
+
+	return block;
+}
+
+void PageFile::release(uint64_t block, uint32_t blocks)
+{
+	char header[EXTENT_HEADER_SIZE] = {};
+	uint32_t tag = EXTENT_TAG;
+	std::memcpy(header, &tag, sizeof(tag));
+	std::memcpy(header + sizeof(tag), &blocks, sizeof(blocks));
+	writeAt(block * BLOCK_SIZE, header, EXTENT_HEADER_SIZE);
+	fFree.insert({ blocks, block });
+}
+
+bool PageFile::writeExtent(uint64_t block, uint32_t blocks, uint64_t generation, const string& name, const vector<char>& content)
+{
+	vector<char> extent(EXTENT_HEADER_SIZE + name.size() + content.size());
+	uint64_t length = content.size();
+	uint16_t nameLength = (uint16_t)name.size();
+	char* field = extent.data();
+	std::memcpy(field, &EXTENT_TAG, sizeof(EXTENT_TAG)); field += sizeof(EXTENT_TAG);
+	std::memcpy(field, &blocks, sizeof(blocks)); field += sizeof(blocks);
+	std::memcpy(field, &generation, sizeof(generation)); field += sizeof(generation);
+	std::memcpy(field, &length, sizeof(length)); field += sizeof(length);
+	std::memcpy(field, &nameLength, sizeof(nameLength)); field += sizeof(nameLength);
+	std::memcpy(field, name.data(), name.size()); field += name.size();
+	std::memcpy(field, content.data(), content.size());
+
+	// The last block of an extent at the end of the file is written whole, so the file always ends on a block
+	if (block + blocks == fBlocksCount)
+		extent.resize((size_t)blocks * BLOCK_SIZE);
+
+	return writeAt(block * BLOCK_SIZE, extent.data(), extent.size());
+}
+
+uint32_t PageFile::blocksFor(size_t bytes)
+{
+	return (uint32_t)((bytes + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+bool PageFile::readAt(uint64_t offset, char* dest, size_t count) const
+{
+	while (count > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED position{};
+		position.Offset = (DWORD)offset;
+		position.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD done = 0;
+		if (!ReadFile((HANDLE)fHandle, dest, (DWORD)std::min<size_t>(count, MAXDWORD), &done, &position) || done == 0)
+			return false;
+#else
+		ssize_t done = pread(fHandle, dest, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+#endif
+		dest += done;
+		offset += done;
+		count -= done;
+	}
+
+	return true;
+}
+
+bool PageFile::writeAt(uint64_t offset, const char* source, size_t count)
+{
+	while (count > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED position{};
+		position.Offset = (DWORD)offset;
+		position.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD done = 0;
+		if (!WriteFile((HANDLE)fHandle, source, (DWORD)std::min<size_t>(count, MAXDWORD), &done, &position) || done == 0)
+			return false;
+#else
+		ssize_t done = pwrite(fHandle, source, count, offset);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+#endif
+		source += done;
+		offset += done;
+		count -= done;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#include<cstdint>
+#include<map>
+#include<shared_mutex>
+#include<string>
+#include<unordered_map>
+#include<vector>
+
+using std::multimap;
+using std::shared_mutex;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+/**
+ * @brief One file holding the page files of a table, so reading a page is a positioned read instead of opening its own file.
+ * The file is made of blocks of BLOCK_SIZE bytes. The first is the superblock: MAGIC, the version and the block size.
+ * Every stored file takes a run of blocks, its extent, that starts with a header: EXTENT_TAG, the number of blocks,
+ * a generation, the length of the content and the name of the file. The content follows the header.
+ * A file that outgrows its extent is moved to a new one, which is written before the old one is freed - after a crash
+ * in between the extent with the higher generation wins. A freed extent has generation 0 and is reused by the next files.
+ * The directory of the extents is read from their headers when the file is opened.
+ * Reads may run in parallel, writes take turns with them.
+*/
+class PageFile
+{
+public:
+	static constexpr size_t BLOCK_SIZE = 1024;
+
+	/**
+	 * @brief Open a page file, or create an empty one if there is none. Throws logic_error if it can't be opened
+	 * or isn't a page file
+	 * @param path - path to the file
+	*/
+	PageFile(const string& path);
+
+	PageFile(const PageFile& other) = delete;
+	PageFile& operator=(const PageFile& other) = delete;
+
+	~PageFile();
+
+	/**
+	 * @param name - name of the stored file
+	 * @param dest - the content of the stored file
+	 * @return False if there is no such file or it couldn't be read
+	*/
+	bool read(const string& name, vector<char>& dest) const;
+
+	/**
+	 * @brief Store a file, replacing its content if it is stored already
+	 * @param name - name of the stored file
+	 * @param content - the new content
+	 * @return False if the content couldn't be written
+	*/
+	bool write(const string& name, const vector<char>& content);
+
+	/**
+	 * @brief Free the extent of a stored file, if there is one
+	*/
+	void remove(const string& name);
+
+	bool contains(const string& name) const;
+
+	const string& getPath() const { return fPath; }
+
+	/**
+	 * @return the number of blocks of the file, with the superblock and the free ones
+	*/
+	uint64_t getBlocksCount() const;
+
+private:
+	struct Extent
+	{
+		uint64_t block;
+		uint32_t blocks;
+		uint64_t generation;
+		uint64_t length;
+	};
+
+	static constexpr char MAGIC[8] = { 'F', 'M', 'I', 'P', 'A', 'G', 'E', 'S' };
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t EXTENT_TAG = 0x54584546;
+	/// The tag, the number of blocks, the generation, the length and the length of the name
+	static constexpr size_t EXTENT_HEADER_SIZE = 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t) + sizeof(uint16_t);
+
+	string fPath;
+	/// The file descriptor, or the HANDLE on Windows
+	intptr_t fHandle;
+	unordered_map<string, Extent> fExtents;
+	/// The free extents by their number of blocks
+	multimap<uint32_t, uint64_t> fFree;
+	uint64_t fBlocksCount, fNextGeneration;
+	mutable shared_mutex fMutex;
+
+	/**
+	 * @brief Build the directory from the headers of the extents. A header that is cut off ends the file,
+	 * it was being appended when the program stopped
+	*/
+	void readDirectory(uint64_t fileSize);
+
+	void close();
+
+	/**
+	 * @brief Find a free run of blocks or take it at the end of the file
+	 * @return the first block of the run
+	*/
+	uint64_t allocate(uint32_t blocks);
+
+	/**
+	 * @brief Mark an extent free on the disk and keep it for reuse
+	*/
+	void release(uint64_t block, uint32_t blocks);
+
+	bool writeExtent(uint64_t block, uint32_t blocks, uint64_t generation, const string& name, const vector<char>& content);
+
+	static uint32_t blocksFor(size_t bytes);
+
+	bool readAt(uint64_t offset, char* dest, size_t count) const;
+
+	bool writeAt(uint64_t offset, const char* source, size_t count);
+};
\ No newline at end of file
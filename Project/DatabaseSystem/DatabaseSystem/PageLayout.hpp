@@ -0,0 +1,139 @@
+#pragma once
+#include<vector>
+#include<unordered_map>
+#include<stdexcept>
+#include "TypeWrapper.hpp"
+
+using std::vector;
+using std::unordered_map;
+
+/**
+ * @brief Describes how the cells of a page are encoded. The type of every column comes from the schema of the table,
+ * so the cells are written without type tags: ints as zigzag varints, doubles as their 8 bytes and strings as
+ * a varint length and the characters. A String column with few distinct values in the page gets a dictionary instead,
+ * then its cells are only the varint codes of their values.
+ * A layout lives only while one page is encoded or decoded.
+*/
+class PageLayout
+{
+public:
+	/**
+	 * @param columnTypes - types of the columns in the order of the table header
+	*/
+	PageLayout(const vector<ObjectType>& columnTypes) : fColumnTypes(columnTypes), fDictionaries(columnTypes.size()), fCodes(columnTypes.size()) {}
+
+	/**
+	 * @brief Read the dictionaries of a page
+	 * @param columnTypes - types of the columns in the order of the table header
+	*/
+	PageLayout(BinaryReader& in, const vector<ObjectType>& columnTypes) : PageLayout(columnTypes)
+	{
+		size_t columns = in.readVarint();
+		if (columns != fColumnTypes.size())
+			throw std::logic_error("Page has " + to_string(columns) + " columns, the table has " + to_string(fColumnTypes.size()));
+
+		for (size_t col = 0; col < columns; col++)
+		{
+			size_t entries = in.readVarint();
+			fDictionaries[col].reserve(entries);
+			for (size_t i = 0; i < entries; i++)
+			{
+				size_t size = in.readVarint();
+				fDictionaries[col].push_back(TypeWrapper::fromString(string_view(in.readBytes(size), size)));
+			}
+		}
+	}
+
+	PageLayout(const PageLayout& other) = delete;
+	PageLayout& operator=(const PageLayout& other) = delete;
+
+	/**
+	 * @brief Write the dictionaries, a column without one is written as an empty dictionary
+	*/
+	void write(BinaryWriter& out) const
+	{
+		out.writeVarint(fColumnTypes.size());
+		for (size_t col = 0; col < fColumnTypes.size(); col++)
+		{
+			out.writeVarint(fDictionaries[col].size());
+			for (const TypeWrapper& value : fDictionaries[col])
+				out.writeCompactString(value.getString());
+		}
+	}
+
+	size_t columns() const { return fColumnTypes.size(); }
+
+	/**
+	 * @brief Encode the cells of a String column through a dictionary
+	 * @param col - index of the column
+	 * @param values - the distinct values of the column, their positions become their codes
+	*/
+	void setDictionary(size_t col, vector<TypeWrapper> values)
+	{
+		fDictionaries[col] = std::move(values);
+		fCodes[col].clear();
+		// The views point into the cells of the dictionary, which is not changed after this
+		for (size_t i = 0; i < fDictionaries[col].size(); i++)
+			fCodes[col].insert({ fDictionaries[col][i].getString(), i });
+	}
+
+	/**
+	 * @brief Write a non-empty cell of the given column
+	*/
+	void writeCell(BinaryWriter& out, size_t col, const TypeWrapper& value) const
+	{
+		if (value.getType() != fColumnTypes[col])
+			throw std::logic_error("Value " + value.toString() + " doesn't match the type of column " + to_string(col));
+
+		switch (fColumnTypes[col])
+		{
+		case ObjectType::INT:
+			out.writeSignedVarint(value.getInt());
+			break;
+		case ObjectType::DOUBLE:
+			out.write(value.getDouble());
+			break;
+		case ObjectType::STRING:
+			if (!fDictionaries[col].empty())
+				out.writeVarint(fCodes[col].at(value.getString()));
+			else
+				out.writeCompactString(value.getString());
+			break;
+		default:
+			throw std::logic_error("Column " + to_string(col) + " has no storable type");
+		}
+	}
+
+	/**
+	 * @brief Read a non-empty cell of the given column
+	*/
+	TypeWrapper readCell(BinaryReader& in, size_t col) const
+	{
+		switch (fColumnTypes[col])
+		{
+		case ObjectType::INT:
+			return TypeWrapper((int)in.readSignedVarint());
+		case ObjectType::DOUBLE:
+		{
+			double value = 0;
+			in.read(value);
+			return TypeWrapper(value);
+		}
+		case ObjectType::STRING:
+		{
+			if (!fDictionaries[col].empty())
+				return fDictionaries[col].at(in.readVarint());
+
+			size_t size = in.readVarint();
+			return TypeWrapper::fromString(string_view(in.readBytes(size), size));
+		}
+		default:
+			throw std::logic_error("Column " + to_string(col) + " has no storable type");
+		}
+	}
+
+private:
+	vector<ObjectType> fColumnTypes;
+	vector<vector<TypeWrapper>> fDictionaries;
+	vector<unordered_map<string_view, size_t>> fCodes;
+};
\ No newline at end of file
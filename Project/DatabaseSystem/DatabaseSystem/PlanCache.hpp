@@ -0,0 +1,121 @@
+#pragma once
+#include<list>
+#include<string>
+#include<optional>
+#include<unordered_map>
+#include "Query.hpp"
+#include "CommandParser.hpp"
+
+using std::list;
+using std::string;
+using std::optional;
+using std::unordered_map;
+
+/**
+ * @brief Descriptor of a cache of parsed statements. The tokens of a statement and its WHERE clause, parsed against the scheme of
+ * the table, are kept under the text of the statement, so a statement that is run again skips the tokenizer and the query parser.
+ * The cache keeps the statements used last - when it is full, the one unused for the longest time is dropped.
+ * The plans depend on the schemes of the tables, so the cache is cleared when a table or a view is created or dropped.
+*/
+class PlanCache
+{
+public:
+	/**
+	 * @brief A parsed statement, ready to run
+	*/
+	struct Plan
+	{
+		CommandParser command;
+		/// The table that the statement reads, empty if the statement isn't run through a plan
+		string table;
+		/// The parsed WHERE clause of a Select or a Remove on table
+		optional<Query> query;
+	};
+
+	/**
+	 * @param capacity - the most statements kept
+	*/
+	PlanCache(size_t capacity = 256) : fCapacity(capacity) {}
+
+	/**
+	 * @brief Look a statement up and mark it as the last used
+	 * @param statement - the normalized text of the statement
+	 * @return the plan of the statement, nullptr if it isn't cached
+	*/
+	Plan* find(const string& statement)
+	{
+		auto it = fIndex.find(statement);
+		if (it == fIndex.end())
+			return nullptr;
+
+		fEntries.splice(fEntries.begin(), fEntries, it->second);
+		return &it->second->second;
+	}
+
+	/**
+	 * @brief Cache the plan of a statement, dropping the least recently used one if the cache is full
+	 * @param statement - the normalized text of the statement
+	 * @return the cached plan
+	*/
+	Plan& insert(const string& statement, Plan plan)
+	{
+		auto it = fIndex.find(statement);
+		if (it != fIndex.end())
+		{
+			fEntries.erase(it->second);
+			fIndex.erase(it);
+		}
+		else if (fEntries.size() >= fCapacity)
+		{
+			fIndex.erase(fEntries.back().first);
+			fEntries.pop_back();
+		}
+
+		fEntries.emplace_front(statement, std::move(plan));
+		fIndex[statement] = fEntries.begin();
+		return fEntries.front().second;
+	}
+
+	void clear()
+	{
+		fEntries.clear();
+		fIndex.clear();
+	}
+
+	size_t size() const { return fEntries.size(); }
+
+	/**
+	 * @brief The key of a statement - its text without the spaces at its ends and with every run of spaces outside quotes
+	 * turned into one space, so statements that differ only in spacing share their plan
+	*/
+	static string normalize(const string& statement)
+	{
+		string result;
+		result.reserve(statement.size());
+		bool inQuotes = false;
+		for (char c : statement)
+		{
+			if (c == '"')
+				inQuotes = !inQuotes;
+
+			bool isSpace = c == ' ' || c == '\t' || c == '\r';
+			if (isSpace && !inQuotes)
+			{
+				if (!result.empty() && result.back() != ' ')
+					result += ' ';
+			}
+			else
+				result += c;
+		}
+
+		if (!result.empty() && result.back() == ' ')
+			result.pop_back();
+
+		return result;
+	}
+
+private:
+	size_t fCapacity;
+	list<pair<string, Plan>> fEntries;
+	unordered_map<string, list<pair<string, Plan>>::iterator> fIndex;
+};
\ No newline at end of file
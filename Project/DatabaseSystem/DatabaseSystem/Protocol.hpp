@@ -0,0 +1,130 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<stdexcept>
+#include<string>
+#include<vector>
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+#include "ResultSet.hpp"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+/**
+ * @brief The messages between the server and its clients. Every message is a frame: the length of its payload as a 32-bit
+ * unsigned integer, then the payload. A request holds the text of one statement. A response starts with a status byte,
+ * an error is followed by its message and a result by the type of the statement, its message, the number of changed rows,
+ * the names of the columns and the rows, with the cells written the way the pages write them.
+ * Both ends run on one host, so the integers are in its byte order.
+*/
+class Protocol
+{
+public:
+	static constexpr size_t HEADER_SIZE = sizeof(uint32_t);
+
+	/// A longer frame means a broken stream, the session is closed
+	static constexpr uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+	static vector<char> encodeRequest(const string& statement)
+	{
+		return frame(vector<char>(statement.begin(), statement.end()));
+	}
+
+	static vector<char> encodeResult(const ResultSet& result)
+	{
+		BinaryWriter out;
+		out.write(RESULT_STATUS);
+		out.write(result.getType());
+		out.writeCompactString(result.getMessage());
+		out.writeVarint(result.getAffectedRows());
+
+		out.writeVarint(result.getColumnsCount());
+		for (const string& column : result.getColumnNames())
+			out.writeCompactString(column);
+
+		out.writeVarint(result.getRowsCount());
+		for (size_t i = 0; i < result.getRowsCount(); i++)
+			for (const TypeWrapper& cell : result.getRow(i))
+				cell.write(out);
+
+		return frame(out.release());
+	}
+
+	static vector<char> encodeError(const string& message)
+	{
+		BinaryWriter out;
+		out.write(ERROR_STATUS);
+		out.writeCompactString(message);
+		return frame(out.release());
+	}
+
+	/**
+	 * @brief Read the frame at the start of a buffer
+	 * @param buffer - the received bytes
+	 * @param size - the number of received bytes
+	 * @param payloadSize - set to the length of the payload of the frame
+	 * @return False if the frame isn't whole yet. Throws length_error for a frame longer than MAX_FRAME_SIZE
+	*/
+	static bool hasFrame(const char* buffer, size_t size, uint32_t& payloadSize)
+	{
+		if (size < HEADER_SIZE)
+			return false;
+
+		std::memcpy(&payloadSize, buffer, HEADER_SIZE);
+		if (payloadSize > MAX_FRAME_SIZE)
+			throw std::length_error("The frame is longer than " + std::to_string(MAX_FRAME_SIZE) + " bytes.");
+
+		return size - HEADER_SIZE >= payloadSize;
+	}
+
+	/**
+	 * @brief Turn the payload of a response back into the result. An error is thrown as invalid_argument, like
+	 * Connection throws it
+	*/
+	static ResultSet decodeResponse(shared_ptr<const vector<char>> payload)
+	{
+		BinaryReader in(std::move(payload));
+		unsigned char status = ERROR_STATUS;
+		in.read(status);
+
+		string message;
+		if (status == ERROR_STATUS)
+		{
+			in.readCompactString(message);
+			throw invalid_argument(message);
+		}
+
+		CommandType type = CommandType::NONE;
+		in.read(type);
+		in.readCompactString(message);
+		size_t affectedRows = in.readVarint();
+
+		vector<string> columns(in.readVarint());
+		for (string& column : columns)
+			in.readCompactString(column);
+
+		vector<vector<TypeWrapper>> rows(in.readVarint());
+		for (vector<TypeWrapper>& row : rows)
+		{
+			row.reserve(columns.size());
+			for (size_t j = 0; j < columns.size(); j++)
+				row.emplace_back(in);
+		}
+
+		return ResultSet(type, std::move(columns), std::move(rows), message, affectedRows);
+	}
+
+private:
+	static constexpr unsigned char RESULT_STATUS = 0;
+	static constexpr unsigned char ERROR_STATUS = 1;
+
+	static vector<char> frame(vector<char> payload)
+	{
+		uint32_t size = (uint32_t)payload.size();
+		payload.insert(payload.begin(), (const char*)&size, (const char*)&size + HEADER_SIZE);
+		return payload;
+	}
+};
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <sstream>
 #include <algorithm>
 #include "Record.hpp"
+#include "ZoneMap.hpp"
 #include "Operator.h"
 #include "StringHelper.hpp"
 #include "TypeWrapper.hpp"
@@ -21,6 +22,7 @@ using std::unordered_map;
 using std::vector;
 using std::invalid_argument;
 using std::stringstream;
+using std::pair;
 
 using sh = StringHelper;
 
@@ -67,44 +69,87 @@ public:
 	*/
 	bool checkRecordAgainstCondition(const unordered_map<string, size_t>& colIndex, const Record& rec) const
 	{
-		if (colIndex.find(lhs) == colIndex.end())
+		return checkValue(rec.get(columnIn(colIndex)));
+	}
+
+	/**
+	 * @brief Find the column of the condition, throws invalid_argument if there is no such column
+	 * @param colIndex - hashtable containing the name of the column and its corresponding index (from left to right)
+	 * @return the index of the column in the records
+	*/
+	size_t columnIn(const unordered_map<string, size_t>& colIndex) const
+	{
+		auto it = colIndex.find(lhs);
+		if (it == colIndex.end())
 			throw invalid_argument("There is no column with name {" + lhs + "} in the table.");
 
+		return it->second;
+	}
+
+	/**
+	 * @brief Check a value of the column of the condition against it, used for the keys of the index too
+	 * @return True if the value satisfies the condition
+	*/
+	bool checkValue(const TypeWrapper& value) const
+	{
 		switch (op)
 		{
 		case Operator::GREATER_THAN:
-			if (rec.get(colIndex.at(lhs)) > rhs)
-				return true;
-			else
-				return false;
+			return value > rhs;
 		case Operator::LESS_THAN:
-			if (rec.get(colIndex.at(lhs)) < rhs)
-				return true;
-			else
-				return false;
+			return value < rhs;
 		case Operator::EQUAL:
-			if (rec.get(colIndex.at(lhs)) == rhs)
-				return true;
-			else
-				return false;
+			return value == rhs;
 		case Operator::GREATER_THAN_OR_EQUAL:
-			if (rec.get(colIndex.at(lhs)) > rhs || rec.get(colIndex.at(lhs)) == rhs)
-				return true;
-			else
-				return false;
+			return value > rhs || value == rhs;
 		case Operator::LESS_THAN_OR_EQUAL:
-			if (rec.get(colIndex.at(lhs)) < rhs || rec.get(colIndex.at(lhs)) == rhs)
-				return true;
-			else
-				return false;
+			return value < rhs || value == rhs;
 		case Operator::NOT_EQUAL:
-			if (rec.get(colIndex.at(lhs)) < rhs || rec.get(colIndex.at(lhs)) > rhs)
-				return true;
-			else
-				return false;
+			return value < rhs || value > rhs;
+		default:
+			return false;
+		}
+	}
+
+	/**
+	 * @brief By the zone map of the table, check whether a record of the given page may satisfy the current condition.
+	 * Empty cells and values of another type never satisfy a condition, so a page without values in the column is skipped too.
+	 * @param colIndex - hashtable containing the name of the column and its corresponding index (from left to right)
+	 * @param zones - the zone map of the table
+	 * @param page - index of the page
+	 * @return False if no record of the page can satisfy the condition, True if some may
+	*/
+	bool checkZoneAgainstCondition(const unordered_map<string, size_t>& colIndex, const ZoneMap& zones, size_t page) const
+	{
+		return checkZone(zones, page, columnIn(colIndex));
+	}
+
+	/**
+	 * @brief Same as checkZoneAgainstCondition, by the index of the column of the condition
+	*/
+	bool checkZone(const ZoneMap& zones, size_t page, size_t column) const
+	{
+		const TypeWrapper& min = zones.getMin(page, column);
+		const TypeWrapper& max = zones.getMax(page, column);
+		if (min.isEmpty() || min.getType() != rhs.getType())
+			return false;
+
+		switch (op)
+		{
+		case Operator::GREATER_THAN:
+			return max > rhs;
+		case Operator::LESS_THAN:
+			return min < rhs;
+		case Operator::EQUAL:
+			return min <= rhs && max >= rhs;
+		case Operator::GREATER_THAN_OR_EQUAL:
+			return max >= rhs;
+		case Operator::LESS_THAN_OR_EQUAL:
+			return min <= rhs;
+		case Operator::NOT_EQUAL:
+			return !(min == rhs && max == rhs);
 		default:
 			return false;
-			break;
 		}
 	}
 
@@ -112,8 +157,12 @@ public:
 
 	string& getColumn() { return lhs; }
 
+	const string& getColumn() const { return lhs; }
+
 	TypeWrapper& getValue() { return rhs; }
 
+	const TypeWrapper& getValue() const { return rhs; }
+
 	Operator getOperator() const { return op; }
 
 private:
@@ -129,62 +178,94 @@ private:
 class Query
 {
 public:
+	/**
+	 * @brief A step of the compiled postfix expression: a condition with the index of its column in the checked records,
+	 * or AND/OR of the results of the two steps before it
+	*/
+	struct Step
+	{
+		/// Index of the condition, or AND_STEP/OR_STEP
+		int condition;
+		/// NO_COLUMN until the step is resolved, or if the resolved records have no such column
+		size_t column;
+	};
+
+	static const int AND_STEP = -1;
+	static const int OR_STEP = -2;
+	static const size_t NO_COLUMN = (size_t)-1;
+	/// Results kept at once while the steps are evaluated, it bounds the nesting of the parentheses
+	static const size_t MAX_DEPTH = 64;
+
 	/**
 	 * @brief Constructor, by given expression in string format, parse it so that it can easily fit for shunting yard alg.
 	 * Every condtion of format ({column name} {comparison operator} {value of column}) is replaced by an index begining from 0
 	 * So an expression of format (ID > 5 AND (Name = "George" OR Age = 21) AND Grade > 4.0) is replaced with
 	 *	==> ( 0 AND ( 1 OR 2 ) AND 3 )
+	 * The expression is read once from left to right. A value written as ? is a parameter of a prepared statement, it is set by bind.
 	 * @param exp - expression in string format
 	 * @param colNameType - hashtable where key is name of colum and value is the type of the given column
 	*/
-	Query(string exp, const unordered_map<string, string>& colNameType, const string& primaryKey)
+	Query(const string& exp, const unordered_map<string, string>& colNameType, const string& primaryKey)
 	{
-		size_t index = 2, pos;
+		size_t index = 2, start = 0;
 		string result;
-		while ((pos = exp.find(" ")) != exp.npos)
+		while (start < exp.size())
 		{
-			string subStr = exp.substr(0, pos);
+			size_t pos = exp.find(' ', start);
+			if (pos == exp.npos)
+			{
+				// The last word is kept as it is
+				result += " " + exp.substr(start);
+				break;
+			}
+
+			string subStr = exp.substr(start, pos - start);
+			start = pos + 1;
 			if (colNameType.find(subStr) != colNameType.end())
 			{
-				string col, op, val;
-				col = subStr;// Column name
-				exp.erase(0, pos + 1);
-
-				pos = exp.find(" ");
-				subStr = exp.substr(0, pos); // operator 
-				op = subStr;
-				exp.erase(0, pos + 1);
-
-				pos = exp.find(" ");
-				subStr = exp.substr(0, pos);
-				if (subStr.find("\"") != exp.npos)
+				string col = subStr; // Column name
+				pos = exp.find(' ', start);
+				if (pos == exp.npos)
+					throw invalid_argument("Expected a value after {" + col + " " + exp.substr(start) + "}");
+
+				string op = exp.substr(start, pos - start); // operator
+				start = pos + 1;
+
+				// Column value, a string value may contain spaces so it runs until its closing quote
+				string val;
+				pos = exp.find(' ', start);
+				if (exp.substr(start, pos == exp.npos ? exp.npos : pos - start).find('"') != exp.npos)
 				{
 					size_t numQuotes = 0;
 					size_t i;
-					for (i = 0; i < exp.size(); i++)
+					for (i = start; i < exp.size(); i++)
 					{
 						if (exp[i] == '"')
 							numQuotes++;
 
-						val += exp[i];
 						if (numQuotes % 2 == 0)
 							break;
 					}
-					pos = i;
+					val = exp.substr(start, i - start + 1);
+					start = i + 1;
 				}
 				else
 				{
-					subStr = exp.substr(0, pos); // Column value
-					val = subStr;
+					val = exp.substr(start, pos == exp.npos ? exp.npos : pos - start);
+					start = pos == exp.npos ? exp.size() : pos + 1;
 				}
 				result += " " + to_string(index);
 
+				string number = to_string(index++);
+				if (val == "?")
+					fParameters.push_back({ number, colNameType.at(col) });
+
 				// Check if query contains primary key, if so then add it to the array of primary key queries
-				InternalQuery query(col, decideType(val), op, primaryKey);
+				InternalQuery query(col, val == "?" ? TypeWrapper() : decideType(val), op, primaryKey);
 				if (col == primaryKey)
 					fPrimaryKeyQueries.push_back(query);
 
-				fNumberedQueries[to_string(index++)] = query;
+				fNumberedQueries[number] = query;
 			}
 			else if (subStr == "AND" || subStr == "OR" || subStr == "NOT")
 			{
@@ -192,17 +273,36 @@ public:
 			}
 			else if (subStr == "(" || subStr == ")")
 				result += " " + subStr;
-
-			pos != exp.npos ? exp.erase(0, pos + 1) : exp.erase(0, exp.size());
 		}
 
-		if (!exp.empty())
-			result += " " + exp;
-
 		fQuery = result;
 		sh::trim(fQuery);
 
 		fShuntingOutput = shunting_yard(fQuery);
+		compile();
+	}
+
+	/**
+	 * @brief Resolve the columns of the conditions for records whose columns are at the given indices, so the records are
+	 * checked without looking their columns up by name. A scan resolves the steps once and passes them to the checks below,
+	 * they are valid until the next bind.
+	 * @param colIndex - hashtable of column names and their corresponding indices, the conditions on the columns missing
+	 * from it are left with NO_COLUMN
+	*/
+	vector<Step> resolve(const unordered_map<string, size_t>& colIndex) const
+	{
+		vector<Step> steps = fSteps;
+		for (Step& step : steps)
+		{
+			if (step.condition < 0)
+				continue;
+
+			auto it = colIndex.find(fConditions[step.condition].getColumn());
+			if (it != colIndex.end())
+				step.column = it->second;
+		}
+
+		return steps;
 	}
 
 	/**
@@ -214,18 +314,165 @@ public:
 	*/
 	bool checkRecordAgainstQuery(const Record& r, const unordered_map<string, size_t>& colIndex) const
 	{
-		return postfix_equation(fShuntingOutput, r, colIndex);
+		return checkRecordAgainstQuery(r, resolve(colIndex));
+	}
+
+	/**
+	 * @brief Same as above, by the steps resolved for the columns of the record
+	*/
+	bool checkRecordAgainstQuery(const Record& r, const vector<Step>& steps) const
+	{
+		return evaluate(steps, [&](const InternalQuery& condition, size_t column) {
+			return condition.checkValue(r.get(requireColumn(condition, column)));
+			});
+	}
+
+	/**
+	 * @brief By the zone map of the table, check whether a record of the given page may satisfy the where condition
+	 * @param zones - the zone map of the table
+	 * @param page - index of the page
+	 * @param colIndex - hashtable of column names and their corresponding indices
+	 * @return False if the page can be skipped, True if some of its records may satisfy the conditions
+	*/
+	bool checkZoneAgainstQuery(const ZoneMap& zones, size_t page, const unordered_map<string, size_t>& colIndex) const
+	{
+		return checkZoneAgainstQuery(zones, page, resolve(colIndex));
+	}
+
+	bool checkZoneAgainstQuery(const ZoneMap& zones, size_t page, const vector<Step>& steps) const
+	{
+		if (!zones.hasRecords(page))
+			return false;
+
+		return evaluate(steps, [&](const InternalQuery& condition, size_t column) {
+			return condition.checkZone(zones, page, requireColumn(condition, column));
+			});
+	}
+
+	/**
+	 * @brief Like checkRecordAgainstQuery, but only the conditions on the columns in colIndex are checked, the others are
+	 * taken as satisfied. The expressions have no negation, so a record failing this check fails the whole query whatever
+	 * the other columns hold. Used to filter each table of a join on its own.
+	 * @param colIndex - the columns of the record and their indices, a subset of the columns of the query
+	 * @return False if no record joined with this one can satisfy the query
+	*/
+	bool mayRecordSatisfyQuery(const Record& r, const unordered_map<string, size_t>& colIndex) const
+	{
+		if (isEmpty())
+			return true;
+
+		return mayRecordSatisfyQuery(r, resolve(colIndex));
+	}
+
+	bool mayRecordSatisfyQuery(const Record& r, const vector<Step>& steps) const
+	{
+		return evaluate(steps, [&](const InternalQuery& condition, size_t column) {
+			return column == NO_COLUMN || condition.checkValue(r.get(column));
+			});
+	}
+
+	/**
+	 * @brief The zone map counterpart of mayRecordSatisfyQuery
+	 * @return False if the page can be skipped
+	*/
+	bool mayZoneSatisfyQuery(const ZoneMap& zones, size_t page, const unordered_map<string, size_t>& colIndex) const
+	{
+		if (!zones.hasRecords(page))
+			return false;
+		if (isEmpty())
+			return true;
+
+		return mayZoneSatisfyQuery(zones, page, resolve(colIndex));
+	}
+
+	bool mayZoneSatisfyQuery(const ZoneMap& zones, size_t page, const vector<Step>& steps) const
+	{
+		if (!zones.hasRecords(page))
+			return false;
+
+		return evaluate(steps, [&](const InternalQuery& condition, size_t column) {
+			return column == NO_COLUMN || condition.checkZone(zones, page, column);
+			});
 	}
 
+	/**
+	 * @return True if there is no WHERE condition
+	*/
+	bool isEmpty() const { return fSteps.empty(); }
+
 	/**
 	 * @return The array of queries that contain primary key
 	*/
 	vector<InternalQuery>& getPrimaryKeyQueries() { return fPrimaryKeyQueries; }
 
+	const vector<InternalQuery>& getPrimaryKeyQueries() const { return fPrimaryKeyQueries; }
+
+	/**
+	 * @return True if every condition is on the primary key and they are all joined by AND, i.e. the query bounds
+	 * a range of the keys. A != condition doesn't make a range.
+	*/
+	bool isPrimaryKeyRange() const
+	{
+		if (fPrimaryKeyQueries.size() != fNumberedQueries.size())
+			return false;
+
+		for (const InternalQuery& condition : fPrimaryKeyQueries)
+			if (condition.getOperator() == Operator::NOT_EQUAL || condition.getOperator() == Operator::NONE)
+				return false;
+
+		for (const Step& step : fSteps)
+			if (step.condition == OR_STEP)
+				return false;
+
+		return true;
+	}
+
 	queue<string> getShuntingOutput() { return fShuntingOutput; }
 
 	unordered_map<string, InternalQuery>& getNumberedQueries() { return fNumberedQueries; }
 
+	/**
+	 * @return the number of ? values of the expression
+	*/
+	size_t getParametersCount() const { return fParameters.size(); }
+
+	/**
+	 * @brief Set the ? values of the expression, in the order they are written. Throws invalid_argument if a value
+	 * doesn't match the type of its column
+	 * @param values - stringified values, strings are quoted
+	*/
+	void bind(const vector<string>& values)
+	{
+		if (values.size() != fParameters.size())
+			throw invalid_argument("Expected " + to_string(fParameters.size()) + " values, " + to_string(values.size()) + " given.");
+
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			InternalQuery& condition = fNumberedQueries.at(fParameters[i].first);
+			const string& colType = fParameters[i].second;
+			if (!sh::isCorrectColumnType(colType, values[i]))
+				throw invalid_argument("Invalid type for column {" + condition.getColumn() + "} with value {" + values[i] + "}");
+
+			if (colType == "Integer")
+				condition.getValue() = TypeWrapper(stoi(values[i]));
+			else if (colType == "Double")
+				condition.getValue() = TypeWrapper(stod(values[i]));
+			else
+				condition.getValue() = TypeWrapper(values[i]);
+		}
+
+		// The copies of the primary key conditions are taken again, now with their values
+		fPrimaryKeyQueries.clear();
+		for (size_t i = 2; i < fNumberedQueries.size() + 2; i++)
+		{
+			const InternalQuery& condition = fNumberedQueries.at(to_string(i));
+			if (condition.isPrimaryKeyQuery())
+				fPrimaryKeyQueries.push_back(condition);
+		}
+
+		compile();
+	}
+
 private:
 	/**
 	 * @brief Given a string decide what type the object will be
@@ -247,6 +494,8 @@ private:
 		{
 			return TypeWrapper(stod(cpy));
 		}
+
+		throw invalid_argument("Invalid value {" + val + "} in the condition.");
 	}
 
 	/**
@@ -271,16 +520,18 @@ private:
 	 * @param expression - the string to be transformed into postfix expression
 	 * @return queue of expression members written in postfix order
 	*/
-	queue<string> shunting_yard(string expression/*, const Record& r, const unordered_map<string, int> colIndex*/) const
+	queue<string> shunting_yard(const string& expression) const
 	{
 		queue<string> output;
 		stack<string> operators;
 
-		while (!expression.empty())
+		size_t start = 0;
+		while (start < expression.size())
 		{
-			size_t pos = expression.find(" ");
+			size_t pos = expression.find(" ", start);
 
-			string element = pos != expression.npos ? expression.substr(0, pos) : expression;
+			string element = expression.substr(start, pos != expression.npos ? pos - start : expression.npos);
+			start = pos != expression.npos ? pos + 1 : expression.size();
 
 			if (element == " ")
 			{
@@ -321,8 +572,6 @@ private:
 
 				operators.push(element);
 			}
-
-			pos != expression.npos ? expression.erase(0, pos + 1) : expression.erase(0, expression.size());
 		}
 
 		while (!operators.empty())
@@ -338,49 +587,96 @@ private:
 	}
 
 	/**
-	 * @brief Calculate the given postfix expression agaisnt a record, to see if the record satisfies all of the
-	 * conditions of the expression.
-	 * @param output - queue of expression members written in postfix order
-	 * @param r - record to be checked against the expression
-	 * @param colIndex - hashtable of column names and their appropriate index
-	 * @return True if the record satisfies the set of conditions, false otherwise
+	 * @brief Turn the postfix expression into steps, with copies of the conditions in the order they are used.
+	 * Throws invalid_argument if the operators don't join the conditions properly
 	*/
-	bool postfix_equation(queue<string> output, const Record& r, const unordered_map<string, size_t>& colIndex) const
+	void compile()
 	{
-		stack<bool> result;
-		vector<Record> res;
+		fSteps.clear();
+		fConditions.clear();
 
-		while (!output.empty())
+		size_t depth = 0;
+		for (queue<string> output = fShuntingOutput; !output.empty(); output.pop())
 		{
-			if (sh::isStringInteger(output.front()))
+			const string& element = output.front();
+			if (element == "AND" || element == "OR")
+			{
+				if (depth < 2)
+					throw invalid_argument("Expected a condition on both sides of " + element + " in the WHERE clause.");
+
+				fSteps.push_back({ element == "AND" ? AND_STEP : OR_STEP, NO_COLUMN });
+				depth--;
+			}
+			else if (sh::isStringInteger(element))
 			{
-				result.push(fNumberedQueries.at(output.front()).checkRecordAgainstCondition(colIndex, r));
-				output.pop();
+				fSteps.push_back({ (int)fConditions.size(), NO_COLUMN });
+				fConditions.push_back(fNumberedQueries.at(element));
+				if (++depth > MAX_DEPTH)
+					throw invalid_argument("The WHERE clause nests too deep.");
 			}
 			else
 			{
-				bool val2 = result.top();
-				result.pop();
+				throw invalid_argument("Unmatched parenthesis in the WHERE clause.");
+			}
+		}
 
-				bool val1 = result.top();
-				result.pop();
+		if (depth > 1)
+			throw invalid_argument("Expected AND/OR between the conditions of the WHERE clause.");
+	}
 
-				string op = output.front();
-				output.pop();
+	/**
+	 * @brief Calculate the compiled expression, to see if all of the conditions of the expression are satisfied.
+	 * Nothing is allocated, so it is cheap enough to be called for every record of a scan.
+	 * @param steps - the steps of the query, resolved for the checked records
+	 * @param check - tells whether a single condition is satisfied (by a record, by a page...), given the condition and its column
+	 * @return True if the set of conditions is satisfied, false otherwise
+	*/
+	template<typename Check>
+	bool evaluate(const vector<Step>& steps, Check check) const
+	{
+		if (steps.empty())
+			return true;
 
-				if (op == "AND")
-					result.push(val1 && val2);
-				else
-					result.push(val1 || val2);
+		bool results[MAX_DEPTH];
+		size_t count = 0;
+		for (const Step& step : steps)
+		{
+			if (step.condition >= 0)
+			{
+				results[count++] = check(fConditions[step.condition], step.column);
+				continue;
 			}
+
+			count--;
+			if (step.condition == AND_STEP)
+				results[count - 1] = results[count - 1] && results[count];
+			else
+				results[count - 1] = results[count - 1] || results[count];
 		}
 
-		return result.top();
+		return results[0];
+	}
+
+	/**
+	 * @return the resolved column of the condition, throws invalid_argument if the checked records don't have it
+	*/
+	static size_t requireColumn(const InternalQuery& condition, size_t column)
+	{
+		if (column == NO_COLUMN)
+			throw invalid_argument("There is no column with name {" + condition.getColumn() + "} in the table.");
+
+		return column;
 	}
 
 private:
 	unordered_map<string, InternalQuery> fNumberedQueries;
 	vector<InternalQuery> fPrimaryKeyQueries;
 	queue<string> fShuntingOutput;
+	/// The postfix expression compiled by compile, the columns of its steps are not resolved
+	vector<Step> fSteps;
+	/// Copies of the conditions, indexed by the steps
+	vector<InternalQuery> fConditions;
 	string fQuery;
+	/// The numbers of the conditions whose value is ?, in order, and the types of their columns
+	vector<pair<string, string>> fParameters;
 };
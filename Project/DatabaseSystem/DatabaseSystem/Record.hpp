@@ -1,7 +1,12 @@
 #pragma once
 #include<vector>
+#include<algorithm>
+#include<memory_resource>
 #include "TypeWrapper.hpp"
+#include "PageLayout.hpp"
+#include "Arena.hpp"
 #include "ObjectType.h"
+#include "Snapshot.hpp"
 
 using std::vector;
 
@@ -10,32 +15,91 @@ class Record {
 	/**
 	 * @brief A record represents a row in a table. It consists of
 	 * an array of values.
+	 * Every record is a version of a row - it remembers the transaction that created it
+	 * and the one that deleted it (0 if it is still alive).
+	 * The values are allocated from the arena of the statement that is being executed.
 	 */
 private:
+	/// Flags of a record in the compact encoding
+	static constexpr unsigned char INVALID = 1, DELETED = 2, HAS_EMPTY = 4;
+
 	bool fIsInvalidated;
-	vector<TypeWrapper> fValues;
+	size_t fCreatedTxn, fDeletedTxn;
+	std::pmr::vector<TypeWrapper> fValues;
 	size_t fColumns;
 
 public:
-	Record() :fColumns(0), fIsInvalidated(false) {}
+	Record() :fColumns(0), fIsInvalidated(false), fCreatedTxn(0), fDeletedTxn(0), fValues(Arena::current()) {}
 
-	Record(std::ifstream& in)
+	/**
+	 * @brief Read a record of a page written before the compact encoding, every cell carrying its own type
+	 */
+	Record(BinaryReader& in) : fValues(Arena::current())
 	{
-		in.read((char*)&fIsInvalidated, sizeof(fIsInvalidated));
-		in.read((char*)&fColumns, sizeof(fColumns));
+		in.read(fIsInvalidated);
+		in.read(fCreatedTxn);
+		in.read(fDeletedTxn);
+		in.read(fColumns);
+		fValues.reserve(fColumns);
 		for (size_t i = 0; i < fColumns; i++)
 			fValues.push_back(TypeWrapper(in));
 	}
 
+	/**
+	 * @brief Read a record in the compact encoding: a flags byte, the transaction ids as varints,
+	 * a bitmap of the empty cells if there are any and then the cells without their types
+	 * @param layout - the encoding of the page holding the record
+	 */
+	Record(BinaryReader& in, const PageLayout& layout)
+		: fIsInvalidated(false), fCreatedTxn(0), fDeletedTxn(0), fValues(Arena::current()), fColumns(0)
+	{
+		unsigned char flags = 0;
+		in.read(flags);
+		if (flags & INVALID)
+		{
+			fIsInvalidated = true;
+			return;
+		}
+
+		fCreatedTxn = in.readVarint();
+		if (flags & DELETED)
+			fDeletedTxn = in.readVarint();
+
+		fColumns = layout.columns();
+		const char* emptyCells = (flags & HAS_EMPTY) ? in.readBytes((fColumns + 7) / 8) : nullptr;
+
+		fValues.reserve(fColumns);
+		for (size_t i = 0; i < fColumns; i++)
+		{
+			if (emptyCells && (emptyCells[i / 8] >> (i % 8)) & 1)
+				fValues.push_back(TypeWrapper());
+			else
+				fValues.push_back(layout.readCell(in, i));
+		}
+	}
+
 	/**
 	 * @brief Creates a new record
 	 * @param size number of columns of the table holding the record
 	 */
-	Record(size_t size) : fColumns(size), fIsInvalidated(false)
+	Record(size_t size) : fColumns(size), fIsInvalidated(false), fCreatedTxn(0), fDeletedTxn(0), fValues(Arena::current())
 	{
 		this->fValues.reserve(size);
 	}
 
+	/**
+	 * @brief Copy constructor. The copy takes its values from the current arena, not from the one of other
+	 */
+	Record(const Record& other)
+		: fIsInvalidated(other.fIsInvalidated), fCreatedTxn(other.fCreatedTxn), fDeletedTxn(other.fDeletedTxn),
+		fValues(other.fValues, Arena::current()), fColumns(other.fColumns) {}
+
+	Record(Record&& other) noexcept = default;
+
+	Record& operator=(const Record& other) = default;
+
+	Record& operator=(Record&& other) = default;
+
 	/**
 	 * Update the value for a given column in the record
 	 * @param index - the index of the column to be updated
@@ -63,19 +127,80 @@ public:
 	}
 
 	/**
-	 *  @brief Write a record to file
-	 *  @param out - output stream, used for writing
+	 *  @brief Write a record to file in the compact encoding
+	 *  @param out - the buffer of the file, used for writing
+	 *  @param layout - the encoding of the page holding the record
 	 */
-	void write(ofstream& out) const
+	void write(BinaryWriter& out, const PageLayout& layout) const
 	{
-		out.write((char*)&fIsInvalidated, sizeof(fIsInvalidated));
-		out.write((char*)&fColumns, sizeof(fColumns));
+		if (fIsInvalidated)
+		{
+			out.write(INVALID);
+			return;
+		}
+
+		if (fValues.size() != layout.columns())
+			throw std::logic_error("Record write(out, layout) - the record has " + to_string(fValues.size()) + " values, the page has " + to_string(layout.columns()) + " columns");
+
+		bool hasEmpty = std::any_of(fValues.begin(), fValues.end(), [](const TypeWrapper& value) { return value.isEmpty(); });
+		unsigned char flags = (fDeletedTxn != 0 ? DELETED : 0) | (hasEmpty ? HAS_EMPTY : 0);
+		out.write(flags);
+		out.writeVarint(fCreatedTxn);
+		if (fDeletedTxn != 0)
+			out.writeVarint(fDeletedTxn);
+
+		if (hasEmpty)
+		{
+			vector<char> emptyCells((fValues.size() + 7) / 8, 0);
+			for (size_t i = 0; i < fValues.size(); i++)
+				if (fValues[i].isEmpty())
+					emptyCells[i / 8] |= 1 << (i % 8);
+
+			out.writeBytes(emptyCells.data(), emptyCells.size());
+		}
+
 		for (size_t i = 0; i < fValues.size(); i++)
-			fValues[i].write(out);
+			if (!fValues[i].isEmpty())
+				layout.writeCell(out, i, fValues[i]);
 	}
 
 	/**
-	 * @brief Used when deleting a record, setting its invaldation state to true
+	 * @brief Set the transaction that created this version of the row
+	 */
+	void setCreatedTxn(size_t txnId) { fCreatedTxn = txnId; }
+
+	/**
+	 * @brief Used when deleting a record. The values are kept, because snapshots older than
+	 * the deleting transaction must still see the row. The vacuum reclaims them later.
+	 * @param txnId - the deleting transaction
+	 */
+	void markDeleted(size_t txnId) { fDeletedTxn = txnId; }
+
+	/**
+	 * @param snapshot - the read view of the query
+	 * @return True if this version of the row is visible to the given snapshot
+	 */
+	bool isVisibleTo(const Snapshot& snapshot) const
+	{
+		if (fIsInvalidated || !snapshot.sees(fCreatedTxn))
+			return false;
+
+		return fDeletedTxn == 0 || !snapshot.sees(fDeletedTxn);
+	}
+
+	/**
+	 * @param horizon - the oldest transaction id that is still needed by someone
+	 * @return True if the record is deleted and no alive snapshot can see it anymore
+	 */
+	bool isReclaimable(size_t horizon) const
+	{
+		return !fIsInvalidated && fDeletedTxn != 0 && fDeletedTxn < horizon;
+	}
+
+	bool isDeleted() const { return fDeletedTxn != 0; }
+
+	/**
+	 * @brief Used by the vacuum when reclaiming a version that nobody can see, setting its invaldation state to true
 	 * Because when remove operation is done in the Page class in real time, simply erasing the element is not enough
 	 * because the order and indexation of elements in the vector fValues gets mismatched.
 	*/
@@ -92,7 +217,7 @@ public:
 	{
 		size_t KB = 0;
 		for (size_t i = 0; i < fValues.size(); i++)
-			KB += fValues[i].getContent()->memsize();
+			KB += fValues[i].memsize();
 
 		return KB;
 	}
@@ -146,7 +271,7 @@ public:
 	{
 		std::string res;
 		for (size_t i = 0; i < fValues.size(); i++)
-			res += fValues[i].getContent()->toString() + "|";
+			res += fValues[i].toString() + "|";
 
 		return res;
 	}
@@ -1,8 +1,6 @@
 #pragma once
-#include<fstream>
-
-using std::ifstream;
-using std::ofstream;
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
 
 /**
  * @brief Descriptor of BPTree pointers to the records.
@@ -10,10 +8,10 @@ using std::ofstream;
 class RecordPtr
 {
 public:
-	RecordPtr(ifstream& in)
+	RecordPtr(BinaryReader& in)
 	{
-		in.read((char*)&pageNumber, sizeof(pageNumber));
-		in.read((char*)&indexInPage, sizeof(indexInPage));
+		in.read(pageNumber);
+		in.read(indexInPage);
 	}
 
 	RecordPtr() : pageNumber(-1), indexInPage(-1) {}
@@ -39,13 +37,13 @@ public:
 	/**
 	 * @brief Write metadata to file
 	*/
-	void write(ofstream& out) const
+	void write(BinaryWriter& out) const
 	{
-		out.write((char*)&pageNumber, sizeof(pageNumber));
-		out.write((char*)&indexInPage, sizeof(indexInPage));
+		out.write(pageNumber);
+		out.write(indexInPage);
 	}
 
-	bool operator<(const RecordPtr& other)
+	bool operator<(const RecordPtr& other) const
 	{
 		if (pageNumber < other.pageNumber)
 			return true;
@@ -56,7 +54,7 @@ public:
 		return false;
 	}
 
-	bool operator>(const RecordPtr& other)
+	bool operator>(const RecordPtr& other) const
 	{
 		if (pageNumber > other.pageNumber)
 			return true;
@@ -67,7 +65,7 @@ public:
 		return false;
 	}
 
-	bool operator==(const RecordPtr& other)
+	bool operator==(const RecordPtr& other) const
 	{
 		if (pageNumber == other.pageNumber && indexInPage == other.indexInPage)
 			return true;
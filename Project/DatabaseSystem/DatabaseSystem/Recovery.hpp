@@ -0,0 +1,146 @@
+#pragma once
+#include<algorithm>
+#include<atomic>
+#include<string>
+#include<thread>
+#include<vector>
+#include "DataBase.h"
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief The recovery check run at startup with --recover. Every page and Bloom filter file of every table is read and
+ * compared with its checksum, the files are spread over a thread per hardware thread. A table whose metadata can't be
+ * read is reported with the error, its files can't be checked or repaired.
+ * There is no log to replay, so a damaged page can't be restored - repairing empties it and compacts its table.
+ * Damaged Bloom filters are built again from their pages.
+*/
+class Recovery
+{
+public:
+	/// The damaged files of a table
+	struct Damage
+	{
+		Damage(const string& table) : table(table) {}
+
+		string table;
+		/// Why the metadata of the table couldn't be read, empty if it could
+		string metadataError;
+		vector<int> pages;
+		vector<int> blooms;
+	};
+
+	/**
+	 * @param db - the database to check
+	 * @param threads - number of threads reading the files, 0 for one per hardware thread
+	*/
+	Recovery(DataBase& db, size_t threads = 0) : fDataBase(db), fThreads(threads), fCheckedFiles(0), fUncheckedFiles(0)
+	{
+		if (fThreads == 0)
+			fThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/**
+	 * @brief Check all the files of the database
+	 * @return the tables with damaged files
+	*/
+	const vector<Damage>& check()
+	{
+		vector<Damage> tables;
+		vector<File> files;
+		for (const string& name : fDataBase.getTableNames())
+		{
+			tables.push_back(Damage(name));
+			try
+			{
+				const Table& table = fDataBase.getTable(name);
+				for (int index = 0; index < (int)table.getPagesCount(); index++)
+				{
+					files.push_back(File{ tables.size() - 1, &table, index, false });
+					if (!table.getBloomColumns().empty())
+						files.push_back(File{ tables.size() - 1, &table, index, true });
+				}
+			}
+			catch (const std::exception& e)
+			{
+				tables.back().metadataError = e.what();
+			}
+		}
+
+		vector<BufferPool::FileState> states(files.size());
+		std::atomic<size_t> next{ 0 };
+		vector<std::thread> threads;
+		for (size_t t = 0; t < std::min(fThreads, files.size()); t++)
+		{
+			threads.emplace_back([&]() {
+				for (size_t i = next++; i < files.size(); i = next++)
+					states[i] = files[i].bloom ? files[i].table->verifyBlooms(files[i].index) : files[i].table->verifyPage(files[i].index);
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		fCheckedFiles = files.size();
+		fUncheckedFiles = std::count(states.begin(), states.end(), BufferPool::FileState::UNCHECKED);
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			if (states[i] != BufferPool::FileState::DAMAGED)
+				continue;
+
+			Damage& damage = tables[files[i].damage];
+			(files[i].bloom ? damage.blooms : damage.pages).push_back(files[i].index);
+		}
+
+		fDamaged.clear();
+		for (Damage& damage : tables)
+			if (!damage.metadataError.empty() || !damage.pages.empty() || !damage.blooms.empty())
+				fDamaged.push_back(std::move(damage));
+
+		return fDamaged;
+	}
+
+	/**
+	 * @brief Repair the tables found damaged by the last check, except those with damaged metadata
+	 * @return the number of repaired tables
+	*/
+	size_t repair()
+	{
+		size_t repaired = 0;
+		for (const Damage& damage : fDamaged)
+		{
+			if (!damage.metadataError.empty())
+				continue;
+
+			fDataBase.repairTable(damage.table, damage.pages, damage.blooms);
+			repaired++;
+		}
+
+		return repaired;
+	}
+
+	size_t getCheckedFiles() const { return fCheckedFiles; }
+
+	/**
+	 * @return the number of files written before the checksums, they could only be decoded
+	*/
+	size_t getUncheckedFiles() const { return fUncheckedFiles; }
+
+	size_t getThreadsCount() const { return fThreads; }
+
+private:
+	struct File
+	{
+		/// Position of the table in the list of check()
+		size_t damage;
+		const Table* table;
+		int index;
+		bool bloom;
+	};
+
+	DataBase& fDataBase;
+	size_t fThreads;
+	size_t fCheckedFiles, fUncheckedFiles;
+	vector<Damage> fDamaged;
+};
\ No newline at end of file
@@ -0,0 +1,202 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<stdexcept>
+#include<unordered_map>
+#include "Record.hpp"
+#include "CommandType.h"
+#include "StringHelper.hpp"
+
+using std::vector;
+using std::string;
+using std::invalid_argument;
+using std::out_of_range;
+using std::unordered_map;
+using sh = StringHelper;
+
+/**
+ * @brief Descriptor of the result of one statement run through a Connection. A Select gives the selected columns and a cursor over
+ * the selected rows, holding typed values: next() moves to the following row and get/getInt/getDouble/getString read its cells.
+ * The other statements give a message and the number of rows they changed.
+ * The values are copied out of the records of the statement, so the result stays valid after the next statement.
+*/
+class ResultSet
+{
+public:
+	ResultSet() : fType(CommandType::NONE), fAffectedRows(0), fPosition(0) {}
+
+	/**
+	 * @brief The result of a Select
+	 * @param columns - names of the selected columns, in order
+	 * @param records - the selected records
+	 * @param colIndex - the columns of the records and their indices
+	 * @param type - the type of the statement, a Select or a listing like ListTables
+	*/
+	ResultSet(const vector<string>& columns, const vector<Record>& records, const unordered_map<string, size_t>& colIndex,
+		CommandType type = CommandType::SELECT)
+		: fType(type), fColumns(columns), fAffectedRows(0), fPosition(0)
+	{
+		vector<size_t> indices;
+		for (const string& col : columns)
+		{
+			auto it = colIndex.find(col);
+			if (it == colIndex.end())
+				throw invalid_argument("There is no column with name {" + col + "} in the table.");
+
+			indices.push_back(it->second);
+		}
+
+		fRows.reserve(records.size());
+		for (const Record& r : records)
+		{
+			vector<TypeWrapper> row;
+			row.reserve(indices.size());
+			for (size_t index : indices)
+				row.push_back(r.get(index));
+
+			fRows.push_back(std::move(row));
+		}
+	}
+
+	/**
+	 * @brief The result of a statement that selects nothing
+	 * @param type - the type of the statement
+	 * @param message - what the statement did
+	 * @param affectedRows - how many rows the statement inserted or deleted
+	*/
+	ResultSet(CommandType type, const string& message, size_t affectedRows = 0)
+		: fType(type), fMessage(message), fAffectedRows(affectedRows), fPosition(0) {}
+
+	/**
+	 * @brief A result put back together from its parts, i.e. received from a server
+	*/
+	ResultSet(CommandType type, vector<string> columns, vector<vector<TypeWrapper>> rows, const string& message, size_t affectedRows)
+		: fType(type), fColumns(std::move(columns)), fRows(std::move(rows)), fMessage(message), fAffectedRows(affectedRows), fPosition(0) {}
+
+	/**
+	 * @return the type of the statement that gave the result
+	*/
+	CommandType getType() const { return fType; }
+
+	/**
+	 * @brief Move to the following row, the first call moves to the first row
+	 * @return False if there are no more rows
+	*/
+	bool next()
+	{
+		if (fPosition > fRows.size())
+			return false;
+
+		return ++fPosition <= fRows.size();
+	}
+
+	/**
+	 * @brief Move back before the first row
+	*/
+	void rewind() { fPosition = 0; }
+
+	size_t getRowsCount() const { return fRows.size(); }
+
+	size_t getColumnsCount() const { return fColumns.size(); }
+
+	const vector<string>& getColumnNames() const { return fColumns; }
+
+	/**
+	 * @return the index of a selected column by its name, throws invalid_argument if it wasn't selected
+	*/
+	size_t getColumnIndex(const string& name) const
+	{
+		for (size_t i = 0; i < fColumns.size(); i++)
+			if (fColumns[i] == name)
+				return i;
+
+		throw invalid_argument("There is no column with name {" + name + "} in the result.");
+	}
+
+	/**
+	 * @return a row by its index, regardless of the cursor
+	*/
+	const vector<TypeWrapper>& getRow(size_t row) const
+	{
+		if (row >= fRows.size())
+			throw out_of_range("There is no row " + std::to_string(row) + " in the result.");
+
+		return fRows[row];
+	}
+
+	/**
+	 * @return a cell of the current row, empty if the row has no value in it
+	*/
+	const TypeWrapper& get(size_t column) const
+	{
+		if (fPosition == 0 || fPosition > fRows.size())
+			throw out_of_range("The cursor is not on a row, call next() first.");
+		if (column >= fColumns.size())
+			throw out_of_range("There is no column " + std::to_string(column) + " in the result.");
+
+		return fRows[fPosition - 1][column];
+	}
+
+	const TypeWrapper& get(const string& column) const { return get(getColumnIndex(column)); }
+
+	bool isNull(size_t column) const { return get(column).isEmpty(); }
+
+	/**
+	 * @return the value of an Integer cell, throws invalid_argument for a cell of another type
+	*/
+	int getInt(size_t column) const
+	{
+		const TypeWrapper& cell = get(column);
+		if (cell.getType() != ObjectType::INT)
+			throw invalid_argument("Column {" + fColumns[column] + "} doesn't hold an Integer.");
+
+		return cell.getInt();
+	}
+
+	/**
+	 * @return the value of a Double or an Integer cell, throws invalid_argument for a cell of another type
+	*/
+	double getDouble(size_t column) const
+	{
+		const TypeWrapper& cell = get(column);
+		if (cell.getType() == ObjectType::INT)
+			return cell.getInt();
+		if (cell.getType() != ObjectType::DOUBLE)
+			throw invalid_argument("Column {" + fColumns[column] + "} doesn't hold a Double.");
+
+		return cell.getDouble();
+	}
+
+	/**
+	 * @return the value of a String cell without its quotes, throws invalid_argument for a cell of another type
+	*/
+	string getString(size_t column) const
+	{
+		const TypeWrapper& cell = get(column);
+		if (cell.getType() != ObjectType::STRING)
+			throw invalid_argument("Column {" + fColumns[column] + "} doesn't hold a String.");
+
+		string value(cell.getString());
+		sh::removeQuotations(value);
+		return value;
+	}
+
+	int getInt(const string& column) const { return getInt(getColumnIndex(column)); }
+
+	double getDouble(const string& column) const { return getDouble(getColumnIndex(column)); }
+
+	string getString(const string& column) const { return getString(getColumnIndex(column)); }
+
+	const string& getMessage() const { return fMessage; }
+
+	size_t getAffectedRows() const { return fAffectedRows; }
+
+private:
+	CommandType fType;
+	vector<string> fColumns;
+	vector<vector<TypeWrapper>> fRows;
+	string fMessage;
+	size_t fAffectedRows;
+	/// The current row is fPosition - 1, 0 is before the first row
+	size_t fPosition;
+};
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "Server.h"
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Server::Server(Connection& connection, const string& socketPath, size_t workers)
+	: fConnection(connection), fSocketPath(socketPath), fWorkersCount(workers), fListener(-1), fSignals(-1), fWakeup(-1), fEpoll(-1),
+	fNextSession(WAKEUP + 1), fSessionsCount(0), fStatementsCount(0), fStopping(false)
+{
+	if (fWorkersCount == 0)
+		fWorkersCount = std::max(1u, std::thread::hardware_concurrency());
+}
+
+Server::~Server()
+{
+	for (pair<const uint64_t, Session>& entry : fSessions)
+		close(entry.second.socket);
+
+	for (int descriptor : { fListener, fSignals, fWakeup, fEpoll })
+		if (descriptor >= 0)
+			close(descriptor);
+
+	if (fListener >= 0)
+		unlink(fSocketPath.c_str());
+}
+
+void Server::run()
+{
+	// SIGINT and SIGTERM are read from a descriptor by the loop, the workers inherit the mask and never get them
+	sigset_t stopSignals, previousMask;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &stopSignals, &previousMask);
+
+	for (size_t i = 0; i < fWorkersCount; i++)
+		fWorkers.emplace_back(&Server::work, this);
+
+	const int MAX_EVENTS = 64;
+	epoll_event events[MAX_EVENTS];
+	bool running = true;
+	while (running)
+	{
+		int count = epoll_wait(fEpoll, events, MAX_EVENTS, -1);
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count < 0)
+			break;
+
+		for (int i = 0; i < count; i++)
+		{
+			uint64_t key = events[i].data.u64;
+			if (key == LISTENER)
+				acceptSessions();
+			else if (key == SIGNALS)
+			{
+				// Read so that the signal isn't delivered again when the mask is restored
+				signalfd_siginfo signal;
+				read(fSignals, &signal, sizeof(signal));
+				running = false;
+			}
+			else if (key == WAKEUP)
+				deliver();
+			else
+			{
+				if (events[i].events & EPOLLOUT)
+					sendResponses(key);
+				if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					receiveRequests(key);
+			}
+		}
+	}
+
+	// The workers run the statements already queued before they stop
+	{
+		lock_guard<mutex> lock(fJobsMutex);
+		fStopping = true;
+	}
+	fJobsReady.notify_all();
+	for (std::thread& worker : fWorkers)
+		worker.join();
+
+	fWorkers.clear();
+	pthread_sigmask(SIG_SETMASK, &previousMask, nullptr);
+}
+
+bool Server::open()
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (fSocketPath.size() >= sizeof(address.sun_path))
+		return false;
+
+	std::memcpy(address.sun_path, fSocketPath.c_str(), fSocketPath.size() + 1);
+
+	// A socket file that no server answers on is left from a server that was killed
+	int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	bool taken = probe >= 0 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+	if (probe >= 0)
+		close(probe);
+	if (taken)
+		return false;
+
+	unlink(fSocketPath.c_str());
+	fListener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fListener < 0 || bind(fListener, (sockaddr*)&address, sizeof(address)) < 0 || listen(fListener, SOMAXCONN) < 0)
+		return false;
+
+	sigset_t stopSignals;
+	sigemptyset(&stopSignals);
+	sigaddset(&stopSignals, SIGINT);
+	sigaddset(&stopSignals, SIGTERM);
+	fSignals = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+	fWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	fEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if (fSignals < 0 || fWakeup < 0 || fEpoll < 0)
+		return false;
+
+	watch(fListener, LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+	watch(fSignals, SIGNALS, EPOLLIN, EPOLL_CTL_ADD);
+	watch(fWakeup, WAKEUP, EPOLLIN, EPOLL_CTL_ADD);
+	return true;
+}
+
+void Server::acceptSessions()
+{
+	while (true)
+	{
+		int socket = accept4(fListener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (socket < 0)
+			return;
+
+		uint64_t id = fNextSession++;
+		fSessions[id].socket = socket;
+		fSessionsCount++;
+		watch(socket, id, EPOLLIN, EPOLL_CTL_ADD);
+	}
+}
+
+void Server::receiveRequests(uint64_t id)
+{
+	auto it = fSessions.find(id);
+	if (it == fSessions.end())
+		return;
+
+	Session& session = it->second;
+	char buffer[64 * 1024];
+	while (true)
+	{
+		ssize_t received = recv(session.socket, buffer, sizeof(buffer), 0);
+		if (received > 0)
+		{
+			session.input.insert(session.input.end(), buffer, buffer + received);
+			continue;
+		}
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+
+		// The client has gone, a statement of it that is still running finishes for nobody
+		closeSession(id);
+		return;
+	}
+
+	size_t consumed = 0;
+	uint32_t size = 0;
+	try
+	{
+		while (Protocol::hasFrame(session.input.data() + consumed, session.input.size() - consumed, size))
+		{
+			const char* payload = session.input.data() + consumed + Protocol::HEADER_SIZE;
+			session.pending.emplace_back(payload, size);
+			consumed += Protocol::HEADER_SIZE + size;
+		}
+	}
+	catch (const std::length_error&)
+	{
+		closeSession(id);
+		return;
+	}
+
+	session.input.erase(session.input.begin(), session.input.begin() + consumed);
+	dispatch(id);
+}
+
+void Server::sendResponses(uint64_t id)
+{
+	auto it = fSessions.find(id);
+	if (it == fSessions.end())
+		return;
+
+	Session& session = it->second;
+	while (session.written < session.output.size())
+	{
+		ssize_t sent = ::send(session.socket, session.output.data() + session.written, session.output.size() - session.written, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (sent < 0)
+		{
+			closeSession(id);
+			return;
+		}
+
+		session.written += sent;
+	}
+
+	bool pendingOutput = session.written < session.output.size();
+	if (!pendingOutput)
+	{
+		session.output.clear();
+		session.written = 0;
+		if (session.closing)
+		{
+			closeSession(id);
+			return;
+		}
+	}
+
+	if (pendingOutput != session.watchingOutput)
+	{
+		session.watchingOutput = pendingOutput;
+		watch(session.socket, id, pendingOutput ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+	}
+}
+
+void Server::dispatch(uint64_t id)
+{
+	Session& session = fSessions.at(id);
+	if (session.busy || session.closing || session.pending.empty())
+		return;
+
+	string statement = std::move(session.pending.front());
+	session.pending.pop_front();
+
+	// Exit ends the session, not the server
+	if (isExit(statement))
+	{
+		vector<char> frame = Protocol::encodeResult(ResultSet(CommandType::EXIT, "Goodbye"));
+		session.output.insert(session.output.end(), frame.begin(), frame.end());
+		session.pending.clear();
+		session.closing = true;
+		sendResponses(id);
+		return;
+	}
+
+	session.busy = true;
+	{
+		lock_guard<mutex> lock(fJobsMutex);
+		fJobs.push_back(Job{ id, std::move(statement) });
+	}
+	fJobsReady.notify_one();
+}
+
+void Server::deliver()
+{
+	uint64_t signalled = 0;
+	read(fWakeup, &signalled, sizeof(signalled));
+
+	vector<Response> responses;
+	{
+		lock_guard<mutex> lock(fResponsesMutex);
+		responses.swap(fResponses);
+	}
+
+	for (Response& response : responses)
+	{
+		fStatementsCount++;
+		auto it = fSessions.find(response.session);
+		if (it == fSessions.end())
+		{
+			// The statement ran after its session was closed, what it prepared is forgotten again
+			forgetSession(response.session);
+			continue;
+		}
+
+		Session& session = it->second;
+		session.busy = false;
+		session.output.insert(session.output.end(), response.frame.begin(), response.frame.end());
+		dispatch(response.session);
+		sendResponses(response.session);
+	}
+}
+
+void Server::closeSession(uint64_t id)
+{
+	auto it = fSessions.find(id);
+	if (it == fSessions.end())
+		return;
+
+	epoll_ctl(fEpoll, EPOLL_CTL_DEL, it->second.socket, nullptr);
+	close(it->second.socket);
+	fSessions.erase(it);
+	forgetSession(id);
+}
+
+void Server::forgetSession(uint64_t id)
+{
+	lock_guard<mutex> lock(fConnectionMutex);
+	fConnection.endSession(id);
+}
+
+void Server::watch(int descriptor, uint64_t key, uint32_t events, int operation)
+{
+	epoll_event event{};
+	event.events = events;
+	event.data.u64 = key;
+	epoll_ctl(fEpoll, operation, descriptor, &event);
+}
+
+void Server::work()
+{
+	while (true)
+	{
+		Job job;
+		{
+			unique_lock<mutex> lock(fJobsMutex);
+			fJobsReady.wait(lock, [this]() { return fStopping || !fJobs.empty(); });
+			if (fJobs.empty())
+				return;
+
+			job = std::move(fJobs.front());
+			fJobs.pop_front();
+		}
+
+		vector<char> frame;
+		try
+		{
+			ResultSet result;
+			{
+				lock_guard<mutex> lock(fConnectionMutex);
+				fConnection.setSession(job.session);
+				result = fConnection.execute(job.statement);
+			}
+			frame = Protocol::encodeResult(result);
+		}
+		catch (const std::exception& e)
+		{
+			frame = Protocol::encodeError(e.what());
+		}
+
+		{
+			lock_guard<mutex> lock(fResponsesMutex);
+			fResponses.push_back(Response{ job.session, std::move(frame) });
+		}
+
+		uint64_t one = 1;
+		write(fWakeup, &one, sizeof(one));
+	}
+}
+
+bool Server::isExit(const string& statement)
+{
+	string command = statement.substr(0, statement.find(' '));
+	return sh::toUpper(sh::trim(command)) == "EXIT";
+}
+#endif
\ No newline at end of file
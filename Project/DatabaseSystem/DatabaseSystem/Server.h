@@ -0,0 +1,152 @@
+#pragma once
+#ifdef __linux__
+#include<condition_variable>
+#include<cstdint>
+#include<deque>
+#include<mutex>
+#include<thread>
+#include<unordered_map>
+#include "Connection.h"
+#include "Protocol.hpp"
+
+using std::condition_variable;
+using std::deque;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::unordered_map;
+
+/**
+ * @brief Descriptor of the server mode, in which the processes of the host share one database. Each of them opens a session
+ * over a Unix socket and sends statements in the frames of Protocol. One thread watches all the sockets with epoll, it reads
+ * the requests and writes the responses without blocking. The statements run on a pool of worker threads.
+ * The Connection isn't thread safe, so the workers take turns running statements on it - the encoding of the results
+ * and all the I/O happen outside of the turns. The statements of one session run one at a time, in their order.
+ * A batch (BEGIN / COMMIT) is of the database: while one is open the statements of every session are saved at its COMMIT,
+ * but only the session that started it may COMMIT it, and it is committed when that session ends. The statements made
+ * by Prepare are of the session, another session may use the same names.
+*/
+class Server
+{
+public:
+	/**
+	 * @param connection - the database to serve
+	 * @param socketPath - path of the socket to listen on
+	 * @param workers - number of worker threads, 0 for one per hardware thread
+	*/
+	Server(Connection& connection, const string& socketPath, size_t workers = 0);
+
+	Server(const Server& other) = delete;
+	Server& operator=(const Server& other) = delete;
+
+	~Server();
+
+	/**
+	 * @brief Open the socket. A socket file left by a server that was killed is replaced
+	 * @return False if the path is too long, another server listens on it or the socket couldn't be opened
+	*/
+	bool open();
+
+	/**
+	 * @brief Serve the sessions until SIGINT or SIGTERM, after open. The statements already handed to the workers finish
+	 * before it returns
+	*/
+	void run();
+
+	size_t getSessionsCount() const { return fSessionsCount; }
+
+	size_t getStatementsCount() const { return fStatementsCount; }
+
+	size_t getWorkersCount() const { return fWorkersCount; }
+
+private:
+	struct Session
+	{
+		int socket;
+		vector<char> input;
+		vector<char> output;
+		/// Bytes of output already sent
+		size_t written = 0;
+		/// Statements received while an earlier one runs
+		deque<string> pending;
+		/// A statement of the session is on the workers
+		bool busy = false;
+		/// EPOLLOUT is watched, the output didn't fit in the socket
+		bool watchingOutput = false;
+		/// Exit was received, the session ends when its output is sent
+		bool closing = false;
+	};
+
+	struct Job
+	{
+		uint64_t session;
+		string statement;
+	};
+
+	struct Response
+	{
+		uint64_t session;
+		vector<char> frame;
+	};
+
+	/// epoll keys of the descriptors that aren't sessions, the sessions are numbered after them
+	static constexpr uint64_t LISTENER = 0, SIGNALS = 1, WAKEUP = 2;
+
+	Connection& fConnection;
+	string fSocketPath;
+	size_t fWorkersCount;
+	int fListener, fSignals, fWakeup, fEpoll;
+	uint64_t fNextSession;
+	unordered_map<uint64_t, Session> fSessions;
+	size_t fSessionsCount, fStatementsCount;
+
+	vector<std::thread> fWorkers;
+	/// Guards fJobs and fStopping
+	mutex fJobsMutex;
+	condition_variable fJobsReady;
+	deque<Job> fJobs;
+	bool fStopping;
+	/// Only one worker runs a statement at a time
+	mutex fConnectionMutex;
+	mutex fResponsesMutex;
+	vector<Response> fResponses;
+
+	void acceptSessions();
+
+	/**
+	 * @brief Read what the session sent and queue its whole frames
+	*/
+	void receiveRequests(uint64_t id);
+
+	/**
+	 * @brief Send as much of the output of the session as the socket takes, watching EPOLLOUT for the rest
+	*/
+	void sendResponses(uint64_t id);
+
+	/**
+	 * @brief Hand the next statement of the session to the workers, if it has none on them
+	*/
+	void dispatch(uint64_t id);
+
+	/**
+	 * @brief Append the responses of the finished statements to the output of their sessions
+	*/
+	void deliver();
+
+	void closeSession(uint64_t id);
+
+	/**
+	 * @brief Drop the statements the session prepared on the connection
+	*/
+	void forgetSession(uint64_t id);
+
+	void watch(int descriptor, uint64_t key, uint32_t events, int operation);
+
+	/**
+	 * @brief The loop of a worker thread: run the queued statements until the server stops
+	*/
+	void work();
+
+	static bool isExit(const string& statement);
+};
+#endif
\ No newline at end of file
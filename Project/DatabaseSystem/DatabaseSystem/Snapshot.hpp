@@ -0,0 +1,58 @@
+#pragma once
+#include<set>
+#include<cstdint>
+
+using std::set;
+
+/**
+ * @brief Descriptor of a read view over the versions of the records.
+ * A snapshot sees every transaction that has committed before the snapshot was taken,
+ * together with the changes made by the transaction owning the snapshot (if there is one).
+ * Transaction id 0 is reserved for frozen versions, which are visible to everyone.
+*/
+class Snapshot
+{
+public:
+	Snapshot() : fOwnTxn(0), fHorizon(SIZE_MAX), fOldestNeeded(SIZE_MAX) {}
+
+	/**
+	 * @param ownTxn - id of the transaction owning the snapshot, 0 for read-only snapshots
+	 * @param horizon - the first transaction id that was not yet started when the snapshot was taken
+	 * @param inProgress - transactions that were running when the snapshot was taken
+	*/
+	Snapshot(size_t ownTxn, size_t horizon, const set<size_t>& inProgress)
+		: fOwnTxn(ownTxn), fHorizon(horizon), fInProgress(inProgress)
+	{
+		fOldestNeeded = fInProgress.empty() ? fHorizon : *fInProgress.begin();
+	}
+
+	/**
+	 * @brief Check whether the changes of a transaction are visible in this snapshot
+	 * @param txnId - id of the transaction that made the change
+	 * @return True if the transaction has committed before the snapshot was taken or owns it
+	*/
+	bool sees(size_t txnId) const
+	{
+		if (txnId == 0 || txnId == fOwnTxn)
+			return true;
+
+		return txnId < fHorizon && fInProgress.find(txnId) == fInProgress.end();
+	}
+
+	/**
+	 * @return the oldest transaction id whose changes this snapshot may still not see.
+	 * Versions deleted before that id can never be seen through this snapshot.
+	*/
+	size_t getOldestNeeded() const { return fOldestNeeded; }
+
+	size_t getOwnTxn() const { return fOwnTxn; }
+
+	/**
+	 * @return True if no other transaction was running when the snapshot was taken, so it sees the latest state of the tables
+	*/
+	bool isLatest() const { return fInProgress.empty(); }
+
+private:
+	size_t fOwnTxn, fHorizon, fOldestNeeded;
+	set<size_t> fInProgress;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<fstream>
+#include<filesystem>
+#include<stdexcept>
+#include "Record.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::vector;
+using std::string;
+using std::ofstream;
+
+/**
+ * @brief Descriptor of a temporary file holding the records of one partition of an operator that outgrew its memory
+ * budget (a join or an aggregation). The records are buffered and appended to the file, then read back all at once.
+ * Only the values of the records are kept, not their versions - the records were already checked against the snapshot.
+ * The file is removed when it is read back or when the spill file is destroyed.
+*/
+class SpillFile
+{
+public:
+	SpillFile() = default;
+
+	SpillFile(const SpillFile& other) = delete;
+	SpillFile& operator=(const SpillFile& other) = delete;
+
+	~SpillFile()
+	{
+		if (!fPath.empty())
+		{
+			fFile.close();
+			std::error_code errorCode;
+			std::filesystem::remove(fPath, errorCode);
+		}
+	}
+
+	void open(const string& path)
+	{
+		fPath = path;
+		fFile.open(path, std::ios::binary | std::ios::trunc);
+		if (!fFile.is_open())
+			throw std::invalid_argument("Couldn't open " + path + " for spilling records");
+	}
+
+	bool isOpen() const { return !fPath.empty(); }
+
+	void add(const Record& r)
+	{
+		fBuffer.writeVarint(r.size());
+		for (size_t i = 0; i < r.size(); i++)
+			r.get(i).write(fBuffer);
+
+		if (fBuffer.size() >= BUFFER_SIZE)
+			flush();
+	}
+
+	/**
+	 * @brief Read back all records of the file, the file is removed after that
+	*/
+	vector<Record> readAll()
+	{
+		vector<Record> records;
+		if (!isOpen())
+			return records;
+
+		flush();
+		fFile.close();
+		{
+			BinaryReader in(fPath);
+			while (!in.eof())
+			{
+				Record r(in.readVarint());
+				for (size_t i = 0; i < r.size(); i++)
+					r.addValue(TypeWrapper(in));
+
+				records.push_back(std::move(r));
+			}
+		}
+
+		std::error_code errorCode;
+		std::filesystem::remove(fPath, errorCode);
+		fPath.clear();
+		return records;
+	}
+
+private:
+	static const size_t BUFFER_SIZE = 64 * 1024;
+
+	string fPath;
+	ofstream fFile;
+	BinaryWriter fBuffer;
+
+	void flush()
+	{
+		vector<char> bytes = fBuffer.release();
+		fFile.write(bytes.data(), bytes.size());
+	}
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include<string>
+#include<string_view>
+#include<unordered_map>
+#include<functional>
+#include<atomic>
+#include<mutex>
+
+using std::string;
+using std::string_view;
+using std::unordered_map;
+using std::mutex;
+using std::lock_guard;
+
+/**
+ * @brief Descriptor of string pool singleton class. Strings too long to fit inside a cell are stored once here,
+ * so the cells holding the same value share it and can be compared by address.
+ * Every string counts the cells holding it and is released by the last of them, so the strings of deleted
+ * and vacuumed records don't stay in memory. The strings are split between SHARDS maps with a mutex each,
+ * so decoding pages on several threads rarely waits. Copying a cell only counts one more reference.
+*/
+class StringPool
+{
+public:
+	/// A pooled string and the number of cells holding it
+	struct Entry
+	{
+		Entry(string_view value) : value(value), references(1) {}
+
+		const string value;
+		mutable std::atomic<size_t> references;
+	};
+
+	static StringPool& getInstance()
+	{
+		// Never destroyed, cells in static storage may release their strings while the program exits
+		static StringPool* inst = new StringPool();
+		return *inst;
+	}
+
+	StringPool(const StringPool& other) = delete;
+	StringPool& operator=(const StringPool& other) = delete;
+	StringPool(StringPool&& other) = delete;
+	StringPool& operator=(StringPool&& other) = delete;
+
+	/**
+	 * @brief Find the pooled copy of a string, adding it if it is not there yet. The caller holds a reference to it
+	 * @param value - the string
+	 * @return the pooled copy
+	*/
+	const Entry* intern(string_view value)
+	{
+		Shard& shard = shardOf(value);
+		lock_guard<mutex> lock(shard.entriesMutex);
+		auto it = shard.entries.find(value);
+		if (it != shard.entries.end())
+		{
+			// An entry without references is being released by another thread and can't be taken back, a new one replaces it
+			size_t references = it->second->references.load();
+			while (references != 0)
+				if (it->second->references.compare_exchange_weak(references, references + 1))
+					return it->second;
+
+			shard.entries.erase(it);
+		}
+
+		Entry* entry = new Entry(value);
+		shard.entries.emplace(entry->value, entry);
+		return entry;
+	}
+
+	/**
+	 * @brief Count one more cell holding a pooled string, the caller already holds a reference to it
+	*/
+	void retain(const Entry* entry)
+	{
+		entry->references.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Drop a reference to a pooled string, the last one removes it from the pool
+	*/
+	void release(const Entry* entry)
+	{
+		if (entry->references.fetch_sub(1) != 1)
+			return;
+
+		// Nobody can take the entry back now, so it is read without the lock
+		Shard& shard = shardOf(entry->value);
+		{
+			lock_guard<mutex> lock(shard.entriesMutex);
+			auto it = shard.entries.find(entry->value);
+			if (it != shard.entries.end() && it->second == entry)
+				shard.entries.erase(it);
+		}
+
+		delete entry;
+	}
+
+	/**
+	 * @return the number of pooled strings
+	*/
+	size_t size() const
+	{
+		size_t count = 0;
+		for (const Shard& shard : fShards)
+		{
+			lock_guard<mutex> lock(shard.entriesMutex);
+			count += shard.entries.size();
+		}
+
+		return count;
+	}
+
+private:
+	static const size_t SHARDS = 64;
+
+	struct Shard
+	{
+		mutable mutex entriesMutex;
+		/// The keys view the values of the entries
+		unordered_map<string_view, Entry*> entries;
+	};
+
+	StringPool() {}
+
+	Shard& shardOf(string_view value)
+	{
+		return fShards[std::hash<string_view>()(value) % SHARDS];
+	}
+
+	Shard fShards[SHARDS];
+};
\ No newline at end of file
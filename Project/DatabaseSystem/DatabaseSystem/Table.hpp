@@ -5,18 +5,22 @@
 #include<list>
 #include<map>
 #include<unordered_map>
+#include<functional>
 #include <filesystem>
 #include "Page.hpp"
 #include "BPTree.hpp"
-#include "FileHelper.hpp"
 #include "Query.hpp"
 #include "SortingHelper.h"
+#include "TransactionManager.hpp"
+#include "FreeSpaceMap.hpp"
+#include "ZoneMap.hpp"
+#include "BloomFilter.hpp"
+#include "HashIndex.hpp"
+#include "IndexType.h"
 
 using std::multimap;
 using std::map;
 using std::unordered_map;
-using std::ifstream;
-using std::ofstream;
 using std::string;
 using std::to_string;
 using std::pair;
@@ -26,12 +30,12 @@ using std::logic_error;
 using std::list;
 
 namespace fs = std::filesystem;
-using fh = FileHelper;
 
 class Table
 {
 public:
-	Table() : curPageIndex(0), numOfColumns(0), bytes(0), maxRecordsPerPage(1024) {}
+	Table() : curPageIndex(0), numOfColumns(0), bytes(0), maxRecordsPerPage(1024), deadVersions(0), liveRecords(0), usedSlots(0), autoVacuumRatio(0),
+		indexType(IndexType::BPTREE) {}
 
 	/**
 	 * Create a new table with the specified parameter list
@@ -39,11 +43,15 @@ public:
 	 * @param strTableName the table name
 	 * @param htblColNameType the types of table columns
 	 * @param strKeyColName the primary key of the table
+	 * @param indexType whether the primary key is indexed by a B+ tree or by a hash index
 	 * @param maxTuplesPerPage the maximum number of records a page can hold
 	 */
 	Table(const string& path, const string& tableName, unordered_map<string, string>& colNameType, vector<string>& colNames,
-		const string& indexedColName, int maxRecordsPerPage)
+		const string& indexedColName, IndexType indexType, int maxRecordsPerPage)
 	{
+		if (indexType == IndexType::HASH && colNameType.count(indexedColName) && colNameType.at(indexedColName) == "Double")
+			throw invalid_argument("Hash index is supported only on Integer and String columns");
+
 		this->path = path + tableName + "/";
 		this->tableName = tableName;
 		this->primaryKey = indexedColName;
@@ -52,6 +60,11 @@ public:
 		this->curPageIndex = -1;
 		this->numOfColumns = 0;
 		this->bytes = 0;
+		this->deadVersions = 0;
+		this->liveRecords = 0;
+		this->usedSlots = 0;
+		this->autoVacuumRatio = 0;
+		this->indexType = indexType;
 
 		for (const string& name : colNames)
 			tableHeader += name + ",";
@@ -69,33 +82,72 @@ public:
 	 * @brief Reading constructor
 	 * @param in
 	*/
-	Table(ifstream& in)
+	Table(BinaryReader& in)
 	{
-		in.read((char*)&bytes, sizeof(bytes));
-		in.read((char*)&maxRecordsPerPage, sizeof(maxRecordsPerPage));
-		in.read((char*)&curPageIndex, sizeof(curPageIndex));
-
-		fh::readString(in, path);
-		fh::readString(in, tableName);
-		fh::readString(in, primaryKey);
-		fh::readString(in, tableHeader);
+		in.read(bytes);
+		in.read(maxRecordsPerPage);
+		in.read(curPageIndex);
+		in.read(deadVersions);
+		in.read(liveRecords);
+		in.read(usedSlots);
+		in.read(autoVacuumRatio);
+
+		in.readString(path);
+		in.readString(tableName);
+		in.readString(primaryKey);
+		in.readString(tableHeader);
 
 		size_t colTypesSize = 0;
-		in.read((char*)&colTypesSize, sizeof(colTypesSize));
+		in.read(colTypesSize);
 		for (size_t i = 0; i < colTypesSize; i++)
 		{
 			string first, second;
-			fh::readString(in, first);
-			fh::readString(in, second);
+			in.readString(first);
+			in.readString(second);
 			colTypes.insert({ first, second });
 		}
 
+		freeSpace = FreeSpaceMap(in);
+
 		if (!primaryKey.empty())
 			indexedColumnRecords = BPTree(in);
 
+		// Tables saved before the zone maps end here, their zones are built from the pages
+		bool hasZoneMap = !in.eof();
+		if (hasZoneMap)
+			zones = ZoneMap(in);
+
+		// So do the tables saved before the Bloom filters, they have none
+		if (!in.eof())
+		{
+			size_t bloomColumnsSize = 0;
+			in.read(bloomColumnsSize);
+			bloomColumns.resize(bloomColumnsSize);
+			for (string& colName : bloomColumns)
+				in.readString(colName);
+		}
+
+		// ...and the tables saved before the hash indexes, their primary key is in the B+ tree
+		indexType = IndexType::BPTREE;
+		if (!in.eof())
+		{
+			in.read(indexType);
+			if (indexType == IndexType::HASH)
+				hashedColumnRecords = HashIndex(in);
+		}
+
+		// ...and the tables saved before the page files, their pages are files of their own
+		if (!in.eof())
+			in.read(singleFile);
+		if (singleFile)
+			BufferPool::getInstance().mount(path, std::make_shared<PageFile>(getPageFilePath()));
+
 		vector<string> header = sh::splitBy(tableHeader, ",");
 		sh::removeEmptyStringsInVector(header);
 		initializeColumnsIndexes(header);
+
+		if (!hasZoneMap)
+			buildZoneMap();
 	}
 
 	/**
@@ -103,40 +155,68 @@ public:
 	 */
 	void saveTable()
 	{
-		ofstream out(path + tableName + ".bin", std::ios::binary);
-		if (!out.is_open())
-			throw exception("Couldn't open file to save the table");
+		// In a batch the metadata and the index are written once, when the batch ends
+		if (savesDeferred)
+		{
+			hasUnsavedChanges = true;
+			return;
+		}
 
-		out.write((char*)&bytes, sizeof(bytes));
-		out.write((char*)&maxRecordsPerPage, sizeof(maxRecordsPerPage));
-		out.write((char*)&curPageIndex, sizeof(curPageIndex));
+		BinaryWriter out;
+		out.write(bytes);
+		out.write(maxRecordsPerPage);
+		out.write(curPageIndex);
+		out.write(deadVersions);
+		out.write(liveRecords);
+		out.write(usedSlots);
+		out.write(autoVacuumRatio);
 
-		fh::writeString(out, path);
-		fh::writeString(out, tableName);
-		fh::writeString(out, primaryKey);
-		fh::writeString(out, tableHeader);
+		out.writeString(path);
+		out.writeString(tableName);
+		out.writeString(primaryKey);
+		out.writeString(tableHeader);
 
 		size_t colTypesSize = colTypes.size();
-		out.write((char*)&colTypesSize, sizeof(colTypesSize));
+		out.write(colTypesSize);
 		for (pair<string, string> entry : colTypes)
 		{
-			fh::writeString(out, entry.first);
-			fh::writeString(out, entry.second);
+			out.writeString(entry.first);
+			out.writeString(entry.second);
 		}
 
+		freeSpace.write(out);
+
 		if (!primaryKey.empty())
 			indexedColumnRecords.write(out);
 
-		out.close();
+		zones.write(out);
+
+		size_t bloomColumnsSize = bloomColumns.size();
+		out.write(bloomColumnsSize);
+		for (const string& colName : bloomColumns)
+			out.writeString(colName);
+
+		out.write(indexType);
+		if (indexType == IndexType::HASH)
+			hashedColumnRecords.write(out);
+
+		out.write(singleFile);
+
+		if (!out.save(path + tableName + ".bin"))
+			throw exception("Couldn't open file to save the table");
 	}
 
 	/**
-	 *	@brief Map every table column to an index
+	 *	@brief Map every table column to an index and remember the column types in that order, the pages are encoded with them
 	 */
 	void initializeColumnsIndexes(vector<string>& colNames) {
 		int index = 0;
+		columnTypes.clear();
 		for (const string& colName : colNames)
+		{
 			colIndex.insert({ colName, index++ });
+			columnTypes.push_back(toObjectType(colTypes.at(colName)));
+		}
 
 		numOfColumns = colNames.size();
 	}
@@ -162,20 +242,16 @@ public:
 		int colPos = colIndex.at(strColName);
 
 		for (int index = 0; index <= curPageIndex; index++) {
-			ifstream in(path + tableName + "_" + to_string(index) + ".bin", std::ios::binary);
-
-			Page p(in);
+			Page p = loadPage(index);
 			for (int i = 0; i < p.size(); ++i)
 			{
-				Record r = p.get(i);
-				if (r.isInvalid())
+				const Record& r = p.get(i);
+				if (r.isInvalid() || r.isDeleted())
 					continue;
 
 				RecordPtr recordReference(index, i);
-				indexedColumnRecords.insert({ r.get(colPos), recordReference });
+				indexInsert(r.get(colPos), recordReference);
 			}
-
-			in.close();
 		}
 
 		saveTable();
@@ -188,7 +264,12 @@ public:
 	Page createPage()
 	{
 		curPageIndex++;
-		Page p(maxRecordsPerPage, path + tableName + "_" + std::to_string(curPageIndex) + ".bin");
+		Page p(maxRecordsPerPage, getPagePath(curPageIndex), columnTypes);
+		freeSpace.addPage(maxRecordsPerPage);
+		zones.addPage(numOfColumns);
+		if (!bloomColumns.empty())
+			saveBlooms(curPageIndex, newBlooms());
+
 		saveTable();
 		return p;
 	}
@@ -202,81 +283,141 @@ public:
 	bool checkType(const TypeWrapper& value, const string& type) {
 
 		if (type == "Integer")
-			if (typeid(*value.getContent()) != typeid(IntegerObject))
+			if (value.getType() != ObjectType::INT)
 				return false;
 		if (type == "String")
-			if (typeid(*value.getContent()) != typeid(StringObject))
+			if (value.getType() != ObjectType::STRING)
 				return false;
 		if (type == "Double")
-			if (typeid(*value.getContent()) != typeid(DoubleObject))
+			if (value.getType() != ObjectType::DOUBLE)
 				return false;
 
 		return true;
 	}
 
 	/**
-	 * @brief Insert record in table with specified column values.
-	 * @param htblColNameValue
+	 * @brief Insert records in table with specified column values. All of them are checked before the first one is added,
+	 * so a statement with a bad row inserts nothing.
+	 * @param rows - the column values of every record
+	 * @param txn - the transaction inserting the records, the records it added are reclaimed if it is aborted
 	 */
-	void insert(unordered_map<string, TypeWrapper>& colNameValue)
+	void insert(const vector<unordered_map<string, TypeWrapper>>& rows, Transaction& txn)
 	{
-		checkColumns(colNameValue);
+		for (const unordered_map<string, TypeWrapper>& colNameValue : rows)
+			checkColumns(colNameValue);
 
-		if (!primaryKey.empty()) {
-			TypeWrapper primaryValue = colNameValue.at(primaryKey);
-			if (primaryValue.getContent() == nullptr)
-				throw invalid_argument("Primary key is not allowed to be empty");
+		if (!primaryKey.empty())
+			checkPrimaryKeys(rows);
 
-			if (checkRecordExists(primaryKey, primaryValue))
-				throw invalid_argument("Primary key " + primaryKey + " is already used before");
-		}
+		// Undone last, after the records
+		txn.onAbort([this]() { saveTable(); });
 
-		Record r(numOfColumns);
 		vector<string> header = sh::splitBy(tableHeader, ",");
 		sh::removeEmptyStringsInVector(header);
-		for (const string& entry : header)
-			r.addValue(colNameValue[entry]);
+		for (const unordered_map<string, TypeWrapper>& colNameValue : rows)
+		{
+			Record r(numOfColumns);
+			r.setCreatedTxn(txn.getId());
+			for (const string& entry : header)
+			{
+				auto it = colNameValue.find(entry);
+				r.addValue(it != colNameValue.end() ? it->second : TypeWrapper());
+			}
 
-		Page page = addRecord(r);
+			RecordPtr placedAt = addRecord(r);
 
-		if (!primaryKey.empty())
-			indexedColumnRecords.insert({ colNameValue.at(primaryKey), RecordPtr(curPageIndex, page.size() - 1) });
+			if (!primaryKey.empty())
+				indexInsertVersion(colNameValue.at(primaryKey), placedAt);
+
+			liveRecords++;
+			txn.onAbort([this, placedAt]() { undoInsert(placedAt); });
+
+			notifyChange(r, 1);
+		}
 
 		saveTable();
 	}
 
 	/**
-	 *	@brief Add a new record to the table
+	 * @brief Check that the primary keys of the records to be inserted are set, are not used in the table
+	 * and are not repeated among the records themselves. The table is probed through its index, a page is read only
+	 * for a key that is in the index, to tell whether its record is deleted.
+	 * @param rows - the column values of every record
+	 */
+	void checkPrimaryKeys(const vector<unordered_map<string, TypeWrapper>>& rows) const
+	{
+		vector<TypeWrapper> keys;
+		keys.reserve(rows.size());
+		for (const unordered_map<string, TypeWrapper>& colNameValue : rows)
+		{
+			const TypeWrapper& primaryValue = colNameValue.at(primaryKey);
+			if (primaryValue.isEmpty())
+				throw invalid_argument("Primary key is not allowed to be empty");
+
+			if (isKeyUsed(primaryValue))
+				throw invalid_argument("Primary key " + primaryKey + " is already used before");
+
+			keys.push_back(primaryValue);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		for (size_t i = 1; i < keys.size(); i++)
+			if (keys[i] == keys[i - 1])
+				throw invalid_argument("Primary key " + primaryKey + " " + keys[i].toString() + " is repeated in the inserted records");
+	}
+
+	/**
+	 *	@brief Add a new record to the table. The free space map gives a page with a free slot,
+	 *	a new page is created only when all of them are full
 	 *	@param record - the record to be added
+	 *	@return where the record was placed
 	 */
-	Page addRecord(Record& record)
+	RecordPtr addRecord(Record& record)
 	{
-		string pagePath = path + tableName + "_" + std::to_string(curPageIndex) + ".bin";
-		ifstream in(pagePath, std::ios::binary);
-		if (!in.is_open())
-			throw std::invalid_argument("Couldnt open page at path " + pagePath + " for reading.");
+		int pageIndex = freeSpace.findPageWithRoom();
+		if (pageIndex == -1)
+		{
+			createPage();
+			pageIndex = curPageIndex;
+		}
+
+		Page p = loadPage(pageIndex);
+
+		size_t sizeBefore = p.size();
+		int slot = p.addRecord(record);
+		if (slot == -1)
+			throw logic_error("Free space map of table " + tableName + " is out of sync with page " + to_string(pageIndex));
 
-		Page p(in);
-		if (p.isFull())
-			p = createPage();
+		freeSpace.use(pageIndex);
+		zones.addRecord(pageIndex, record, p.size() == sizeBefore);
+		if (!bloomColumns.empty())
+		{
+			vector<BloomFilter> blooms = loadBlooms(pageIndex);
+			for (size_t i = 0; i < bloomColumns.size(); i++)
+				if (!record.get(colIndex.at(bloomColumns[i])).isEmpty())
+					blooms[i].add(record.get(colIndex.at(bloomColumns[i])));
+
+			saveBlooms(pageIndex, blooms);
+		}
 
-		p.addRecord(record);
 		bytes += record.getKiloBytesData();
+		if (p.size() > sizeBefore)
+			usedSlots++;
 
-		in.close();
-		return p;
+		return RecordPtr(pageIndex, slot);
 	}
 
 	/**
 	 *	@brief Check if there is a record with the specified column value in the table
 	 *	@param colName the column to be looked for when searching
 	 *	@param colValue the value to be matched
+	 *	@param snapshot the read view of the inserting transaction
 	 *	@return whether the record exists or not
 	 */
-	bool checkRecordExists(const string& colName, const TypeWrapper& colValue)
+	bool checkRecordExists(const string& colName, const TypeWrapper& colValue, const Snapshot& snapshot)
 	{
 		Query exp(colName + " = " + colValue.toString(), colTypes, primaryKey);
-		vector<Record> answer = select(exp);
+		vector<Record> answer = select(exp, snapshot);
 		if (!answer.empty())
 			return true;
 
@@ -290,6 +431,15 @@ public:
 	 * @return Vector of distinct-ized records
 	*/
 	vector<Record> distinct(vector<Record>& target, vector<string>& selectedColumns)
+	{
+		return distinct(target, selectedColumns, colIndex);
+	}
+
+	/**
+	 * @brief Same as above, for records whose columns are not the ones of a table (i.e. joined records)
+	 * @param colIndex - hashtable of column names and their corresponding indices in the records
+	*/
+	static vector<Record> distinct(vector<Record>& target, vector<string>& selectedColumns, const unordered_map<string, size_t>& colIndex)
 	{
 		for (const string& col : selectedColumns)
 			if (colIndex.find(col) == colIndex.end())
@@ -305,7 +455,7 @@ public:
 
 				bool areColsEqual = true;
 				for (size_t k = 0; k < selectedColumns.size(); k++)
-					if (target[i].get(colIndex[selectedColumns[k]]) != target[j].get(colIndex[selectedColumns[k]]))
+					if (target[i].get(colIndex.at(selectedColumns[k])) != target[j].get(colIndex.at(selectedColumns[k])))
 						areColsEqual = false;
 
 				if (areColsEqual)
@@ -338,53 +488,64 @@ public:
 	/**
 	 * @brief Selects records satisfying the WHERE criteria
 	 * @param colValueOperator - "ID > 5" col refers to "ID", Value refers to "5", operator refers to ">"
+	 * @param snapshot - only the versions of the records visible to it are selected
 	 * @return vector with filtered records
 	*/
-	vector<Record> select(Query& query)
+	vector<Record> select(Query& query, const Snapshot& snapshot)
 	{
 		stack<vector<Record>> result;
 		queue<string> output = query.getShuntingOutput();
 
+		// A page that cannot hold a record satisfying the whole query adds nothing to the result, whichever condition is checked on it
+		vector<Query::Step> steps = query.resolve(colIndex);
+		vector<bool> candidatePages(curPageIndex + 1);
+		for (int index = 0; index <= curPageIndex; index++)
+			candidatePages[index] = query.checkZoneAgainstQuery(zones, index, steps);
+
 		while (!output.empty())
 		{
 			if (sh::isStringInteger(output.front()))
 			{
 				InternalQuery curr = query.getNumberedQueries().at(output.front());
-				if (curr.isPrimaryKeyQuery())
+				if (canUseIndex(curr))
 				{
-					vector<RecordPtr> fromTree = indexedColumnRecords.getRecordsFromQuery(curr);
-					if (!fromTree.empty())
-						result.push(fetchRecordsByReference(fromTree));
+					vector<RecordPtr> fromIndex = getRecordsFromIndex(curr);
+					if (!fromIndex.empty())
+						result.push(fetchRecordsByReference(fromIndex, snapshot));
 					else
 						result.push(vector<Record>());
 				}
 				else
 				{
-					vector<Record> answer;
-					for (size_t index = 0; index <= curPageIndex; index++) {
-						ifstream in(path + tableName + "_" + to_string(index) + ".bin", std::ios::binary);
+					size_t column = curr.columnIn(colIndex);
+					vector<int> pages;
+					for (int index = 0; index <= curPageIndex; index++)
+						if (candidatePages[index] && curr.checkZone(zones, index, column) && checkBloomAgainstCondition(curr, index))
+							pages.push_back(index);
 
-						Page p(in);
+					vector<Record> answer;
+					for (size_t position = 0; position < pages.size(); position++) {
+						readAhead(pages, position);
+						Page p = loadPage(pages[position]);
 						for (size_t i = 0; i < p.size(); ++i)
 						{
-							Record r = p.get(i);
-							if (!r.isInvalid())
-								if (curr.checkRecordAgainstCondition(colIndex, r))
+							const Record& r = p.get(i);
+							if (r.isVisibleTo(snapshot))
+								if (curr.checkValue(r.get(column)))
 									answer.push_back(r);
 						}
-						in.close();
 					}
-					result.push(answer);
+					result.push(std::move(answer));
 				}
 
 				output.pop();
 			}
 			else
 			{
-				vector<Record> val2 = result.top();
+				vector<Record> val2 = std::move(result.top());
 				result.pop();
 
-				vector<Record> val1 = result.top();
+				vector<Record> val1 = std::move(result.top());
 				result.pop();
 
 				string op = output.front();
@@ -401,7 +562,7 @@ public:
 						if (std::find(val1.begin(), val1.end(), val2[i]) != val1.end())
 							vec_intersection.push_back(val2[i]);
 
-					result.push(vec_intersection);
+					result.push(std::move(vec_intersection));
 				}
 				// Union (OR)
 				else
@@ -416,17 +577,18 @@ public:
 						if (std::find(vec_union.begin(), vec_union.end(), r) == vec_union.end())
 							vec_union.push_back(r);
 
-					result.push(vec_union);
+					result.push(std::move(vec_union));
 				}
 			}
 		}
 
-		return result.top();
+		return std::move(result.top());
 	}
 
 	/**
 	 * @brief Acts just like select with given query, but can also pass arguments wheter to sort it by
-	 * given column or/and to get only the distinct elements
+	 * given column or/and to get only the distinct elements. The query reads from a snapshot taken when it starts,
+	 * so writes committed while it runs are not seen by it.
 	 * @param query - WHERE clause
 	 * @param orderByWhat - by which column shall the sorting be done
 	 * @param isDistinct - if True then the answer shall not contain any duplicates of the selected columns
@@ -435,24 +597,28 @@ public:
 	*/
 	vector<Record> select(Query& query, const string& orderByWhat, bool isDistinct, vector<string>& selectedCols)
 	{
+		SnapshotGuard snapshot;
 		vector<Record> answer;
 		if (!query.getShuntingOutput().empty())
 		{
-			answer = select(query);
+			answer = select(query, snapshot.get());
 		}
 		else
 		{
-			for (size_t index = 0; index <= curPageIndex; index++) {
-				ifstream in(path + tableName + "_" + to_string(index) + ".bin", std::ios::binary);
-
-				Page p(in);
+			vector<int> pages;
+			for (int index = 0; index <= curPageIndex; index++)
+				if (zones.hasRecords(index))
+					pages.push_back(index);
+
+			for (size_t position = 0; position < pages.size(); position++) {
+				readAhead(pages, position);
+				Page p = loadPage(pages[position]);
 				for (size_t i = 0; i < p.size(); ++i)
 				{
-					Record r = p.get(i);
-					if (!r.isInvalid())
+					const Record& r = p.get(i);
+					if (r.isVisibleTo(snapshot.get()))
 						answer.push_back(r);
 				}
-				in.close();
 			}
 		}
 
@@ -464,26 +630,207 @@ public:
 		return answer;
 	}
 
+	/**
+	 * @brief Calls visit with every record visible to the snapshot that may satisfy the query. Only the conditions on the
+	 * columns in queryColIndex are checked, so each table of a join is filtered by its own conditions before joining.
+	 * The pages whose zones rule the query out are not read.
+	 * @param queryColIndex - the names the query uses for the columns of this table and their indices
+	 * @param visit - called with each record, the record lives until the next page is loaded
+	*/
+	template<typename Visit>
+	void scan(const Query& query, const unordered_map<string, size_t>& queryColIndex, const Snapshot& snapshot, Visit visit) const
+	{
+		scanPages(0, curPageIndex + 1, query, queryColIndex, snapshot, visit);
+	}
+
+	/**
+	 * @brief Same as scan, over the pages with indices in [firstPage, endPage) only. Reading pages is thread safe,
+	 * so a scan can be split between threads by page ranges.
+	*/
+	template<typename Visit>
+	void scanPages(int firstPage, int endPage, const Query& query, const unordered_map<string, size_t>& queryColIndex,
+		const Snapshot& snapshot, Visit visit) const
+	{
+		vector<Query::Step> steps = query.resolve(queryColIndex);
+		vector<int> pages;
+		for (int index = firstPage; index < endPage; index++)
+			if (query.mayZoneSatisfyQuery(zones, index, steps))
+				pages.push_back(index);
+
+		for (size_t position = 0; position < pages.size(); position++)
+		{
+			readAhead(pages, position);
+			Page p = loadPage(pages[position]);
+			for (size_t i = 0; i < p.size(); ++i)
+			{
+				const Record& r = p.get(i);
+				if (r.isVisibleTo(snapshot) && query.mayRecordSatisfyQuery(r, steps))
+					visit(r);
+			}
+		}
+	}
+
+	/**
+	 * @brief Calls visit(i, record) for every reference whose record is visible to the snapshot. The references are
+	 * visited in the order of their pages, so every page is read once.
+	 * @param recordsReferences - pointers to records, in any order
+	 * @param visit - called with the position of the reference in recordsReferences and the record it points to
+	*/
+	template<typename Visit>
+	void fetchByReference(const vector<RecordPtr>& recordsReferences, const Snapshot& snapshot, Visit visit) const
+	{
+		vector<size_t> order(recordsReferences.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return recordsReferences[a] < recordsReferences[b]; });
+
+		for (size_t i = 0; i < order.size();)
+		{
+			int pageIndex = recordsReferences[order[i]].getPage();
+			Page p = loadPage(pageIndex);
+			for (; i < order.size() && recordsReferences[order[i]].getPage() == pageIndex; i++)
+			{
+				const Record& r = p.get(recordsReferences[order[i]].getIndexInPage());
+				if (r.isVisibleTo(snapshot))
+					visit(order[i], r);
+			}
+		}
+	}
+
+	/**
+	 * @brief Probe the index of the primary key, without touching the pages
+	 * @return the pointer to the newest version of the record with the given key, nullptr if there is none or the table has no primary key
+	*/
+	const RecordPtr* findByPrimaryKey(const TypeWrapper& key) const
+	{
+		if (primaryKey.empty())
+			return nullptr;
+		if (indexType == IndexType::HASH)
+			return hashedColumnRecords.find(key);
+
+		Node* leaf = indexedColumnRecords.search(key);
+		return leaf ? &leaf->fKeys[leaf->keyIndex(key)].second : nullptr;
+	}
+
+	/**
+	 * @brief Calls visit with the pointer to every version of the record with the given key that a snapshot may see:
+	 * the newest one in the index and the deleted ones kept for older snapshots
+	*/
+	template<typename Visit>
+	void forEachVersion(const TypeWrapper& key, Visit visit) const
+	{
+		const RecordPtr* newest = findByPrimaryKey(key);
+		if (!newest)
+			return;
+
+		visit(*newest);
+		auto range = std::equal_range(olderVersions.begin(), olderVersions.end(), data{ key, RecordPtr() },
+			[](const data& a, const data& b) { return a.first < b.first; });
+		for (auto it = range.first; it != range.second; ++it)
+			visit(it->second);
+	}
+
+	/**
+	 * @brief Count the records satisfying a query and find their smallest and largest primary keys from the B+ tree alone,
+	 * without reading any page. The query must be empty or bound the primary key only (see Query::isPrimaryKeyRange).
+	 * The index keeps the keys of the deleted versions until the vacuum reclaims them, so it answers only for a snapshot
+	 * that sees the latest state of a table without deleted versions.
+	 * @param count - set to the number of records in the range
+	 * @param minKey - set to the smallest key in the range, empty if there is none
+	 * @param maxKey - set to the largest key in the range, empty if there is none
+	 * @return False if the index can't answer the query, nothing is set then
+	*/
+	bool summarizeByIndex(const Query& query, const Snapshot& snapshot, size_t& count, TypeWrapper& minKey, TypeWrapper& maxKey) const
+	{
+		if (primaryKey.empty() || indexType != IndexType::BPTREE || !snapshot.isLatest() || deadVersions != 0 || !query.isPrimaryKeyRange())
+			return false;
+
+		ObjectType keyType = columnTypes[colIndex.at(primaryKey)];
+		const TypeWrapper* low = nullptr, * high = nullptr;
+		bool lowInclusive = true, highInclusive = true;
+		for (const InternalQuery& condition : query.getPrimaryKeyQueries())
+		{
+			// Values of another type compare as neither smaller nor larger than the keys, the scan handles them
+			const TypeWrapper& value = condition.getValue();
+			if (value.getType() != keyType)
+				return false;
+
+			Operator op = condition.getOperator();
+			if (op == Operator::EQUAL || op == Operator::GREATER_THAN || op == Operator::GREATER_THAN_OR_EQUAL)
+			{
+				bool inclusive = op != Operator::GREATER_THAN;
+				if (!low || *low < value || (*low == value && !inclusive))
+				{
+					low = &value;
+					lowInclusive = inclusive;
+				}
+			}
+			if (op == Operator::EQUAL || op == Operator::LESS_THAN || op == Operator::LESS_THAN_OR_EQUAL)
+			{
+				bool inclusive = op != Operator::LESS_THAN;
+				if (!high || value < *high || (*high == value && !inclusive))
+				{
+					high = &value;
+					highInclusive = inclusive;
+				}
+			}
+		}
+
+		const data* first, * last;
+		count = indexedColumnRecords.summarizeRange(low, lowInclusive, high, highInclusive, first, last);
+		minKey = first ? first->first : TypeWrapper();
+		maxKey = last ? last->first : TypeWrapper();
+		return true;
+	}
+
+	/**
+	 * @return the keys of the primary key index with the pointers to their records, in ascending order of the keys.
+	 * A key is repeated for each of its deleted versions that a snapshot may still see.
+	*/
+	vector<const data*> getPrimaryKeysInOrder() const
+	{
+		if (primaryKey.empty() || indexType != IndexType::BPTREE)
+			throw logic_error("Table " + tableName + " has no B+ tree index to read its keys in order");
+
+		vector<const data*> newest = indexedColumnRecords.getSortedElements();
+		if (olderVersions.empty())
+			return newest;
+
+		vector<const data*> keys;
+		keys.reserve(newest.size() + olderVersions.size());
+		size_t i = 0;
+		for (const data* element : newest)
+		{
+			for (; i < olderVersions.size() && olderVersions[i].first < element->first; i++)
+				keys.push_back(&olderVersions[i]);
+
+			keys.push_back(element);
+		}
+
+		for (; i < olderVersions.size(); i++)
+			keys.push_back(&olderVersions[i]);
+
+		return keys;
+	}
+
 	/**
 	 * @param recordReference - a tuple holding info about the index of the page that contains the record, and the record's id in the page
 	 * @return record in the specified reference.
 	 */
 	Record fetchRecordByReference(RecordPtr& recordReference)
 	{
-		string readPath = path + tableName + "_" + to_string(recordReference.getPage()) + ".bin";
-		ifstream in(readPath, std::ios::binary);
-		Page p(in);
-		Record r = p.get(recordReference.getIndexInPage());
-		in.close();
+		Page p = loadPage(recordReference.getPage());
+		const Record& r = p.get(recordReference.getIndexInPage());
 		return r;
 	}
 
 	/**
 	 * @brief Given vector of pointers to records, fetch them all
 	 * @param recordsReferences - vector of record pointers
+	 * @param snapshot - the records not visible to it are skipped
 	 * @return the records pointed to by record pointers
 	*/
-	vector<Record> fetchRecordsByReference(vector<RecordPtr>& recordsReferences)
+	vector<Record> fetchRecordsByReference(vector<RecordPtr>& recordsReferences, const Snapshot& snapshot)
 	{
 		vector<Record> res;
 
@@ -503,32 +850,19 @@ public:
 		// having to reopen on every iteration for every record
 		for (size_t i = 0; i < recordsReferences.size(); i++)
 		{
-			string readPath = path + tableName + "_" + to_string(recordsReferences[i].getPage()) + ".bin";
-			ifstream in(readPath, std::ios::binary);
-			Page p(in);
-			Record r = p.get(recordsReferences[i].getIndexInPage());
+			Page p = loadPage(recordsReferences[i].getPage());
 
-			if (i < recordsReferences.size() - 1 && recordsReferences[i].getPage() != recordsReferences[i + 1].getPage())
-			{
-				if (!p.get(recordsReferences[i].getIndexInPage()).isInvalid())
-					res.push_back(p.get(recordsReferences[i].getIndexInPage()));
-			}
-			else
+			while (true)
 			{
-				while (i < recordsReferences.size() - 1 && recordsReferences[i].getPage() == recordsReferences[i + 1].getPage())
-				{
-					if (!p.get(recordsReferences[i].getIndexInPage()).isInvalid())
-						res.push_back(p.get(recordsReferences[i].getIndexInPage()));
+				const Record& r = p.get(recordsReferences[i].getIndexInPage());
+				if (r.isVisibleTo(snapshot))
+					res.push_back(r);
 
-					i++;
-				}
-			}
-
-			if (i == recordsReferences.size() - 1)
-				if (!p.get(recordsReferences[i].getIndexInPage()).isInvalid())
-					res.push_back(p.get(recordsReferences[i].getIndexInPage()));
+				if (i == recordsReferences.size() - 1 || recordsReferences[i].getPage() != recordsReferences[i + 1].getPage())
+					break;
 
-			in.close();
+				i++;
+			}
 		}
 
 		return res;
@@ -537,46 +871,57 @@ public:
 	/**
 	 * @brief Deletes all the records satisfying the where criteria
 	 * @param query - query containing the where conditions
+	 * @param txn - the deleting transaction. The records stay in the pages and in the index as deleted versions until vacuumed,
+	 * so the snapshots taken before the delete still find them. They are alive again if it is aborted.
 	 * @return the number of deleted records in the table
 	*/
-	int deleteRecord(Query& query)
+	int deleteRecord(Query& query, Transaction& txn)
 	{
 		int deletedRecords = 0;
+		// Undone last, after the records
+		txn.onAbort([this]() { saveTable(); });
 		if (!query.getShuntingOutput().empty())
 		{
 			if (!primaryKey.empty())
 			{
-				vector<Record> answer = select(query);
+				vector<Record> answer = select(query, txn.getSnapshot());
 				for (size_t i = 0; i < answer.size(); i++)
 				{
-					Record r = answer[i];
-					if (r.isInvalid())
-						continue;
-					RecordPtr rPtr = indexedColumnRecords.getRecordAtIndex(r.get(colIndex[primaryKey]));
-					ifstream in(path + tableName + "_" + to_string(rPtr.getPage()) + ".bin", std::ios::binary);
-					Page p(in);
+					const Record& r = answer[i];
+					RecordPtr rPtr = indexFind(r.get(colIndex[primaryKey]));
+					Page p = loadPage(rPtr.getPage());
 					bytes -= r.getKiloBytesData();
-					p.removeRecord(rPtr.getIndexInPage());
-					deleteRecord(r);
+					p.removeRecord(rPtr.getIndexInPage(), txn.getId());
 					deletedRecords++;
-					in.close();
+					deadVersions++;
+					liveRecords--;
+					txn.onAbort([this, rPtr]() { undoDelete(rPtr); });
+					notifyChange(r, -1);
 				}
 			}
 			else
 			{
+				vector<Query::Step> steps = query.resolve(colIndex);
 				for (size_t index = 0; index <= curPageIndex; index++)
 				{
-					ifstream in(path + tableName + "_" + to_string(index) + ".bin", std::ios::binary);
-					Page page(in);
+					if (!query.checkZoneAgainstQuery(zones, index, steps))
+						continue;
+
+					Page page = loadPage(index);
 					for (size_t i = 0; i < page.size(); i++)
 					{
-						Record r = page.get(i);
+						const Record& r = page.get(i);
 
-						if (!r.isInvalid() && query.checkRecordAgainstQuery(r, colIndex))
+						if (r.isVisibleTo(txn.getSnapshot()) && query.checkRecordAgainstQuery(r, steps))
 						{
 							bytes -= r.getKiloBytesData();
-							page.removeRecord(i);
+							notifyChange(r, -1);
+							page.removeRecord(i, txn.getId());
 							deletedRecords++;
+							deadVersions++;
+							liveRecords--;
+							RecordPtr rPtr(index, i);
+							txn.onAbort([this, rPtr]() { undoDelete(rPtr); });
 						}
 					}
 				}
@@ -588,23 +933,298 @@ public:
 	}
 
 	/**
-	 * @brief Deletes the given record from the BPTree if the table has primary key
-	 * @param record - record that is to be deleted from the tree
+	 * @brief Reclaim the deleted versions of records that no alive snapshot can see anymore, together with their index entries
+	 * @param horizon - the oldest transaction id that is still needed by someone
+	 * @return the number of reclaimed versions
 	*/
-	void deleteRecord(Record& record)
+	size_t vacuum(size_t horizon)
 	{
-		if (!primaryKey.empty())
+		if (deadVersions == 0)
+			return 0;
+
+		size_t reclaimed = 0;
+		int pkCol = primaryKey.empty() ? -1 : colIndex.at(primaryKey);
+		for (int index = 0; index <= curPageIndex; index++)
+		{
+			Page p = loadPage(index);
+			if (pkCol != -1)
+				for (size_t i = 0; i < p.size(); i++)
+					if (p.get(i).isReclaimable(horizon))
+						indexRemoveVersion(p.get(i).get(pkCol), RecordPtr(index, i));
+
+			size_t reclaimedInPage = p.vacuum(horizon);
+			freeSpace.release(index, reclaimedInPage);
+			zones.addTombstones(index, reclaimedInPage);
+			reclaimed += reclaimedInPage;
+		}
+
+		deadVersions = reclaimed > deadVersions ? 0 : deadVersions - reclaimed;
+		if (reclaimed > 0)
+			saveTable();
+
+		return reclaimed;
+	}
+
+	/**
+	 * @brief Rewrite the pages of the table densely. Tombstones and the deleted versions that no alive snapshot
+	 * can see are dropped, the surviving records are packed from the first page onwards and the emptied pages are removed.
+	 * Since the records move, the index is rebuilt with the new record pointers.
+	 * @param horizon - the oldest transaction id that is still needed by someone
+	 * @return the number of slots that were freed
+	*/
+	size_t compact(size_t horizon)
+	{
+		size_t slotsBefore = usedSlots;
+		vector<Record> pending;
+		int writeIndex = 0;
+		int pkCol = primaryKey.empty() ? -1 : colIndex.at(primaryKey);
+
+		deadVersions = 0;
+		usedSlots = 0;
+		freeSpace.clear();
+		zones.clear();
+		// The records move, so the index is filled again as the pages are written
+		clearIndex();
+		olderVersions.clear();
+
+		// Every written page holds only records from pages that are already read, so writeIndex never overtakes index
+		for (int index = 0; index <= curPageIndex; index++)
+		{
+			Page p = loadPage(index);
+
+			for (size_t i = 0; i < p.size(); i++)
+			{
+				const Record& r = p.get(i);
+				if (r.isInvalid() || r.isReclaimable(horizon))
+					continue;
+
+				pending.push_back(r);
+				if (pending.size() == maxRecordsPerPage)
+					writeCompactedPage(pending, writeIndex++, pkCol);
+			}
+		}
+
+		if (!pending.empty() || writeIndex == 0)
+			writeCompactedPage(pending, writeIndex++, pkCol);
+
+		// A deleted version whose key has no live one takes its place in the index
+		std::stable_sort(olderVersions.begin(), olderVersions.end(), [](const data& a, const data& b) { return a.first < b.first; });
+		for (size_t i = 0; i < olderVersions.size();)
+		{
+			if (indexContains(olderVersions[i].first))
+			{
+				i++;
+				continue;
+			}
+
+			indexInsert(olderVersions[i].first, olderVersions[i].second);
+			olderVersions.erase(olderVersions.begin() + i);
+		}
+
+		for (int index = writeIndex; index <= curPageIndex; index++)
+		{
+			BufferPool::getInstance().remove(getPagePath(index));
+			BufferPool::getInstance().remove(getBloomPath(index));
+		}
+
+		curPageIndex = writeIndex - 1;
+
+		saveTable();
+		return slotsBefore - usedSlots;
+	}
+
+	/**
+	 * @brief Check the file of a page against its checksum
+	*/
+	BufferPool::FileState verifyPage(int index) const
+	{
+		return BufferPool::getInstance().verify(getPagePath(index));
+	}
+
+	/**
+	 * @brief Check the Bloom filters of a page against their checksum. INTACT if the table has none
+	*/
+	BufferPool::FileState verifyBlooms(int index) const
+	{
+		if (bloomColumns.empty())
+			return BufferPool::FileState::INTACT;
+
+		return BufferPool::getInstance().verify(getBloomPath(index));
+	}
+
+	/**
+	 * @brief Repair the files found damaged by a recovery check. The Bloom filters are built again from their pages.
+	 * The records of a damaged page are lost: the page is emptied and the table compacted, so the index, the zones
+	 * and the counters describe only the records that are left.
+	 * @param damagedPages - indices of the pages whose files are damaged
+	 * @param damagedBlooms - indices of the pages whose Bloom filters are damaged
+	 * @param horizon - the oldest transaction id that is still needed by someone
+	*/
+	void repair(const vector<int>& damagedPages, const vector<int>& damagedBlooms, size_t horizon)
+	{
+		for (int index : damagedPages)
+		{
+			// Writes an empty page over the damaged file
+			Page empty(maxRecordsPerPage, getPagePath(index), columnTypes);
+		}
+
+		if (!damagedPages.empty())
+		{
+			// Compaction builds the Bloom filters of every page it writes
+			compact(horizon);
+			liveRecords = usedSlots - deadVersions;
+			saveTable();
+			return;
+		}
+
+		for (int index : damagedBlooms)
+		{
+			Page p = loadPage(index);
+			buildBlooms(index, p);
+		}
+	}
+
+	/**
+	 * @brief Turn on or off the Bloom filters of a column. With them an equality condition on the column reads only
+	 * the pages that may hold the value. The filters of every page are built again, or removed when no column needs them.
+	 * @param colName - name of the column
+	 * @param enabled - True to turn the filters on
+	*/
+	void setBloomFilter(const string& colName, bool enabled)
+	{
+		if (colTypes.find(colName) == colTypes.end())
+			throw invalid_argument("Cannot put Bloom filter on non existing column");
+		if (colTypes.at(colName) == "Double")
+			throw invalid_argument("Bloom filters are supported only on Integer and String columns");
+
+		auto it = std::find(bloomColumns.begin(), bloomColumns.end(), colName);
+		if (enabled == (it != bloomColumns.end()))
+			return;
+
+		if (enabled)
+			bloomColumns.push_back(colName);
+		else
+			bloomColumns.erase(it);
+
+		for (int index = 0; index <= curPageIndex; index++)
+		{
+			if (bloomColumns.empty())
+			{
+				BufferPool::getInstance().remove(getBloomPath(index));
+				continue;
+			}
+
+			Page p = loadPage(index);
+			buildBlooms(index, p);
+		}
+
+		saveTable();
+	}
+
+	/**
+	 * @brief Move the pages and the Bloom filters of the table into one page file, or back into a file each.
+	 * In the page file a page is read with one positioned read instead of opening a file of its own.
+	 * @param enabled - True to keep the pages in one file
+	*/
+	void setSingleFile(bool enabled)
+	{
+		if (enabled == singleFile)
+			return;
+
+		// The images held back by a batch are written where the pages are now
+		BufferPool& pool = BufferPool::getInstance();
+		if (!pool.flush())
+			throw logic_error("Couldn't write the pages of table " + tableName);
+
+		vector<string> files;
+		for (int index = 0; index <= curPageIndex; index++)
+		{
+			files.push_back(getPagePath(index));
+			if (!bloomColumns.empty())
+				files.push_back(getBloomPath(index));
+		}
+
+		vector<char> content;
+		if (enabled)
+		{
+			fs::remove(getPageFilePath());
+			shared_ptr<PageFile> pageFile = std::make_shared<PageFile>(getPageFilePath());
+			for (const string& file : files)
+				if (!BinaryReader::readFile(file, content) || !pageFile->write(file.substr(path.size()), content))
+					throw logic_error("Couldn't move " + file + " into the page file");
+
+			pool.mount(path, pageFile);
+			if (!saveStorageMode(true))
+			{
+				pool.unmount(path);
+				pageFile.reset();
+				fs::remove(getPageFilePath());
+				throw logic_error("Couldn't save table " + tableName);
+			}
+
+			for (const string& file : files)
+				fs::remove(file);
+		}
+		else
 		{
-			int col = colIndex[primaryKey];
-			indexedColumnRecords.remove(record.get(col));
+			shared_ptr<PageFile> pageFile = pool.unmount(path);
+			for (const string& file : files)
+			{
+				std::ofstream out(file, std::ios::binary);
+				if (!pageFile->read(file.substr(path.size()), content) || !out.write(content.data(), content.size()))
+				{
+					pool.mount(path, pageFile);
+					throw logic_error("Couldn't move " + file + " out of the page file");
+				}
+			}
+
+			if (!saveStorageMode(false))
+			{
+				pool.mount(path, pageFile);
+				throw logic_error("Couldn't save table " + tableName);
+			}
+
+			pageFile.reset();
+			fs::remove(getPageFilePath());
 		}
 	}
 
+	/**
+	 * @return the part of the used slots in the pages that do not hold a live record (0 to 1)
+	*/
+	double getDeadRatio() const
+	{
+		if (usedSlots == 0)
+			return 0;
+
+		return 1.0 - (double)liveRecords / usedSlots;
+	}
+
+	/**
+	 * @brief Set the dead records ratio above which the table is compacted automatically. 0 disables it
+	*/
+	void setAutoVacuumRatio(double ratio)
+	{
+		if (ratio < 0 || ratio >= 1)
+			throw invalid_argument("The auto vacuum ratio must be in the range [0, 1)");
+
+		autoVacuumRatio = ratio;
+		saveTable();
+	}
+
+	/**
+	 * @return True if automatic compaction is turned on and the dead records ratio has gone above it
+	*/
+	bool needsCompaction() const
+	{
+		return autoVacuumRatio > 0 && getDeadRatio() > autoVacuumRatio;
+	}
+
 	/**
 	 *	@brief Check that all specified columns are in the table schema and matches the defined types
 	 *	@param htblColNameValue some columns to be checked against the table schema
 	 */
-	void checkColumns(std::unordered_map<string, TypeWrapper> colNameValue)
+	void checkColumns(const std::unordered_map<string, TypeWrapper>& colNameValue)
 	{
 		for (const pair<string, TypeWrapper>& entry : colNameValue)
 		{
@@ -621,6 +1241,13 @@ public:
 
 	const string& getTablePath() const { return path; }
 
+	/**
+	 * @return path to the page file that holds the pages when the table keeps them in one file
+	*/
+	string getPageFilePath() const { return path + tableName + ".pages"; }
+
+	const string& getTableName() const { return tableName; }
+
 	long getBytesData() const { return bytes; }
 
 	const unordered_map<string, string>& getTableScheme() const { return colTypes; }
@@ -631,15 +1258,453 @@ public:
 
 	size_t getColumnsCount() const { return numOfColumns; }
 
+	size_t getPagesCount() const { return curPageIndex + 1; }
+
+	size_t getRecordsCount() const { return liveRecords; }
+
+	double getAutoVacuumRatio() const { return autoVacuumRatio; }
+
+	/**
+	 * @brief Start or end a batch of statements. In a batch saveTable only marks the table as changed, so the statements
+	 * don't rewrite the metadata and the index one after another. Ending the batch saves the table if it changed.
+	 * @param deferred - True to start the batch, False to end it
+	*/
+	void setSavesDeferred(bool deferred)
+	{
+		savesDeferred = deferred;
+		if (!deferred && hasUnsavedChanges)
+		{
+			hasUnsavedChanges = false;
+			saveTable();
+		}
+	}
+
+	const vector<string>& getBloomColumns() const { return bloomColumns; }
+
+	IndexType getIndexType() const { return indexType; }
+
+	bool isSingleFile() const { return singleFile; }
+
+	/// Called with every record inserted into the table (with +1) and deleted from it (with -1)
+	using ChangeListener = std::function<void(const Record&, int)>;
+
+	/**
+	 * @brief Register a listener of the changes of the table, used to keep the views over it up to date.
+	 * The listeners are not saved with the table.
+	 * @param name - name of the listener, replaces the listener with the same name
+	*/
+	void addChangeListener(const string& name, ChangeListener listener) { changeListeners[name] = std::move(listener); }
+
+	void removeChangeListener(const string& name) { changeListeners.erase(name); }
+
+	bool hasChangeListeners() const { return !changeListeners.empty(); }
+
 private:
+	/**
+	 * @param type - column type as written in the schema (Integer/String/Double)
+	 * @return the type of the values stored in such column
+	*/
+	static ObjectType toObjectType(const string& type)
+	{
+		if (type == "Integer")
+			return ObjectType::INT;
+		if (type == "Double")
+			return ObjectType::DOUBLE;
+		if (type == "String")
+			return ObjectType::STRING;
+
+		return ObjectType::NONE;
+	}
+
+	/**
+	 * @brief Save the table with its new storage mode before the old storage is removed, so the metadata on the disk
+	 * never points at removed files. It is saved in a batch too.
+	 * @return False if the table couldn't be saved, the mode is then left as it was
+	*/
+	bool saveStorageMode(bool enabled)
+	{
+		bool deferred = savesDeferred;
+		bool saved = true;
+		singleFile = enabled;
+		savesDeferred = false;
+		try
+		{
+			saveTable();
+		}
+		catch (const std::exception&)
+		{
+			singleFile = !enabled;
+			saved = false;
+		}
+
+		savesDeferred = deferred;
+		return saved;
+	}
+
+	/**
+	 * @return path to the file of the page with the given index
+	*/
+	string getPagePath(int index) const
+	{
+		return path + tableName + "_" + to_string(index) + ".bin";
+	}
+
+	/// How many pages ahead of the one it filters a sequential scan has read
+	static constexpr size_t READ_AHEAD_PAGES = 8;
+
+	/**
+	 * @brief Have the buffer pool read the pages that a sequential scan needs next while the scan filters the current one.
+	 * The first page requests the next READ_AHEAD_PAGES, every other page the one that enters the window.
+	 * @param pages - indices of the pages the scan reads, in order
+	 * @param position - position in pages of the page read now
+	*/
+	void readAhead(const vector<int>& pages, size_t position) const
+	{
+		size_t first = position == 0 ? 1 : position + READ_AHEAD_PAGES;
+		for (size_t i = first; i <= position + READ_AHEAD_PAGES && i < pages.size(); i++)
+			BufferPool::getInstance().prefetch(getPagePath(pages[i]));
+	}
+
+	/**
+	 * @brief Read the page with the given index, from the buffer pool if it is there
+	*/
+	Page loadPage(int index) const
+	{
+		string pagePath = getPagePath(index);
+		BinaryReader in(BufferPool::getInstance().read(pagePath));
+		if (!in.isOpen())
+			throw std::invalid_argument("Couldnt open page at path " + pagePath + " for reading.");
+
+		return Page(in, columnTypes);
+	}
+
+	/**
+	 * @brief Add a key of the primary key column to the index of the table
+	*/
+	void indexInsert(const TypeWrapper& key, const RecordPtr& ptr)
+	{
+		if (indexType == IndexType::HASH)
+			hashedColumnRecords.insert(key, ptr);
+		else
+			indexedColumnRecords.insert({ key, ptr });
+	}
+
+	void indexRemove(const TypeWrapper& key)
+	{
+		if (indexType == IndexType::HASH)
+			hashedColumnRecords.remove(key);
+		else
+			indexedColumnRecords.remove(key);
+	}
+
+	bool indexContains(const TypeWrapper& key) const
+	{
+		return indexType == IndexType::HASH ? hashedColumnRecords.contains(key) : indexedColumnRecords.contains(key);
+	}
+
+	/**
+	 * @brief Index a new version of a key. A deleted version already in the index is moved to olderVersions,
+	 * the snapshots taken before its delete may still read it
+	*/
+	void indexInsertVersion(const TypeWrapper& key, const RecordPtr& ptr)
+	{
+		const RecordPtr* older = findByPrimaryKey(key);
+		if (older)
+		{
+			data version{ key, *older };
+			auto position = std::upper_bound(olderVersions.begin(), olderVersions.end(), version, [](const data& a, const data& b) { return a.first < b.first; });
+			olderVersions.insert(position, version);
+			indexRemove(key);
+		}
+
+		indexInsert(key, ptr);
+	}
+
+	/**
+	 * @brief Forget a version of a key reclaimed by the vacuum, in the index or in olderVersions
+	*/
+	void indexRemoveVersion(const TypeWrapper& key, const RecordPtr& ptr)
+	{
+		const RecordPtr* indexed = findByPrimaryKey(key);
+		if (indexed && *indexed == ptr)
+		{
+			indexRemove(key);
+			return;
+		}
+
+		auto it = std::find_if(olderVersions.begin(), olderVersions.end(), [&](const data& older) { return older.second == ptr; });
+		if (it != olderVersions.end())
+			olderVersions.erase(it);
+	}
+
+	/**
+	 * @return True if the key is in the index and its newest version is not deleted
+	*/
+	bool isKeyUsed(const TypeWrapper& key) const
+	{
+		const RecordPtr* ptr = findByPrimaryKey(key);
+		return ptr && !loadPage(ptr->getPage()).get(ptr->getIndexInPage()).isDeleted();
+	}
+
+	/**
+	 * @return where the record with the given primary key is
+	*/
+	RecordPtr indexFind(const TypeWrapper& key)
+	{
+		if (indexType == IndexType::BPTREE)
+			return indexedColumnRecords.getRecordAtIndex(key);
+
+		const RecordPtr* ptr = hashedColumnRecords.find(key);
+		if (!ptr)
+			throw logic_error("Primary key " + key.toString() + " is missing from the hash index of table " + tableName);
+
+		return *ptr;
+	}
+
+	void clearIndex()
+	{
+		indexedColumnRecords = BPTree();
+		hashedColumnRecords.clear();
+	}
+
+	/**
+	 * @return True if the condition is answered by the index: the B+ tree answers every comparison on the primary key,
+	 * the hash index only equality. The other conditions scan the pages.
+	*/
+	bool canUseIndex(const InternalQuery& condition) const
+	{
+		return condition.isPrimaryKeyQuery() && (indexType == IndexType::BPTREE || condition.getOperator() == Operator::EQUAL);
+	}
+
+	/**
+	 * @return pointers to the versions of the records whose keys satisfy the condition, the caller filters them by visibility
+	*/
+	vector<RecordPtr> getRecordsFromIndex(InternalQuery& condition)
+	{
+		vector<RecordPtr> res;
+		if (indexType == IndexType::BPTREE)
+		{
+			res = indexedColumnRecords.getRecordsFromQuery(condition);
+		}
+		else
+		{
+			const RecordPtr* ptr = hashedColumnRecords.find(condition.getValue());
+			if (ptr)
+				res.push_back(*ptr);
+		}
+
+		for (const data& older : olderVersions)
+			if (condition.checkValue(older.first))
+				res.push_back(older.second);
+
+		return res;
+	}
+
+	/**
+	 * @return path to the file of the Bloom filters of the page with the given index
+	*/
+	string getBloomPath(int index) const
+	{
+		return path + tableName + "_" + to_string(index) + ".bloom";
+	}
+
+	/**
+	 * @return empty Bloom filters for a page, one for every column that has them
+	*/
+	vector<BloomFilter> newBlooms() const
+	{
+		return vector<BloomFilter>(bloomColumns.size(), BloomFilter(maxRecordsPerPage));
+	}
+
+	/**
+	 * @brief Read the Bloom filters of the page with the given index, in the order of bloomColumns
+	*/
+	vector<BloomFilter> loadBlooms(int index) const
+	{
+		string bloomPath = getBloomPath(index);
+		BinaryReader in(BufferPool::getInstance().read(bloomPath));
+		if (!in.isOpen())
+			throw std::invalid_argument("Couldnt open Bloom filters at path " + bloomPath + " for reading.");
+
+		size_t count = in.readVarint();
+		if (count != bloomColumns.size())
+			throw logic_error("Page " + to_string(index) + " has " + to_string(count) + " Bloom filters, the table has " + to_string(bloomColumns.size()));
+
+		vector<BloomFilter> blooms;
+		blooms.reserve(count);
+		for (size_t i = 0; i < count; i++)
+			blooms.push_back(BloomFilter(in));
+
+		return blooms;
+	}
+
+	void saveBlooms(int index, const vector<BloomFilter>& blooms) const
+	{
+		BinaryWriter out;
+		out.writeVarint(blooms.size());
+		for (const BloomFilter& bloom : blooms)
+			bloom.write(out);
+
+		if (!BufferPool::getInstance().write(getBloomPath(index), out.release(), false))
+			throw logic_error("Couldn't open file to save Bloom filters " + getBloomPath(index));
+	}
+
+	/**
+	 * @brief Build the Bloom filters of a page from its records and save them
+	*/
+	void buildBlooms(int index, Page& p) const
+	{
+		vector<BloomFilter> blooms = newBlooms();
+		for (size_t i = 0; i < p.size(); i++)
+		{
+			const Record& r = p.get(i);
+			if (r.isInvalid())
+				continue;
+
+			for (size_t j = 0; j < bloomColumns.size(); j++)
+				if (!r.get(colIndex.at(bloomColumns[j])).isEmpty())
+					blooms[j].add(r.get(colIndex.at(bloomColumns[j])));
+		}
+
+		saveBlooms(index, blooms);
+	}
+
+	/**
+	 * @return False if the Bloom filters of the page tell that none of its records satisfies an equality condition,
+	 * True if some may or the column has no filters
+	*/
+	bool checkBloomAgainstCondition(InternalQuery& condition, int index) const
+	{
+		if (condition.getOperator() != Operator::EQUAL)
+			return true;
+
+		auto it = std::find(bloomColumns.begin(), bloomColumns.end(), condition.getColumn());
+		if (it == bloomColumns.end())
+			return true;
+
+		return loadBlooms(index)[it - bloomColumns.begin()].mayContain(condition.getValue());
+	}
+
+	/**
+	 * @brief Undo an insert of an aborted transaction. The record becomes a tombstone at once and the index points again
+	 * at the version of the key that the insert moved to olderVersions, if there was one
+	*/
+	void undoInsert(const RecordPtr& ptr)
+	{
+		Page p = loadPage(ptr.getPage());
+		Record r = p.get(ptr.getIndexInPage());
+		if (!primaryKey.empty())
+		{
+			const TypeWrapper& key = r.get(colIndex.at(primaryKey));
+			indexRemove(key);
+			auto range = std::equal_range(olderVersions.begin(), olderVersions.end(), data{ key, RecordPtr() },
+				[](const data& a, const data& b) { return a.first < b.first; });
+			if (range.first != range.second)
+			{
+				auto newestOlder = range.second - 1;
+				indexInsert(key, newestOlder->second);
+				olderVersions.erase(newestOlder);
+			}
+		}
+
+		p.reclaimRecord(ptr.getIndexInPage());
+		freeSpace.release(ptr.getPage(), 1);
+		zones.addTombstones(ptr.getPage(), 1);
+		bytes -= r.getKiloBytesData();
+		notifyChange(r, -1);
+		liveRecords--;
+	}
+
+	/**
+	 * @brief Undo a delete of an aborted transaction, its index entry was kept
+	*/
+	void undoDelete(const RecordPtr& ptr)
+	{
+		Page p = loadPage(ptr.getPage());
+		p.restoreRecord(ptr.getIndexInPage());
+		const Record& r = p.get(ptr.getIndexInPage());
+		bytes += r.getKiloBytesData();
+		notifyChange(r, 1);
+		deadVersions--;
+		liveRecords++;
+	}
+
+	/**
+	 * @brief Build the zones of all the pages by reading them, used for tables saved before the zone maps
+	*/
+	void buildZoneMap()
+	{
+		zones.clear();
+		for (int index = 0; index <= curPageIndex; index++)
+		{
+			Page p = loadPage(index);
+			zones.addPage(numOfColumns);
+			for (size_t i = 0; i < p.size(); i++)
+				zones.addRecord(index, p.get(i));
+		}
+	}
+
+	/**
+	 * @brief Used in compact(). Write the pending records as the page with the given index and point the index at them.
+	 * The deleted ones are put in olderVersions, compact() indexes those whose keys have no live version
+	*/
+	void writeCompactedPage(vector<Record>& pending, int pageIndex, int pkCol)
+	{
+		Page p(maxRecordsPerPage, getPagePath(pageIndex), columnTypes);
+		p.rewrite(pending);
+		if (!bloomColumns.empty())
+			buildBlooms(pageIndex, p);
+
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			if (pending[i].isDeleted())
+			{
+				deadVersions++;
+				if (pkCol != -1)
+					olderVersions.push_back({ pending[i].get(pkCol), RecordPtr(pageIndex, i) });
+			}
+			else if (pkCol != -1)
+				indexInsert(pending[i].get(pkCol), RecordPtr(pageIndex, i));
+		}
+
+		zones.addPage(numOfColumns);
+		for (const Record& r : pending)
+			zones.addRecord(pageIndex, r);
+
+		usedSlots += pending.size();
+		freeSpace.addPage(maxRecordsPerPage - pending.size());
+		pending.clear();
+	}
+
 	/**
 	 *	@brief Table instance controls pages that contain the stored records on the hard disk.
 	 *	All read and write operations are done in this class.
 	 */
 	long bytes;
 	int maxRecordsPerPage, curPageIndex, numOfColumns;
+	size_t deadVersions, liveRecords, usedSlots;
+	double autoVacuumRatio;
 	string path, tableName, tableHeader, primaryKey;
 	unordered_map<string, string> colTypes;
 	unordered_map<string, size_t> colIndex;
+	vector<ObjectType> columnTypes;
+	FreeSpaceMap freeSpace;
+	ZoneMap zones;
+	vector<string> bloomColumns;
+	IndexType indexType;
 	BPTree indexedColumnRecords;
+	HashIndex hashedColumnRecords;
+	/// Deleted versions of keys inserted again while a snapshot could still see them, sorted by their keys. The index points
+	/// at the newest version of every key. They are not saved: after a restart no snapshot can see them
+	vector<data> olderVersions;
+	unordered_map<string, ChangeListener> changeListeners;
+	bool savesDeferred = false, hasUnsavedChanges = false;
+	/// The pages and the Bloom filters are kept in the page file at getPageFilePath
+	bool singleFile = false;
+
+	void notifyChange(const Record& r, int sign) const
+	{
+		for (const pair<const string, ChangeListener>& listener : changeListeners)
+			listener.second(r, sign);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+#include<set>
+#include<mutex>
+#include<vector>
+#include<functional>
+#include "Snapshot.hpp"
+
+using std::multiset;
+using std::mutex;
+using std::lock_guard;
+
+/**
+ * @brief Descriptor of transaction manager singleton class. It hands out transaction ids to
+ * the writers and snapshots to the readers, and keeps track of which of them are still alive
+ * so that the vacuum knows which record versions can be reclaimed.
+*/
+class TransactionManager
+{
+public:
+	static TransactionManager& getInstance()
+	{
+		static TransactionManager inst;
+		return inst;
+	}
+
+	TransactionManager(const TransactionManager& other) = delete;
+	TransactionManager& operator=(const TransactionManager& other) = delete;
+	TransactionManager(TransactionManager&& other) = delete;
+	TransactionManager& operator=(TransactionManager&& other) = delete;
+
+	/**
+	 * @brief Start a new writing transaction
+	 * @return the id of the transaction
+	*/
+	size_t begin()
+	{
+		lock_guard<mutex> lock(fMutex);
+		size_t txnId = fNextTxnId++;
+		fInProgress.insert(txnId);
+		return txnId;
+	}
+
+	/**
+	 * @brief Mark a writing transaction as committed, making its changes visible to the snapshots taken after that
+	 * @param txnId - id of the transaction
+	*/
+	void commit(size_t txnId)
+	{
+		lock_guard<mutex> lock(fMutex);
+		fInProgress.erase(txnId);
+	}
+
+	/**
+	 * @brief End a writing transaction whose changes were undone, nobody sees them
+	 * @param txnId - id of the transaction
+	*/
+	void abort(size_t txnId)
+	{
+		lock_guard<mutex> lock(fMutex);
+		fInProgress.erase(txnId);
+	}
+
+	/**
+	 * @brief Take a snapshot of the currently committed state and register it as alive
+	 * @param ownTxn - the transaction that takes the snapshot, 0 for read-only snapshots
+	 * @return the snapshot
+	*/
+	Snapshot openSnapshot(size_t ownTxn = 0)
+	{
+		lock_guard<mutex> lock(fMutex);
+		set<size_t> running(fInProgress);
+		running.erase(ownTxn);
+
+		Snapshot snapshot(ownTxn, fNextTxnId, running);
+		fAliveSnapshots.insert(snapshot.getOldestNeeded());
+		return snapshot;
+	}
+
+	/**
+	 * @brief Unregister a snapshot once the query using it is done
+	*/
+	void closeSnapshot(const Snapshot& snapshot)
+	{
+		lock_guard<mutex> lock(fMutex);
+		auto it = fAliveSnapshots.find(snapshot.getOldestNeeded());
+		if (it != fAliveSnapshots.end())
+			fAliveSnapshots.erase(it);
+	}
+
+	/**
+	 * @return the oldest transaction id that an alive snapshot or a running transaction may still need.
+	 * Record versions deleted by a transaction older than that are not visible to anyone.
+	*/
+	size_t getVacuumHorizon() const
+	{
+		lock_guard<mutex> lock(fMutex);
+		size_t horizon = fNextTxnId;
+		if (!fInProgress.empty() && *fInProgress.begin() < horizon)
+			horizon = *fInProgress.begin();
+		if (!fAliveSnapshots.empty() && *fAliveSnapshots.begin() < horizon)
+			horizon = *fAliveSnapshots.begin();
+
+		return horizon;
+	}
+
+	size_t getNextTxnId() const
+	{
+		lock_guard<mutex> lock(fMutex);
+		return fNextTxnId;
+	}
+
+	/**
+	 * @brief Used when loading the database, so that transaction ids keep growing between sessions
+	*/
+	void setNextTxnId(size_t nextTxnId)
+	{
+		lock_guard<mutex> lock(fMutex);
+		if (nextTxnId > fNextTxnId)
+			fNextTxnId = nextTxnId;
+	}
+
+private:
+	TransactionManager() : fNextTxnId(1) {}
+
+	mutable mutex fMutex;
+	size_t fNextTxnId;
+	set<size_t> fInProgress;
+	multiset<size_t> fAliveSnapshots;
+};
+
+/**
+ * @brief Keeps a read-only snapshot alive for the duration of a query
+*/
+class SnapshotGuard
+{
+public:
+	SnapshotGuard() : fSnapshot(TransactionManager::getInstance().openSnapshot()) {}
+
+	~SnapshotGuard() { TransactionManager::getInstance().closeSnapshot(fSnapshot); }
+
+	SnapshotGuard(const SnapshotGuard& other) = delete;
+	SnapshotGuard& operator=(const SnapshotGuard& other) = delete;
+
+	const Snapshot& get() const { return fSnapshot; }
+
+private:
+	Snapshot fSnapshot;
+};
+
+/**
+ * @brief A writing transaction spanning one statement. Its changes become visible to
+ * other snapshots once it is committed. A transaction that goes out of scope without
+ * being committed, i.e. its statement threw, is aborted and its changes are undone.
+*/
+class Transaction
+{
+public:
+	Transaction() : fId(TransactionManager::getInstance().begin()), fSnapshot(TransactionManager::getInstance().openSnapshot(fId)), fCommitted(false) {}
+
+	~Transaction()
+	{
+		TransactionManager::getInstance().closeSnapshot(fSnapshot);
+		if (fCommitted)
+			return;
+
+		// A destructor must not throw, a change whose undo fails stays like a crash would leave it
+		for (auto it = fUndo.rbegin(); it != fUndo.rend(); ++it)
+		{
+			try
+			{
+				(*it)();
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+
+		TransactionManager::getInstance().abort(fId);
+	}
+
+	Transaction(const Transaction& other) = delete;
+	Transaction& operator=(const Transaction& other) = delete;
+
+	/**
+	 * @brief Make the changes of the transaction visible to the snapshots taken after that
+	*/
+	void commit()
+	{
+		if (fCommitted)
+			return;
+
+		fCommitted = true;
+		fUndo.clear();
+		TransactionManager::getInstance().commit(fId);
+	}
+
+	/**
+	 * @brief Register how to undo a change of the transaction, the changes are undone in reverse order if it is aborted
+	*/
+	void onAbort(std::function<void()> undo) { fUndo.push_back(std::move(undo)); }
+
+	size_t getId() const { return fId; }
+
+	const Snapshot& getSnapshot() const { return fSnapshot; }
+
+private:
+	size_t fId;
+	Snapshot fSnapshot;
+	bool fCommitted;
+	std::vector<std::function<void()>> fUndo;
+};
@@ -1,149 +1,314 @@
 #pragma once
 #include<string>
-#include "IntegerObject.hpp"
-#include "StringObject.hpp"
-#include "DoubleObject.hpp"
+#include<string_view>
+#include<cstring>
+#include<cmath>
+#include<limits>
+#include<cstdint>
+#include "ObjectType.h"
+#include "StringPool.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
 
 using std::string;
+using std::string_view;
+using std::to_string;
 
+/**
+ * @brief Holds the value of one cell in 16 bytes: 14 bytes of data, the length of an inline string and the type of the value.
+ * Ints, doubles and strings of up to 14 characters are stored in the data bytes directly, longer strings are
+ * interned in the StringPool and only their address is kept. Copying a cell never allocates, a cell holding a long string
+ * counts one more reference to it and releases it when destroyed.
+*/
 class TypeWrapper
 {
 public:
 	/// Object lifetime
-	TypeWrapper() :fContent(nullptr) {}
+	TypeWrapper() : fData{}, fLength(0), fType((unsigned char)ObjectType::NONE) {}
 
-	TypeWrapper(ifstream& in)
+	TypeWrapper(BinaryReader& in) : TypeWrapper()
 	{
-		ObjectType t = ObjectType::INT;
-		in.read((char*)&t, sizeof(t));
+		ObjectType t = ObjectType::NONE;
+		in.read(t);
 
 		if (t == ObjectType::INT) {
 			int value = 0;
-			in.read((char*)&value, sizeof(value));
-			fContent = new IntegerObject(value);
+			in.read(value);
+			setValue(ObjectType::INT, value);
 		}
 		else if (t == ObjectType::STRING) {
-			string value;
-			fh::readString(in, value);
-			fContent = new StringObject(value);
+			size_t size = 0;
+			in.read(size);
+			setString(in.readBytes(size), size);
 		}
 		else if (t == ObjectType::DOUBLE)
 		{
 			double value = 0;
-			in.read((char*)&value, sizeof(value));
-			fContent = new DoubleObject(value);
+			in.read(value);
+			setValue(ObjectType::DOUBLE, value);
 		}
-		else
+	}
+
+	TypeWrapper(const std::string& content) : TypeWrapper() { setString(content.data(), content.size()); }
+
+	TypeWrapper(int content) : TypeWrapper() { setValue(ObjectType::INT, content); }
+
+	TypeWrapper(double content) : TypeWrapper() { setValue(ObjectType::DOUBLE, content); }
+
+	TypeWrapper(const TypeWrapper& other) : fLength(other.fLength), fType(other.fType)
+	{
+		std::memcpy(fData, other.fData, INLINE_CAPACITY);
+		if (isInterned())
+			StringPool::getInstance().retain(getInterned());
+	}
+
+	/// The moved cell is left empty, so the reference to a long string moves with the value
+	TypeWrapper(TypeWrapper&& other) noexcept : fLength(other.fLength), fType(other.fType)
+	{
+		std::memcpy(fData, other.fData, INLINE_CAPACITY);
+		other.fLength = 0;
+		other.fType = (unsigned char)ObjectType::NONE;
+	}
+
+	TypeWrapper& operator=(const TypeWrapper& other)
+	{
+		if (this != &other)
 		{
-			fContent = nullptr;
+			TypeWrapper copy(other);
+			*this = std::move(copy);
 		}
+
+		return *this;
 	}
 
-	TypeWrapper(const std::string& content) :fContent(new StringObject(content)) {}
+	TypeWrapper& operator=(TypeWrapper&& other) noexcept
+	{
+		if (this != &other)
+		{
+			releaseInterned();
+			std::memcpy(fData, other.fData, INLINE_CAPACITY);
+			fLength = other.fLength;
+			fType = other.fType;
+			other.fLength = 0;
+			other.fType = (unsigned char)ObjectType::NONE;
+		}
 
-	TypeWrapper(int content) :fContent(new IntegerObject(content)) {}
+		return *this;
+	}
 
-	TypeWrapper(double content) :fContent(new DoubleObject(content)) {}
+	~TypeWrapper() { releaseInterned(); }
 
 	/**
-	*	@brief Copy constructor
-	*
-	*	@param other - TypeWrapper object from which copying will be made
+	 * @brief Make a string cell without building a std::string first
 	*/
-	TypeWrapper(const TypeWrapper& other)
+	static TypeWrapper fromString(string_view content)
 	{
-		copyFrom(other);
+		TypeWrapper res;
+		res.setString(content.data(), content.size());
+		return res;
 	}
 
 	/**
-	*	@brief Copy assignment operator
-	*
-	*	@param other - TypeWrapper object from which copying will be made
-	*	@returns *this
+	 * @return the type of the value, ObjectType::NONE if the cell is empty
 	*/
-	TypeWrapper& operator=(const TypeWrapper& other)
+	ObjectType getType() const { return (ObjectType)fType; }
+
+	bool isEmpty() const { return getType() == ObjectType::NONE; }
+
+	int getInt() const { return getValue<int>(); }
+
+	double getDouble() const { return getValue<double>(); }
+
+	/**
+	 * @return view of the string value, valid as long as the cell is
+	*/
+	string_view getString() const
 	{
-		if (this != &other)
+		if (isInterned())
+			return getInterned()->value;
+
+		return string_view(fData, fLength);
+	}
+
+	string toString() const
+	{
+		switch (getType())
 		{
-			delete fContent;
-			copyFrom(other);
+		case ObjectType::INT: return to_string(getInt());
+		case ObjectType::DOUBLE: return to_string(getDouble());
+		case ObjectType::STRING: return string(getString());
+		default: return "";
 		}
-		return *this;
 	}
 
 	/**
-	*	@brief Move constructor
-	*
-	*	@param other - Cell object from which moving will be made
+	 * @return number of characters needed to display the value
 	*/
-	TypeWrapper(TypeWrapper&& other) noexcept : TypeWrapper()
+	size_t size() const
 	{
-		moveFrom(other);
+		return getType() == ObjectType::STRING ? getString().size() : toString().size();
 	}
 
 	/**
-	*	@brief Move assignment operator
-	*
-	*	@param other - Cell object from which moving will be made
+	 * @return number of bytes the value takes in a page
 	*/
-	TypeWrapper& operator=(TypeWrapper&& other) noexcept
+	size_t memsize() const
 	{
-		if (this != &other)
+		switch (getType())
 		{
-			moveFrom(other);
+		case ObjectType::INT: return sizeof(int);
+		case ObjectType::DOUBLE: return sizeof(double);
+		case ObjectType::STRING: return getString().size();
+		default: return 0;
 		}
+	}
 
-		return *this;
+	/**
+	 * @brief Used for writing the value to a file
+	 * @param out - the buffer of the file
+	*/
+	void write(BinaryWriter& out) const
+	{
+		ObjectType t = getType();
+		out.write(t);
+
+		if (t == ObjectType::INT || t == ObjectType::DOUBLE)
+			out.writeBytes(fData, t == ObjectType::INT ? sizeof(int) : sizeof(double));
+		else if (t == ObjectType::STRING)
+			out.writeString(getString());
 	}
 
 	/**
-	 * @brief Getter
-	 *
-	 * @return the content behind the pointer(IntegerType/DoubleType/FormulaType/StringType)
+	 * @brief FNV-1a over the type and the bytes of the value. It doesn't depend on the standard library,
+	 * so the hashes stored by one build are valid in another. Equal ints and strings have equal hashes, doubles
+	 * are compared with an epsilon, so two equal doubles may not
 	*/
-	Object* getContent() const
+	uint64_t hash() const
 	{
-		return fContent;
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](const char* bytes, size_t size) {
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= (unsigned char)bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		mix((const char*)&fType, 1);
+		if (getType() == ObjectType::STRING)
+		{
+			string_view content = getString();
+			mix(content.data(), content.size());
+		}
+		else if (getType() == ObjectType::INT || getType() == ObjectType::DOUBLE)
+		{
+			mix(fData, getType() == ObjectType::INT ? sizeof(int) : sizeof(double));
+		}
+
+		// FNV leaves the low bits weak for short keys, spread them over the whole word
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		return hash;
 	}
 
-	~TypeWrapper()
+	/// Values of different types are neither equal nor ordered
+	bool operator==(const TypeWrapper& other) const
 	{
-		delete fContent;
+		if (fType != other.fType)
+			return false;
+
+		switch (getType())
+		{
+		case ObjectType::INT: return getInt() == other.getInt();
+		case ObjectType::DOUBLE: return std::fabs(getDouble() - other.getDouble()) < std::numeric_limits<double>::epsilon();
+		case ObjectType::STRING:
+			if (fLength != other.fLength)
+				return false;
+			return isInterned() ? getInterned() == other.getInterned() : std::memcmp(fData, other.fData, fLength) == 0;
+		default: return true;
+		}
 	}
 
-public:
+	bool operator<(const TypeWrapper& other) const
+	{
+		if (fType != other.fType)
+			return false;
 
-	string toString() const { return fContent->toString(); }
+		switch (getType())
+		{
+		case ObjectType::INT: return getInt() < other.getInt();
+		case ObjectType::DOUBLE:
+		{
+			double a = getDouble(), b = other.getDouble();
+			return (b - a) > std::fmax(std::fabs(a), std::fabs(b)) * std::numeric_limits<double>::epsilon();
+		}
+		case ObjectType::STRING: return getString() < other.getString();
+		default: return false;
+		}
+	}
 
-	/**
-	 * @brief Used for writing information of fContent to a file
-	 * @param out - output stream
-	*/
-	void write(ofstream& out) const
+	bool operator>(const TypeWrapper& other) const { return other < *this; }
+	bool operator<=(const TypeWrapper& other) const { return *this < other || *this == other; }
+	bool operator>=(const TypeWrapper& other) const { return *this > other || *this == other; }
+	bool operator!=(const TypeWrapper& other) const { return *this < other || *this > other; }
+
+private:
+	static const size_t INLINE_CAPACITY = 14;
+	static const unsigned char INTERNED = 0xFF;
+
+	alignas(8) char fData[INLINE_CAPACITY];
+	unsigned char fLength;
+	unsigned char fType;
+
+	template<typename T>
+	void setValue(ObjectType type, T value)
 	{
-		fContent->write(out);
+		fType = (unsigned char)type;
+		std::memcpy(fData, &value, sizeof(value));
 	}
 
-	bool operator>(const TypeWrapper& other) const { return fContent->operator>(*other.fContent); }
-	bool operator==(const TypeWrapper& other) const { return fContent->operator==(*other.fContent); }
-	bool operator<(const TypeWrapper& other) const { return fContent->operator<(*other.fContent); }
-	bool operator<=(const TypeWrapper& other) const { return (fContent->operator<(*other.fContent) || fContent->operator==(*other.fContent)); }
-	bool operator>=(const TypeWrapper& other) const { return (fContent->operator<(*other.fContent) || fContent->operator==(*other.fContent)); }
-	bool operator!=(const TypeWrapper& other) const { return (fContent->operator<(*other.fContent) || fContent->operator>(*other.fContent)); }
+	template<typename T>
+	T getValue() const
+	{
+		T value;
+		std::memcpy(&value, fData, sizeof(value));
+		return value;
+	}
 
+	bool isInterned() const { return fLength == INTERNED; }
 
-private:
-	Object* fContent;
+	void setInterned(const StringPool::Entry* value)
+	{
+		fLength = INTERNED;
+		std::memcpy(fData, &value, sizeof(value));
+	}
+
+	const StringPool::Entry* getInterned() const { return getValue<const StringPool::Entry*>(); }
 
-	void copyFrom(const TypeWrapper& other)
+	void releaseInterned()
 	{
-		if (other.fContent != nullptr)
-			fContent = other.fContent->clone();
-		else
-			fContent = nullptr;
+		if (isInterned())
+			StringPool::getInstance().release(getInterned());
 	}
 
-	void moveFrom(TypeWrapper& other) {
-		std::swap(fContent, other.fContent);
+	/**
+	 * @brief Store a string value, short strings are copied straight into the cell
+	 * @param bytes - the characters of the string
+	 * @param size - length of the string
+	*/
+	void setString(const char* bytes, size_t size)
+	{
+		fType = (unsigned char)ObjectType::STRING;
+		if (size <= INLINE_CAPACITY)
+		{
+			std::memcpy(fData, bytes, size);
+			fLength = (unsigned char)size;
+			return;
+		}
+
+		setInterned(StringPool::getInstance().intern(string_view(bytes, size)));
 	}
-};
\ No newline at end of file
+};
+
+static_assert(sizeof(TypeWrapper) == 16, "TypeWrapper must fit in 16 bytes");
\ No newline at end of file
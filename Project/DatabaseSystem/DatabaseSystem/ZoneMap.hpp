@@ -0,0 +1,148 @@
+#pragma once
+#include<vector>
+#include "Record.hpp"
+#include "BinaryReader.hpp"
+#include "BinaryWriter.hpp"
+
+using std::vector;
+
+/**
+ * @brief Descriptor of the zone map of a table. For every page it keeps the smallest and the biggest value of every column
+ * and how many of the page's slots are tombstones left by the vacuum. A query can then skip the pages whose ranges
+ * cannot hold a matching value without reading them.
+ * The ranges only grow: a deleted record may still be seen by an older snapshot, so it keeps its place in the range
+ * until the table is compacted and the zone of the page is built again.
+*/
+class ZoneMap
+{
+public:
+	ZoneMap() {}
+
+	ZoneMap(BinaryReader& in)
+	{
+		size_t pages = 0;
+		in.read(pages);
+		fZones.resize(pages);
+		for (Zone& zone : fZones)
+		{
+			in.read(zone.slots);
+			in.read(zone.tombstones);
+
+			size_t columns = 0;
+			in.read(columns);
+			for (size_t col = 0; col < columns; col++)
+			{
+				zone.min.push_back(TypeWrapper(in));
+				zone.max.push_back(TypeWrapper(in));
+			}
+		}
+	}
+
+	/**
+	 * @brief Write the zones of every page to file
+	 * @param out - the buffer of the file
+	*/
+	void write(BinaryWriter& out) const
+	{
+		size_t pages = fZones.size();
+		out.write(pages);
+		for (const Zone& zone : fZones)
+		{
+			out.write(zone.slots);
+			out.write(zone.tombstones);
+
+			size_t columns = zone.min.size();
+			out.write(columns);
+			for (size_t col = 0; col < columns; col++)
+			{
+				zone.min[col].write(out);
+				zone.max[col].write(out);
+			}
+		}
+	}
+
+	/**
+	 * @brief Register a new empty page at the end of the table
+	 * @param columns - number of columns in the table
+	*/
+	void addPage(size_t columns)
+	{
+		Zone zone;
+		zone.min.resize(columns);
+		zone.max.resize(columns);
+		fZones.push_back(std::move(zone));
+	}
+
+	/**
+	 * @brief Called after a record is placed in the page, widens the ranges of the page with its values
+	 * @param intoTombstone - True if the record took the slot of a tombstone instead of a new one
+	*/
+	void addRecord(size_t page, const Record& record, bool intoTombstone = false)
+	{
+		Zone& zone = fZones[page];
+		if (intoTombstone)
+			zone.tombstones--;
+		else
+			zone.slots++;
+
+		if (record.isInvalid())
+		{
+			zone.tombstones++;
+			return;
+		}
+
+		for (size_t col = 0; col < zone.min.size(); col++)
+		{
+			const TypeWrapper& value = record.get(col);
+			if (value.isEmpty())
+				continue;
+
+			if (zone.min[col].isEmpty() || value < zone.min[col])
+				zone.min[col] = value;
+			if (zone.max[col].isEmpty() || value > zone.max[col])
+				zone.max[col] = value;
+		}
+	}
+
+	/**
+	 * @brief Called when the vacuum turns records of the page into tombstones
+	 * @param count - number of new tombstones
+	*/
+	void addTombstones(size_t page, size_t count)
+	{
+		fZones[page].tombstones += count;
+	}
+
+	/**
+	 * @return False if every slot of the page is a tombstone, so no snapshot can see anything in it
+	*/
+	bool hasRecords(size_t page) const
+	{
+		return fZones[page].slots > fZones[page].tombstones;
+	}
+
+	/**
+	 * @return the smallest value of the column in the page, an empty one if the column has no values there
+	*/
+	const TypeWrapper& getMin(size_t page, size_t col) const { return fZones[page].min[col]; }
+
+	/**
+	 * @return the biggest value of the column in the page, an empty one if the column has no values there
+	*/
+	const TypeWrapper& getMax(size_t page, size_t col) const { return fZones[page].max[col]; }
+
+	size_t size() const { return fZones.size(); }
+
+	void clear() { fZones.clear(); }
+
+private:
+	struct Zone
+	{
+		size_t slots = 0;
+		size_t tombstones = 0;
+		vector<TypeWrapper> min;
+		vector<TypeWrapper> max;
+	};
+
+	vector<Zone> fZones;
+};
\ No newline at end of file
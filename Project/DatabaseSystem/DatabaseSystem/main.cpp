@@ -1,8 +1,49 @@
 #include "Engine.h"
 #include "BPTree.hpp"
+#include "LoadGenerator.hpp"
 
-int main()
+/**
+ * @brief Read a positive count given on the command line
+ * @return False if the argument isn't a positive number
+*/
+static bool readCount(const string& argument, size_t& count)
 {
+	if (argument.empty() || argument.size() > 9 || !std::all_of(argument.begin(), argument.end(), [](char c) { return isdigit((unsigned char)c); }))
+		return false;
+
+	count = std::stoul(argument);
+	return count > 0;
+}
+
+int main(int argc, char* argv[])
+{
+	// --batch {file} runs a script instead of the console
+	if (argc == 3 && string(argv[1]) == "--batch")
+		return Engine::getInstance().runBatch(argv[2]) ? 0 : 1;
+	// --recover checks the pages against their checksums, --recover repair also repairs the damaged tables
+	if (argc >= 2 && argc <= 3 && string(argv[1]) == "--recover")
+		return Engine::getInstance().runRecovery(argc == 3 && string(argv[2]) == "repair") ? 0 : 1;
+
+#ifdef __linux__
+	// --server {socket} shares the database with other processes, --connect {socket} is a console for such a server
+	if (argc == 3 && string(argv[1]) == "--server")
+		return Engine::getInstance().runServer(argv[2]) ? 0 : 1;
+	if (argc == 3 && string(argv[1]) == "--connect")
+		return Engine::getInstance().runClient(argv[2]) ? 0 : 1;
+	// --load {socket} {sessions} {statements} {statement} measures a server
+	if (argc == 6 && string(argv[1]) == "--load")
+	{
+		size_t sessions = 0, statements = 0;
+		if (!readCount(argv[3], sessions) || !readCount(argv[4], statements))
+		{
+			cout << red << "Usage: --load {socket} {sessions} {statements} {statement}, the sessions and the statements are positive numbers." << reset << endl;
+			return 1;
+		}
+
+		return LoadGenerator(argv[2], sessions, statements).run(argv[5]) ? 0 : 1;
+	}
+#endif
+
 	Engine::getInstance().run();
 	return 0;
 }
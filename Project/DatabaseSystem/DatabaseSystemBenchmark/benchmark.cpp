@@ -0,0 +1,140 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "../DatabaseSystem/Query.hpp"
+#include "../DatabaseSystem/Page.hpp"
+#include "../DatabaseSystem/SortingHelper.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Micro benchmark of the per-row work done by the engine: copying records out of a page,
+ * checking them against WHERE conditions, ordering them by a column and writing them to pages and reading them back.
+ * Prints the throughput of every step in rows per second.
+*/
+
+const size_t ROWS = 200000;
+const int REPEATS = 5;
+const size_t ROWS_PER_PAGE = 1000;
+
+/// Results are stored here, so the compiler cannot drop the measured work
+volatile size_t sink = 0;
+
+vector<Record> generateRecords()
+{
+	const char* names[] = { "\"Sofia\"", "\"Plovdiv\"", "\"Varna\"", "\"Veliko Tarnovo - old capital\"" };
+	vector<Record> rows;
+	rows.reserve(ROWS);
+	for (size_t i = 0; i < ROWS; i++)
+	{
+		Record r(3);
+		r.addValue(TypeWrapper((int)((i * 7919) % ROWS)));
+		r.addValue(TypeWrapper(string(names[i % 4])));
+		r.addValue(TypeWrapper(i * 0.5));
+		rows.push_back(r);
+	}
+
+	return rows;
+}
+
+template<typename F>
+void measure(const string& name, F step)
+{
+	double best = 0;
+	for (int i = 0; i < REPEATS; i++)
+	{
+		Clock::time_point start = Clock::now();
+		size_t rows = step();
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		double rowsPerSecond = rows / seconds;
+		if (rowsPerSecond > best)
+			best = rowsPerSecond;
+	}
+
+	cout << name << ": " << (size_t)(best / 1000) << "k rows/s" << endl;
+}
+
+int main()
+{
+	vector<Record> rows = generateRecords();
+	unordered_map<string, size_t> colIndex = { {"ID", 0}, {"City", 1}, {"Value", 2} };
+
+	measure("copy", [&]() {
+		Arena arena;
+		ArenaScope scope(arena);
+		vector<Record> copies;
+		copies.reserve(rows.size());
+		for (const Record& r : rows)
+			copies.push_back(r);
+
+		return copies.size();
+		});
+
+	InternalQuery byInt("ID", TypeWrapper((int)(ROWS / 2)), "<", "");
+	InternalQuery byString("City", TypeWrapper(string("\"Varna\"")), "=", "");
+	InternalQuery byDouble("Value", TypeWrapper(1000.0), ">=", "");
+	measure("scan", [&]() {
+		size_t matches = 0;
+		for (const Record& r : rows)
+		{
+			matches += byInt.checkRecordAgainstCondition(colIndex, r);
+			matches += byString.checkRecordAgainstCondition(colIndex, r);
+			matches += byDouble.checkRecordAgainstCondition(colIndex, r);
+		}
+
+		sink = matches;
+		return rows.size();
+		});
+
+	unordered_map<string, string> colTypes = { {"ID", "Integer"}, {"City", "String"}, {"Value", "Double"} };
+	Query where("ID < " + std::to_string(ROWS / 2) + " AND ( City = \"Varna\" OR Value >= 1000.0 )", colTypes, "");
+	vector<Query::Step> steps = where.resolve(colIndex);
+	measure("where", [&]() {
+		size_t matches = 0;
+		for (const Record& r : rows)
+			matches += where.checkRecordAgainstQuery(r, steps);
+
+		sink = matches;
+		return rows.size();
+		});
+
+	measure("order by", [&]() {
+		Arena arena;
+		ArenaScope scope(arena);
+		vector<Record> copies(rows.begin(), rows.end());
+		heapSort(copies, 0);
+		return copies.size();
+		});
+
+	string path = "benchmark_page.bin";
+	vector<ObjectType> columnTypes = { ObjectType::INT, ObjectType::STRING, ObjectType::DOUBLE };
+	measure("write + read", [&]() {
+		Arena arena;
+		ArenaScope scope(arena);
+		size_t read = 0;
+		for (size_t first = 0; first < rows.size(); first += ROWS_PER_PAGE)
+		{
+			vector<Record> chunk(rows.begin() + first, rows.begin() + std::min(first + ROWS_PER_PAGE, rows.size()));
+			Page page(ROWS_PER_PAGE, path, columnTypes);
+			page.rewrite(chunk);
+
+			// Read the page from the disk, not the copy the buffer pool kept when it was written
+			BufferPool::getInstance().forget(path);
+			BinaryReader in(BufferPool::getInstance().read(path));
+			Page loaded(in, columnTypes);
+			read += loaded.size();
+		}
+
+		return read;
+		});
+	cout << "page size: " << std::filesystem::file_size(path) / ROWS_PER_PAGE << " bytes per row" << endl;
+	std::filesystem::remove(path);
+
+	return 0;
+}
\ No newline at end of file